@@ -0,0 +1,129 @@
+#ifndef COMMON_FORKSERVER_H
+#define COMMON_FORKSERVER_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    What afl_jig and a target's forkserver agree on beyond AFL's protocol. This header is meant to be
+    included by the target's runtime as well, so it only depends on the C library.
+
+    A plain AFL forkserver sends four zero bytes as its hello. A forkserver that can do more sets
+    FS_OPT_ENABLED in its hello along with the options it offers, and then reads a four byte reply
+    with FS_OPT_ENABLED and the options afl_jig accepted, before it waits for the first run. A hello
+    without FS_OPT_ENABLED gets no reply, so targets built for AFL keep working unchanged.
+*/
+
+#define FS_OPT_ENABLED 0x80000001     // the hello offers options and expects a reply
+#define FS_OPT_CMPLOG 0x04000000      // the target can log its comparisons to the cmplog_map
+#define FS_OPT_BATCH 0x02000000       // the target can run every input of the fuzz_batch in one child
+#define FS_OPT_SHDMEM_FUZZ 0x01000000 // the target can read its input from the fuzz_shm
+
+/*
+    The comparison log. afl_jig maps it in a second shared memory region, whose ID it passes in
+    CMPLOG_SHM_ENV_VAR, and sets enabled only for the runs whose comparisons it wants, so a target
+    that accepted FS_OPT_CMPLOG pays for one branch per comparison the rest of the time.
+    cmplog_add is meant to be called from the target's comparison hooks, such as the
+    __sanitizer_cov_trace_cmp functions of -fsanitize-coverage=trace-cmp.
+*/
+
+#define CMPLOG_SHM_ENV_VAR "__GTFO_CMPLOG_SHM_ID"
+#define CMPLOG_ENTRIES 1024
+
+typedef struct cmplog_entry {
+	// the operands, zero extended.
+	uint64_t op0;
+	uint64_t op1;
+	// width of the operands in bytes, 1, 2, 4 or 8.
+	uint32_t size;
+	uint32_t pad;
+} cmplog_entry;
+
+typedef struct cmplog_map {
+	// whether the target should log its comparisons, set by the jig before a run.
+	volatile uint32_t enabled;
+	// number of comparisons the run made, only the first CMPLOG_ENTRIES of them are logged.
+	uint32_t     count;
+	cmplog_entry entries[CMPLOG_ENTRIES];
+} cmplog_map;
+
+// log a comparison, unless logging is off or the log is full
+static inline void
+cmplog_add(cmplog_map *map, uint64_t op0, uint64_t op1, uint32_t size)
+{
+	if (map == NULL || !map->enabled || map->count >= CMPLOG_ENTRIES) {
+		return;
+	}
+	uint32_t i = __atomic_fetch_add(&map->count, 1, __ATOMIC_RELAXED);
+	if (i < CMPLOG_ENTRIES) {
+		map->entries[i].op0  = op0;
+		map->entries[i].op1  = op1;
+		map->entries[i].size = size;
+	}
+}
+
+/*
+    The input channel. afl_jig maps a third shared memory region, whose ID it passes in FUZZ_SHM_ENV_VAR,
+    and a target that accepted FS_OPT_SHDMEM_FUZZ reads each input from it in place instead of from the
+    fuzzfile, so delivering an input takes no system calls on either side. It holds inputs of up to
+    FUZZ_SHM_MAX_INPUT bytes, and isn't offered when JIG_MAX_INPUT says the inputs can be longer.
+*/
+
+#define FUZZ_SHM_ENV_VAR "__GTFO_SHM_FUZZ_ID"
+#define FUZZ_SHM_MAX_INPUT (1024 * 1024)
+
+typedef struct fuzz_shm {
+	// size of the input in bytes, written by the jig before each run.
+	uint32_t size;
+	uint8_t  data[FUZZ_SHM_MAX_INPUT];
+} fuzz_shm;
+
+/*
+    Batches. afl_jig maps a fourth region, whose ID it passes in BATCH_SHM_ENV_VAR, and for a target that
+    accepted FS_OPT_BATCH, it can write several inputs there and set FS_BATCH_RUN in the run request. The
+    forkserver then forks one child, which runs the inputs in order, copies the trace after each one to
+    fuzz_batch_results and clears it, and counts it in done. The forkserver reports the child's pid and status
+    once for the whole batch, so a batch costs one round trip instead of one per input. If the child crashes
+    or hangs, done tells which input did it, and the inputs after it aren't run.
+*/
+
+#define BATCH_SHM_ENV_VAR "__GTFO_SHM_BATCH_ID"
+#define FS_BATCH_RUN 0x80000000
+#define BATCH_MAX_INPUTS 64
+#define BATCH_MAX_DATA (1024 * 1024)
+
+typedef struct fuzz_batch {
+	// inputs in the batch, written by the jig.
+	uint32_t count;
+	// inputs the child has run, written by the target after each one.
+	volatile uint32_t done;
+	// size of each input's trace, written by the jig once.
+	uint32_t map_size;
+	uint32_t pad;
+	// where each input starts in data, and its size.
+	uint32_t offsets[BATCH_MAX_INPUTS];
+	uint32_t sizes[BATCH_MAX_INPUTS];
+	uint8_t  data[BATCH_MAX_DATA];
+	// followed by BATCH_MAX_INPUTS traces of map_size bytes, see fuzz_batch_results.
+} fuzz_batch;
+
+// where the target copies the trace of the batch's i'th input
+static inline uint8_t *
+fuzz_batch_results(fuzz_batch *batch, uint32_t i)
+{
+	return (uint8_t *)(batch + 1) + (size_t)i * batch->map_size;
+}
+
+#endif
@@ -24,6 +24,11 @@
 #include <stdlib.h>
 #include <string.h>
 #define VERSION_ONE 1
+#define VERSION_TWO 2
+#define VERSION_THREE 3
+
+// The most bytes a mutation_delta can save.
+#define MUTATION_DELTA_MAX 8
 
 // This is the standard strategy state object, used by every strategy to maintain state information.
 // strategies/src/strategy.c contains methods that operate on a strategy_state.
@@ -42,6 +47,51 @@ typedef struct strategy_state {
 	void *internal_state;
 } strategy_state;
 
+// How to undo a mutation.
+typedef enum mutation_delta_op {
+	// the mutation could not be described, restore the whole input.
+	DELTA_FULL,
+	// the mutation overwrote bytes in place, restore the saved bytes.
+	DELTA_OVERWRITE,
+} mutation_delta_op;
+
+// A record of what a mutation changed, so that the caller can undo it without copying the whole input.
+typedef struct mutation_delta {
+	// how to undo the mutation.
+	mutation_delta_op op;
+	// offset of the first byte changed.
+	size_t offset;
+	// number of bytes saved.
+	size_t length;
+	// the bytes at offset before the mutation.
+	u8 saved[MUTATION_DELTA_MAX];
+} mutation_delta;
+
+// What running a mutated input found, reported back to the strategy that mutated it.
+typedef struct strategy_feedback {
+	// the state's iteration when the input was mutated. feedback arrives in the order inputs were mutated,
+	// but may arrive after the next input has been mutated.
+	u64 iteration;
+	// whether the input is the clean input, run unmodified before the strategy mutates it.
+	bool clean;
+	// whether the input added coverage.
+	bool is_new;
+	// whether the input crashed or timed out.
+	bool interesting;
+	// how long the input took to run, in microseconds.
+	u32 exec_us;
+	// the mutated input.
+	u8    *input;
+	size_t size;
+	// the results of running the input, only valid during the call.
+	u8    *results;
+	size_t results_size;
+	// the comparisons the target made, a cmplog_map from common/forkserver.h, only valid during the call.
+	// Only the clean input's are logged, and only if the jig and the target can, otherwise they are NULL.
+	u8    *comparisons;
+	size_t comparisons_size;
+} strategy_feedback;
+
 typedef strategy_state *(create_state)(u8 *seed, size_t max_size, ...);
 typedef size_t(fuzz_function)(u8 *buffer, size_t size, strategy_state *state);
 typedef char *(serialize_state)(strategy_state *state);
@@ -50,6 +100,8 @@ typedef char *(print_state)(strategy_state *state);
 typedef strategy_state *(copy_state)(strategy_state *state);
 typedef void(free_state)(strategy_state *state);
 typedef void(update_state)(strategy_state *state);
+typedef size_t(fuzz_delta_function)(u8 *buffer, size_t size, strategy_state *state, mutation_delta *delta);
+typedef void(feedback_function)(strategy_state *state, strategy_feedback *feedback);
 
 // This structure represents a fuzzing strategy.
 // It provides a uniform API for each strategy library.
@@ -87,10 +139,31 @@ typedef struct fuzzing_strategy {
 
 			// A description of the fuzzing strategy
 			const char *description;
+
+			// version two
+			// Function to perform the same mutation as mutate, also recording how to undo it.
+			fuzz_delta_function *mutate_delta;
+
+			// version three
+			// Function to learn from running an input mutate made, may be NULL.
+			feedback_function *report_feedback;
 		};
 	};
 } fuzzing_strategy;
 
+// Undo a mutation described by delta, given the input from before the mutation.
+// Returns the size of the restored input.
+static inline size_t
+mutation_delta_revert(u8 *buffer, u8 *clean, size_t clean_size, mutation_delta *delta)
+{
+	if (delta->op == DELTA_OVERWRITE) {
+		memcpy(buffer + delta->offset, delta->saved, delta->length);
+	} else {
+		memcpy(buffer, clean, clean_size);
+	}
+	return clean_size;
+}
+
 typedef void (*get_fuzzing_strategy_function)(fuzzing_strategy *strategy);
 
 // For a given strategy library, this function pointer points to the function that populates the fuzzing_strategy object.
@@ -21,6 +21,7 @@
 #include "det_four_byte_arith_le.h"
 #include "det_two_byte_arith_be.h"
 #include "det_two_byte_arith_le.h"
+#include "effector.h"
 #include "ooze.h"
 
 typedef struct afl_arith_substates {
@@ -41,6 +42,8 @@ typedef struct afl_arith_substates {
 	fuzzing_strategy *det_two_byte_arith_be_strategy;
 	fuzzing_strategy *det_four_byte_arith_le_strategy;
 	fuzzing_strategy *det_four_byte_arith_be_strategy;
+	// which bytes afl_bit_flip found to change the path, loaded on the first mutation
+	effector_map *effector;
 
 } afl_arith_substates;
 
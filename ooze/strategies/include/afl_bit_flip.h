@@ -15,6 +15,7 @@
 
 #pragma once
 #include "afl.h"
+#include "auto_dict.h"
 #include "common/types.h"
 #include "det_bit_flip.h"
 #include "det_byte_flip.h"
@@ -22,6 +23,7 @@
 #include "det_four_byte_flip.h"
 #include "det_two_bit_flip.h"
 #include "det_two_byte_flip.h"
+#include "effector.h"
 #include "ooze.h"
 
 typedef struct afl_bit_flip_substates {
@@ -44,6 +46,10 @@ typedef struct afl_bit_flip_substates {
 	fuzzing_strategy *det_byte_flip_strategy;
 	fuzzing_strategy *det_two_byte_flip_strategy;
 	fuzzing_strategy *det_four_byte_flip_strategy;
+	// which bytes the byte flips found to change the path
+	effector_map *effector;
+	// the run of bytes the byte flips are collecting into an auto dictionary token
+	auto_dict_collector *auto_dict;
 
 } afl_bit_flip_substates;
 
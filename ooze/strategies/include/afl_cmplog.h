@@ -0,0 +1,38 @@
+#ifndef AFL_CMPLOG_H
+#define AFL_CMPLOG_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+#pragma once
+#include "common/forkserver.h"
+#include "common/types.h"
+#include "ooze.h"
+
+/*
+    Input-to-state substitution, like RedQueen and AFL++'s cmplog.
+
+    When the target compares a value read from the input with another value, one operand usually appears in the
+    input as it is, or byte swapped. The clean input's comparisons come back with its feedback, and for each one
+    afl_cmplog finds either operand in the input and writes the other over it, as it is, plus one and minus one.
+*/
+
+// the distinct comparisons the clean input made, in the order they were first made
+typedef struct afl_cmplog_substates {
+	u64           cmp_cnt;
+	cmplog_entry *cmps;
+} afl_cmplog_substates;
+
+void
+afl_cmplog_populate(fuzzing_strategy *strategy);
+
+#endif
@@ -65,7 +65,8 @@
 /* Maximum number of user-specified dictionary tokens to use.*/
 #define MAX_USER_DICT_ENTRIES 200
 
-/* Maximum auto dictionary token size, in bytes. */
+/* Minimum and maximum auto dictionary token size, in bytes. */
+#define MIN_AUTO_DICT_ENTRY_LEN 3
 #define MAX_AUTO_DICT_ENTRY_LEN 32
 
 /* Maximum number of auto-extracted dictionary tokens to actually use in fuzzing
@@ -99,4 +100,10 @@
 
 #define MAX_LINE 8192
 
+/* Inputs shorter than this get no effector map, every byte is treated as effective. */
+#define EFF_MIN_LEN 128
+
+/* If more than this percentage of an input's bytes are effective, treat all of them as effective. */
+#define EFF_MAX_PERC 90
+
 #endif
@@ -17,6 +17,7 @@
 #include "afl_dictionary_insert.h"
 #include "afl_dictionary_overwrite.h"
 #include "common/types.h"
+#include "effector.h"
 #include "ooze.h"
 
 // substrategies and substrategy states used by the afl_dictionary strategy.
@@ -31,6 +32,8 @@ typedef struct afl_dictionary_substates {
 	fuzzing_strategy *overwrite_strategy;
 	fuzzing_strategy *insert_strategy;
 	fuzzing_strategy *auto_overwrite_strategy;
+	// which bytes afl_bit_flip found to change the path, loaded on the first mutation
+	effector_map *effector;
 } afl_dictionary_substates;
 
 void
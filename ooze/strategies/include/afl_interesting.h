@@ -21,6 +21,7 @@
 #include "det_four_byte_interesting_le.h"
 #include "det_two_byte_interesting_be.h"
 #include "det_two_byte_interesting_le.h"
+#include "effector.h"
 #include "ooze.h"
 
 // this struct holds substrategies and substrategy states used by the afl_interesting strategy.
@@ -42,6 +43,8 @@ typedef struct afl_interesting_substates {
 	fuzzing_strategy *det_two_byte_interesting_be_strategy;
 	fuzzing_strategy *det_four_byte_interesting_le_strategy;
 	fuzzing_strategy *det_four_byte_interesting_be_strategy;
+	// which bytes afl_bit_flip found to change the path, loaded on the first mutation
+	effector_map *effector;
 
 } afl_interesting_substates;
 
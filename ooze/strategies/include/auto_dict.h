@@ -0,0 +1,66 @@
+#ifndef AUTO_DICT_H
+#define AUTO_DICT_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+#pragma once
+#include <stddef.h>
+
+#include "afl_config.h"
+#include "common/types.h"
+#include "effector.h"
+#include "ooze.h"
+
+/*
+    Auto dictionary extraction, as AFL's maybe_add_auto does it.
+
+    While afl_bit_flip flips each byte of an input, a run of consecutive bytes whose flips all change the
+    path the same way, and differently from the bytes around them, is probably a token the target compares
+    against, like a magic number or a keyword. Each run between MIN_AUTO_DICT_ENTRY_LEN and
+    MAX_AUTO_DICT_ENTRY_LEN bytes long is added to the auto dictionary, or counts as another hit if it is
+    already there.
+
+    The auto dictionary lives in the file AUTO_DICTIONARY_FILE names, "auto_dictionary" if it isn't set,
+    which afl_dictionary and afl_havoc load when they start. The file holds the USE_AUTO_DICT_ENTRIES
+    tokens with the most hits, and the file next to it with AUTO_DICT_HITS_SUFFIX holds every candidate
+    with its hits. A process keeps the tokens it finds in memory and merges them into both files under a
+    lock once the byte flips of an entry are done, so every worker and instance sharing them adds to the
+    same dictionary.
+*/
+
+// appended to the auto dictionary's name, for the file that keeps every candidate and its hits
+#define AUTO_DICT_HITS_SUFFIX ".hits"
+
+// collects the bytes of the current run, between the feedback of one byte flip and the next.
+typedef struct auto_dict_collector {
+	// checksum of the results of the run's byte flips.
+	u64 prev_cksum;
+	// the byte flip expected next, a run only continues through consecutive bytes.
+	u64 next;
+	// number of bytes in the run, which may be more than the token holds.
+	u64 len;
+	// the run's bytes, as they were before they were flipped.
+	u8 token[MAX_AUTO_DICT_ENTRY_LEN];
+} auto_dict_collector;
+
+auto_dict_collector *auto_dict_collector_create(void);
+void                 auto_dict_collector_free(auto_dict_collector *collector);
+auto_dict_collector *auto_dict_collector_copy(auto_dict_collector *collector);
+char                *auto_dict_collector_serialize(auto_dict_collector *collector);
+auto_dict_collector *auto_dict_collector_deserialize(char *s_collector, size_t s_collector_size);
+
+void auto_dict_flipped(auto_dict_collector *collector, effector_map *map, strategy_feedback *feedback);
+void auto_dict_add(u8 *token, size_t len);
+void auto_dict_flush(void);
+
+#endif
@@ -36,6 +36,9 @@
 #define MAX_LINE 8192
 #endif
 
+// the auto dictionary's file, unless the AUTO_DICTIONARY_FILE environment variable says otherwise
+#define AUTO_DICTIONARY_FILE "auto_dictionary"
+
 // an entry in a dictionary. Describes and contains a token string.
 typedef struct dictionary_entry {
 	// length of the token string
@@ -78,6 +81,8 @@ uint8_t     dictionary_add_entry(dictionary *dict, dictionary_entry *new_entry);
 dictionary *dictionary_copy(dictionary *dict);
 dictionary *dictionary_merge(dictionary *a, dictionary *b);
 dictionary *dictionary_load_file(char *filename, size_t max_entries, size_t max_token_len);
+char       *dictionary_auto_path(void);
+char       *dictionary_auto_file(void);
 
 char       *dictionary_serialize(dictionary *dict);
 dictionary *dictionary_deserialize(char *s_dict, size_t s_dict_size);
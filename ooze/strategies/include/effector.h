@@ -0,0 +1,74 @@
+#ifndef EFFECTOR_H
+#define EFFECTOR_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/types.h"
+#include "ooze.h"
+
+/*
+    An effector map records which bytes of an input can change the path the target takes.
+
+    afl_bit_flip builds one while it flips each byte of an input: a byte is effective if flipping it
+    changed the checksum of the results, compared to running the input unmodified. Every byte starts
+    out effective and is only marked ineffective once its flip has been seen, so a partial map never
+    hides a byte that matters.
+
+    The finished map is written to a directory of EFFECTOR_DIR named by a hash of the input, so the
+    deterministic strategies that run on the same input later (afl_arith, afl_interesting, afl_dictionary)
+    can load it and skip positions where every byte is ineffective. Each process writes its own file in
+    the input's directory and a loader combines all of them, so workers that split an input's byte flips
+    between them each add the bytes they flipped.
+*/
+
+// directory effector maps are shared through, unless the EFFECTOR_DIR environment variable says otherwise
+#define EFFECTOR_DIR "effector"
+
+typedef struct effector_map {
+	// hash of the input the map describes.
+	u64 input_hash;
+	// checksum of the input's results when run unmodified.
+	u64 clean_cksum;
+	// the iteration that flipped byte 0, UINT64_MAX until the byte flips start.
+	u64 origin;
+	// number of bytes the map covers, the size of the input. 0 if the map is empty.
+	size_t size;
+	// whether the unmodified input's results have been reported.
+	bool has_clean;
+	// whether the map has been written to EFFECTOR_DIR.
+	bool saved;
+	// whether a loader has looked for the input's map.
+	bool loaded;
+	char pad[sizeof(void(*)(void)) - sizeof(bool) * 3];
+	// one flag per byte, 1 if changing the byte can change the path.
+	u8 *effective;
+} effector_map;
+
+effector_map *effector_create(void);
+void          effector_free(effector_map *map);
+effector_map *effector_copy(effector_map *map);
+char         *effector_serialize(effector_map *map);
+effector_map *effector_deserialize(char *s_map, size_t s_map_size);
+char         *effector_print(effector_map *map);
+
+void effector_clean(effector_map *map, strategy_feedback *feedback);
+void effector_flipped(effector_map *map, strategy_feedback *feedback);
+void effector_load(effector_map *map, u8 *buf, size_t size);
+bool effector_skip(effector_map *map, u64 pos, u64 len);
+u64  effector_checksum(u8 *results, size_t results_size);
+
+#endif
@@ -41,6 +41,15 @@
 		return strategy_state_serialize(state, strategy_name); \
 	}
 
+// This macro wraps a mutate function that overwrites at most span bytes, starting at byte pos,
+// into a fuzzing_strategy->mutate_delta function. pos may use the state argument.
+#define MUTATE_DELTA_FUNC(func_name, mutate_func, pos, span)                                   \
+	static inline size_t                                                                       \
+	func_name(u8 *buf, size_t size, strategy_state *state, mutation_delta *delta)              \
+	{                                                                                          \
+		return strategy_mutate_overwrite(buf, size, state, delta, (pos), (span), mutate_func); \
+	}
+
 strategy_state *strategy_state_copy(strategy_state *state);
 void            strategy_state_free(strategy_state *state);
 char           *strategy_state_serialize(strategy_state *state, char *name);
@@ -48,5 +57,6 @@ strategy_state *strategy_state_deserialize(char *s_state_buffer, size_t s_state_
 char           *strategy_state_print(strategy_state *state, char *strategy_name);
 void            strategy_state_update(strategy_state *state);
 strategy_state *strategy_state_create(u8 *seed, size_t max_size, ...);
+size_t          strategy_mutate_overwrite(u8 *buf, size_t size, strategy_state *state, mutation_delta *delta, u64 pos, u64 span, fuzz_function *mutate);
 
 #endif
@@ -0,0 +1,438 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+#include "auto_dict.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "common/yaml_helper.h"
+#include "dictionary.h"
+
+#define AUTO_DICT_PATH_SIZE 1024
+
+// the values the interesting stages already try, which aren't worth a token
+static const s32 auto_dict_interesting_32[] = {INTERESTING_8, INTERESTING_16, INTERESTING_32};
+
+// the tokens this process found since it last merged them into the files, with their hits
+static dictionary *auto_dict_pending = NULL;
+
+// the user's dictionary, loaded the first time a token is checked against it
+static dictionary *auto_dict_user      = NULL;
+static bool        auto_dict_user_read = false;
+
+auto_dict_collector *
+auto_dict_collector_create(void)
+{
+	return calloc(1, sizeof(auto_dict_collector));
+}
+
+void
+auto_dict_collector_free(auto_dict_collector *collector)
+{
+	free(collector);
+}
+
+auto_dict_collector *
+auto_dict_collector_copy(auto_dict_collector *collector)
+{
+	auto_dict_collector *copy = calloc(1, sizeof(auto_dict_collector));
+	memcpy(copy, collector, sizeof(auto_dict_collector));
+	return copy;
+}
+
+// serialize a collector, writing the run's bytes as hex
+char *
+auto_dict_collector_serialize(auto_dict_collector *collector)
+{
+	yaml_serializer *helper;
+	char            *mybuffer;
+	size_t           mybuffersize;
+	char             s_token[MAX_AUTO_DICT_ENTRY_LEN * 2 + 2] = "0";
+
+	for (size_t i = 0; i < MIN(collector->len, MAX_AUTO_DICT_ENTRY_LEN); i++) {
+		snprintf(s_token + i * 2, 3, "%02x", collector->token[i]);
+	}
+
+	helper = yaml_serializer_init("");
+
+	// We want to name the structure for readability.
+	YAML_SERIALIZE_NEST_MAP(helper, auto_dict_collector)
+	YAML_SERIALIZE_START_MAPPING(helper)
+	YAML_SERIALIZE_32HEX_KV(helper, version, 0)
+
+	YAML_SERIALIZE_64HEX_PSTRUCT(helper, collector, prev_cksum)
+	YAML_SERIALIZE_64HEX_PSTRUCT(helper, collector, next)
+	YAML_SERIALIZE_64HEX_PSTRUCT(helper, collector, len)
+	YAML_SERIALIZE_STRING_KV(helper, token, s_token)
+
+	YAML_SERIALIZE_END_MAPPING(helper)
+	yaml_serializer_end(helper, &mybuffer, &mybuffersize);
+
+	return mybuffer;
+}
+
+// deserialize a collector
+auto_dict_collector *
+auto_dict_collector_deserialize(char *s_collector, size_t s_collector_size)
+{
+	auto_dict_collector *collector = auto_dict_collector_create();
+	yaml_deserializer   *helper;
+	u32                  version = 0;
+	char                 s_token[MAX_AUTO_DICT_ENTRY_LEN * 2 + 2];
+
+	helper = yaml_deserializer_init(NULL, s_collector, s_collector_size);
+
+	// Get to the document start
+	YAML_DESERIALIZE_PARSE(helper)
+	while (helper->event.type != YAML_DOCUMENT_START_EVENT) {
+		YAML_DESERIALIZE_EAT(helper)
+	}
+
+	YAML_DESERIALIZE_EAT(helper)
+	YAML_DESERIALIZE_MAPPING_START(helper, "auto_dict_collector")
+
+	// Deserialize the structure version. We have only one version, so we don't do anything with it.
+	YAML_DESERIALIZE_GET_KV_U32(helper, "version", &version)
+
+	YAML_DESERIALIZE_GET_KV_U64(helper, "prev_cksum", &collector->prev_cksum)
+	YAML_DESERIALIZE_GET_KV_U64(helper, "next", &collector->next)
+	YAML_DESERIALIZE_GET_KV_U64(helper, "len", &collector->len)
+	YAML_DESERIALIZE_GET_KV_STRING(helper, "token", s_token, sizeof(s_token))
+	YAML_DESERIALIZE_MAPPING_END(helper)
+
+	yaml_deserializer_end(helper);
+
+	for (size_t i = 0; i < MIN(collector->len, MAX_AUTO_DICT_ENTRY_LEN); i++) {
+		unsigned int byte = 0;
+		sscanf(s_token + i * 2, "%2x", &byte);
+		collector->token[i] = (u8)byte;
+	}
+	return collector;
+}
+
+// add a byte to the current run
+static void
+auto_dict_collect(auto_dict_collector *collector, u8 byte)
+{
+	if (collector->len < MAX_AUTO_DICT_ENTRY_LEN) {
+		collector->token[collector->len] = byte;
+	}
+	collector->len++;
+}
+
+// add the current run to the auto dictionary, if it is the length of a token
+static void
+auto_dict_maybe_add(auto_dict_collector *collector)
+{
+	if (collector->len >= MIN_AUTO_DICT_ENTRY_LEN && collector->len <= MAX_AUTO_DICT_ENTRY_LEN) {
+		auto_dict_add(collector->token, collector->len);
+	}
+}
+
+// follow a byte flip's feedback through the runs of bytes whose flips change the path the same way.
+// The byte flips of one input arrive in order, so a run is the bytes between two changes of checksum.
+void
+auto_dict_flipped(auto_dict_collector *collector, effector_map *map, strategy_feedback *feedback)
+{
+	if (!map->has_clean || feedback->iteration < map->origin || feedback->iteration - map->origin >= map->size) {
+		return;
+	}
+	u64 pos = feedback->iteration - map->origin;
+	if (pos >= feedback->size) {
+		return;
+	}
+
+	// a run starts over at the first byte, and after bytes another worker flipped
+	if (pos == 0 || pos != collector->next) {
+		collector->prev_cksum = map->clean_cksum;
+		collector->len        = 0;
+	}
+	collector->next = pos + 1;
+
+	u64 cksum = effector_checksum(feedback->results, feedback->results_size);
+	u8  byte  = feedback->input[pos] ^ 0xff;
+
+	// the last byte ends the run it belongs to
+	if (pos + 1 == map->size && cksum == collector->prev_cksum) {
+		auto_dict_collect(collector, byte);
+		auto_dict_maybe_add(collector);
+		auto_dict_flush();
+		return;
+	}
+	if (cksum != collector->prev_cksum) {
+		auto_dict_maybe_add(collector);
+		collector->len        = 0;
+		collector->prev_cksum = cksum;
+	}
+	// bytes that don't change the path at all don't belong to a token
+	if (cksum != map->clean_cksum) {
+		auto_dict_collect(collector, byte);
+	}
+	if (pos + 1 == map->size) {
+		auto_dict_flush();
+	}
+}
+
+// whether two tokens match, ignoring case
+static bool
+auto_dict_equal_nocase(u8 *a, u8 *b, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		if (tolower(a[i]) != tolower(b[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+// whether a token is only a repeated byte, or a value the interesting stages already try
+static bool
+auto_dict_is_trivial(u8 *token, size_t len)
+{
+	size_t i = 1;
+	while (i < len && token[i] == token[0]) {
+		i++;
+	}
+	if (i == len) {
+		return true;
+	}
+
+	if (len == 4) {
+		u32 val;
+		memcpy(&val, token, sizeof(val));
+		for (i = 0; i < sizeof(auto_dict_interesting_32) / sizeof(auto_dict_interesting_32[0]); i++) {
+			if (val == (u32)auto_dict_interesting_32[i] || val == SWAP32((u32)auto_dict_interesting_32[i])) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+#pragma clang diagnostic pop
+
+// whether the user's dictionary already has a token
+static bool
+auto_dict_in_user_dict(u8 *token, size_t len)
+{
+	if (!auto_dict_user_read) {
+		char *user_dict_file = getenv("USER_DICTIONARY_FILE");
+		if (user_dict_file != NULL) {
+			auto_dict_user = dictionary_load_file(user_dict_file, MAX_USER_DICT_ENTRIES, MAX_USER_DICT_ENTRY_LEN);
+		}
+		auto_dict_user_read = true;
+	}
+	if (auto_dict_user == NULL) {
+		return false;
+	}
+
+	for (size_t i = 0; i < auto_dict_user->entry_cnt; i++) {
+		dictionary_entry *entry = (*auto_dict_user->entries)[i];
+		if (entry->len == len && auto_dict_equal_nocase(entry->token, token, len)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// read every candidate and its hits, or start with none
+static dictionary *
+auto_dict_load_hits(char *hits_name)
+{
+	dictionary *dict = NULL;
+	FILE       *file = fopen(hits_name, "rb");
+	if (file != NULL) {
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		char *s_dict = calloc(1, (size_t)MAX(size, 0) + 1);
+		if (size > 0 && fread(s_dict, (size_t)size, 1, file) == 1) {
+			dict = dictionary_deserialize(s_dict, (size_t)size);
+		}
+		free(s_dict);
+		fclose(file);
+	}
+	if (dict == NULL) {
+		dict = dictionary_create(MAX_AUTO_DICT_ENTRIES, MAX_AUTO_DICT_ENTRY_LEN);
+	}
+	return dict;
+}
+
+// write a file under a temporary name and rename it into place, so readers never see part of one
+static void
+auto_dict_write(char *name, char *contents)
+{
+	char temp_name[AUTO_DICT_PATH_SIZE];
+	snprintf(temp_name, sizeof(temp_name), "%s.%d.tmp", name, getpid());
+
+	FILE *file = fopen(temp_name, "w");
+	if (file == NULL) {
+		log_warn("Can't write auto dictionary: '%s'.", temp_name);
+		return;
+	}
+	bool ok = fputs(contents, file) >= 0;
+	if (fclose(file) != 0 || !ok || rename(temp_name, name) != 0) {
+		log_warn("Can't write auto dictionary: '%s'.", name);
+		unlink(temp_name);
+	}
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-qual"
+// most hits first, then by length and bytes so every writer picks the same tokens
+static int
+auto_dict_compare_hits(const void *p, const void *q)
+{
+	dictionary_entry *a = *(dictionary_entry **)p;
+	dictionary_entry *b = *(dictionary_entry **)q;
+
+	if (a->hit_cnt != b->hit_cnt) {
+		return a->hit_cnt > b->hit_cnt ? -1 : 1;
+	}
+	if (a->len != b->len) {
+		return a->len < b->len ? -1 : 1;
+	}
+	return memcmp(a->token, b->token, a->len);
+}
+#pragma clang diagnostic pop
+
+// write the tokens with the most hits as a dictionary file, escaping what the loader can't read
+static void
+auto_dict_write_tokens(char *name, dictionary *dict)
+{
+	dictionary_entry **sorted = calloc(dict->entry_cnt + 1, sizeof(dictionary_entry *));
+	memcpy(sorted, *dict->entries, dict->entry_cnt * sizeof(dictionary_entry *));
+	qsort(sorted, dict->entry_cnt, sizeof(dictionary_entry *), auto_dict_compare_hits);
+
+	size_t used     = MIN(dict->entry_cnt, USE_AUTO_DICT_ENTRIES);
+	char  *contents = calloc(1, 128 + used * (32 + MAX_AUTO_DICT_ENTRY_LEN * 4));
+	size_t length   = (size_t)sprintf(contents, "# tokens afl_bit_flip found, most hits first\n");
+	for (size_t i = 0; i < used; i++) {
+		length += (size_t)sprintf(contents + length, "auto_%zu=\"", i);
+		for (size_t j = 0; j < sorted[i]->len; j++) {
+			u8 byte = sorted[i]->token[j];
+			if (byte == '"' || byte == '\\') {
+				length += (size_t)sprintf(contents + length, "\\%c", byte);
+			} else if (byte >= 32 && byte <= 126) {
+				contents[length++] = (char)byte;
+			} else {
+				length += (size_t)sprintf(contents + length, "\\x%02x", byte);
+			}
+		}
+		length += (size_t)sprintf(contents + length, "\"\n");
+	}
+
+	auto_dict_write(name, contents);
+	free(contents);
+	free(sorted);
+}
+
+// count a token seen times more in a dictionary, adding it if it isn't there yet. As in AFL, a
+// candidate's first sighting isn't a hit. When the dictionary is full, the token replaces the
+// candidate with the fewest hits.
+static void
+auto_dict_count(dictionary *dict, u8 *token, size_t len, size_t seen)
+{
+	for (size_t i = 0; i < dict->entry_cnt; i++) {
+		dictionary_entry *entry = (*dict->entries)[i];
+		if (entry->len == len && memcmp(entry->token, token, len) == 0) {
+			entry->hit_cnt += seen;
+			return;
+		}
+	}
+
+	dictionary_entry *new_entry = calloc(1, sizeof(dictionary_entry));
+	new_entry->token            = calloc(1, len);
+	new_entry->len              = len;
+	new_entry->hit_cnt          = seen - 1;
+	memcpy(new_entry->token, token, len);
+
+	if (dict->entry_cnt == dict->max_entry_cnt) {
+		size_t fewest = 0;
+		for (size_t i = 1; i < dict->entry_cnt; i++) {
+			if ((*dict->entries)[i]->hit_cnt < (*dict->entries)[fewest]->hit_cnt) {
+				fewest = i;
+			}
+		}
+		dictionary_entry_free((*dict->entries)[fewest]);
+		(*dict->entries)[fewest] = (*dict->entries)[--dict->entry_cnt];
+	}
+	if (!dictionary_add_entry(dict, new_entry)) {
+		dictionary_entry_free(new_entry);
+	}
+}
+
+// add a token to the auto dictionary, or count another hit if it is already there.
+// Tokens are kept in memory until auto_dict_flush merges them into the files.
+void
+auto_dict_add(u8 *token, size_t len)
+{
+	if (len == 0 || len > MAX_AUTO_DICT_ENTRY_LEN || auto_dict_is_trivial(token, len) || auto_dict_in_user_dict(token, len)) {
+		return;
+	}
+	if (auto_dict_pending == NULL) {
+		auto_dict_pending = dictionary_create(MAX_AUTO_DICT_ENTRIES, MAX_AUTO_DICT_ENTRY_LEN);
+	}
+	auto_dict_count(auto_dict_pending, token, len, 1);
+}
+
+// merge the tokens found since the last flush into the auto dictionary files, which afl_bit_flip
+// does once the byte flips of an entry are done, rather than for every token
+void
+auto_dict_flush(void)
+{
+	if (auto_dict_pending == NULL || auto_dict_pending->entry_cnt == 0) {
+		return;
+	}
+
+	char *name = dictionary_auto_path();
+	char  hits_name[AUTO_DICT_PATH_SIZE];
+	char  lock_name[AUTO_DICT_PATH_SIZE];
+	snprintf(hits_name, sizeof(hits_name), "%s" AUTO_DICT_HITS_SUFFIX, name);
+	snprintf(lock_name, sizeof(lock_name), "%s.lock", name);
+
+	// every worker and instance adds to the same files
+	int lock = open(lock_name, O_CREAT | O_RDWR, 0644);
+	if (lock < 0 || flock(lock, LOCK_EX) != 0) {
+		log_warn("Can't lock auto dictionary: '%s'.", lock_name);
+		if (lock >= 0) {
+			close(lock);
+		}
+		return;
+	}
+
+	dictionary *dict = auto_dict_load_hits(hits_name);
+	for (size_t i = 0; i < auto_dict_pending->entry_cnt; i++) {
+		dictionary_entry *entry = (*auto_dict_pending->entries)[i];
+		auto_dict_count(dict, entry->token, entry->len, entry->hit_cnt + 1);
+	}
+
+	char *s_dict = dictionary_serialize(dict);
+	auto_dict_write(hits_name, s_dict);
+	auto_dict_write_tokens(name, dict);
+	free(s_dict);
+	dictionary_free(dict);
+
+	flock(lock, LOCK_UN);
+	close(lock);
+
+	dictionary_free(auto_dict_pending);
+	auto_dict_pending = NULL;
+}
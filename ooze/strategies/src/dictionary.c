@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wgnu-case-range"
@@ -443,19 +444,35 @@ dictionary_load_file(char *filename, size_t max_entries, size_t max_token_len)
 				*(new_token++) = *(lptr++);
 			}
 		}
-		// create a new entry
-		dictionary_entry *new_entry = dictionary_entry_create(new_token_start_addr);
-
-		// no longer need this buffer, as it's been copied into new_entry
-		free(new_token_start_addr);
+		// create a new entry that owns the token, which may hold \x00 bytes, so its length is what was copied
+		dictionary_entry *new_entry = calloc(1, sizeof(dictionary_entry));
+		new_entry->token            = new_token_start_addr;
+		new_entry->len              = (size_t)(new_token - new_token_start_addr);
 
 		if (!dictionary_add_entry(new_dict, new_entry)) {
-			free(new_entry);
+			dictionary_entry_free(new_entry);
 		}
 	}
+	fclose(file);
 	return new_dict;
 }
 
+// the auto dictionary's file, named by AUTO_DICTIONARY_FILE or the default.
+inline char *
+dictionary_auto_path(void)
+{
+	char *auto_dict_file = getenv("AUTO_DICTIONARY_FILE");
+	return auto_dict_file ? auto_dict_file : AUTO_DICTIONARY_FILE;
+}
+
+// the auto dictionary's file, or NULL if nothing has written one yet.
+inline char *
+dictionary_auto_file(void)
+{
+	char *auto_dict_file = dictionary_auto_path();
+	return access(auto_dict_file, R_OK) == 0 ? auto_dict_file : NULL;
+}
+
 // This function serializes a dictionary into a string.
 
 inline char *
@@ -476,7 +493,7 @@ dictionary_serialize(dictionary *dict)
 	YAML_SERIALIZE_64HEX_PSTRUCT(helper, dict, max_entry_cnt)
 	YAML_SERIALIZE_64HEX_PSTRUCT(helper, dict, max_token_len)
 
-	YAML_SERIALIZE_STRUCT_ARRAY(helper, (*dict->entries), entries, dict->max_entry_cnt, SERIALIZE_DICTIONARY_ENTRY)
+	YAML_SERIALIZE_STRUCT_ARRAY(helper, (*dict->entries), entries, dict->entry_cnt, SERIALIZE_DICTIONARY_ENTRY)
 
 	YAML_SERIALIZE_END_MAPPING(helper)
 	yaml_serializer_end(helper, &s_dict, &mybuffersize);
@@ -0,0 +1,366 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+#include "effector.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "afl_config.h"
+#include "common/logger.h"
+#include "common/yaml_helper.h"
+
+#define EFFECTOR_PATH_SIZE 1024
+
+// FNV-1a, names an input's map
+static u64
+effector_hash(u8 *buf, size_t size)
+{
+	u64 hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ buf[i]) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+// checksum of a run's results, a word at a time since it runs on every byte flip
+u64
+effector_checksum(u8 *results, size_t results_size)
+{
+	u64    cksum = 0x9e3779b97f4a7c15ULL ^ results_size;
+	size_t i     = 0;
+	for (; i + sizeof(u64) <= results_size; i += sizeof(u64)) {
+		u64 word;
+		memcpy(&word, results + i, sizeof(word));
+		cksum = (cksum ^ word) * 0xff51afd7ed558ccdULL;
+		cksum ^= cksum >> 32;
+	}
+	for (; i < results_size; i++) {
+		cksum = (cksum ^ results[i]) * 0x100000001b3ULL;
+	}
+	return cksum;
+}
+
+static const char *
+effector_dir(void)
+{
+	char *dir = getenv("EFFECTOR_DIR");
+	return dir ? dir : EFFECTOR_DIR;
+}
+
+// the directory an input's maps are kept in, one file per process that wrote one
+static void
+effector_input_dir(u64 input_hash, char *name, size_t size)
+{
+	snprintf(name, size, "%s/%016" PRIx64, effector_dir(), input_hash);
+}
+
+// create an empty map, which treats every byte as effective
+effector_map *
+effector_create(void)
+{
+	effector_map *map = calloc(1, sizeof(effector_map));
+	map->origin       = UINT64_MAX;
+	return map;
+}
+
+void
+effector_free(effector_map *map)
+{
+	if (map) {
+		free(map->effective);
+		free(map);
+	}
+}
+
+effector_map *
+effector_copy(effector_map *map)
+{
+	effector_map *copy = calloc(1, sizeof(effector_map));
+	memcpy(copy, map, sizeof(effector_map));
+	if (map->size) {
+		copy->effective = malloc(map->size);
+		memcpy(copy->effective, map->effective, map->size);
+	}
+	return copy;
+}
+
+// serialize a map, packing its flags eight to a byte and writing them as hex
+char *
+effector_serialize(effector_map *map)
+{
+	yaml_serializer *helper;
+	char            *mybuffer;
+	size_t           mybuffersize;
+	size_t           packed_size = (map->size + 7) / 8;
+	char            *s_effective = calloc(1, packed_size * 2 + 2);
+
+	s_effective[0] = '0';
+	for (size_t i = 0; i < packed_size; i++) {
+		u8 packed = 0;
+		for (size_t bit = 0; bit < 8 && i * 8 + bit < map->size; bit++) {
+			packed |= (u8)(map->effective[i * 8 + bit] << bit);
+		}
+		snprintf(s_effective + i * 2, 3, "%02x", packed);
+	}
+
+	helper = yaml_serializer_init("");
+
+	// We want to name the structure for readability.
+	YAML_SERIALIZE_NEST_MAP(helper, effector_map)
+	YAML_SERIALIZE_START_MAPPING(helper)
+	YAML_SERIALIZE_32HEX_KV(helper, version, 0)
+
+	YAML_SERIALIZE_64HEX_PSTRUCT(helper, map, input_hash)
+	YAML_SERIALIZE_64HEX_PSTRUCT(helper, map, clean_cksum)
+	YAML_SERIALIZE_64HEX_PSTRUCT(helper, map, origin)
+	YAML_SERIALIZE_64HEX_KV(helper, size, (u64)map->size)
+	YAML_SERIALIZE_1HEX_KV(helper, has_clean, map->has_clean)
+	YAML_SERIALIZE_1HEX_KV(helper, saved, map->saved)
+	YAML_SERIALIZE_STRING_KV(helper, effective, s_effective)
+
+	YAML_SERIALIZE_END_MAPPING(helper)
+	yaml_serializer_end(helper, &mybuffer, &mybuffersize);
+
+	free(s_effective);
+	return mybuffer;
+}
+
+// deserialize a map
+effector_map *
+effector_deserialize(char *s_map, size_t s_map_size)
+{
+	effector_map      *map = effector_create();
+	yaml_deserializer *helper;
+	u32                version = 0;
+	u64                size    = 0;
+
+	helper = yaml_deserializer_init(NULL, s_map, s_map_size);
+
+	// Get to the document start
+	YAML_DESERIALIZE_PARSE(helper)
+	while (helper->event.type != YAML_DOCUMENT_START_EVENT) {
+		YAML_DESERIALIZE_EAT(helper)
+	}
+
+	// Deserialize the effector_map structure:
+	// This is coded like LL(1) parsing, not event-driven, because we only support one version of file_format_version and
+	// no structure members are optional in the yaml file.
+
+	YAML_DESERIALIZE_EAT(helper)
+	YAML_DESERIALIZE_MAPPING_START(helper, "effector_map")
+
+	// Deserialize the structure version. We have only one version, so we don't do anything with it.
+	YAML_DESERIALIZE_GET_KV_U32(helper, "version", &version)
+
+	YAML_DESERIALIZE_GET_KV_U64(helper, "input_hash", &map->input_hash)
+	YAML_DESERIALIZE_GET_KV_U64(helper, "clean_cksum", &map->clean_cksum)
+	YAML_DESERIALIZE_GET_KV_U64(helper, "origin", &map->origin)
+	YAML_DESERIALIZE_GET_KV_U64(helper, "size", &size)
+	YAML_DESERIALIZE_GET_KV_U1(helper, "has_clean", map->has_clean)
+	YAML_DESERIALIZE_GET_KV_U1(helper, "saved", map->saved)
+
+	size_t packed_size = ((size_t)size + 7) / 8;
+	char  *s_effective = calloc(1, packed_size * 2 + 2);
+	YAML_DESERIALIZE_GET_KV_STRING(helper, "effective", s_effective, packed_size * 2 + 2)
+	YAML_DESERIALIZE_MAPPING_END(helper)
+
+	yaml_deserializer_end(helper);
+
+	map->size = (size_t)size;
+	if (map->size) {
+		map->effective = malloc(map->size);
+		for (size_t i = 0; i < map->size; i++) {
+			unsigned int packed = 0;
+			sscanf(s_effective + (i / 8) * 2, "%2x", &packed);
+			map->effective[i] = (packed >> (i % 8)) & 1;
+		}
+	}
+	free(s_effective);
+
+	return map;
+}
+
+// this function creates a human-readable string describing a map
+char *
+effector_print(effector_map *map)
+{
+	size_t effective = 0;
+	for (size_t i = 0; i < map->size; i++) {
+		effective += map->effective[i];
+	}
+
+	char *str_buf = calloc(1, 128);
+	snprintf(str_buf, 128, "Effector Map: %zu of %zu bytes effective\n", effective, map->size);
+	return str_buf;
+}
+
+// start a map for the input the feedback describes, run unmodified.
+// A map that is already for this input, from before a resume, keeps the bytes it has marked.
+void
+effector_clean(effector_map *map, strategy_feedback *feedback)
+{
+	u64 input_hash   = effector_hash(feedback->input, feedback->size);
+	map->clean_cksum = effector_checksum(feedback->results, feedback->results_size);
+	map->has_clean   = !feedback->interesting;
+	if (map->size == feedback->size && map->input_hash == input_hash) {
+		return;
+	}
+
+	free(map->effective);
+	map->input_hash = input_hash;
+	map->size       = feedback->size;
+	map->saved      = false;
+	map->effective  = malloc(map->size ? map->size : 1);
+	memset(map->effective, 1, map->size);
+}
+
+// write a finished map, where every loader can find it
+static void
+effector_save(effector_map *map)
+{
+	map->saved = true;
+
+	const char *dir = effector_dir();
+	char        input_dir[EFFECTOR_PATH_SIZE];
+	char        temp_name[EFFECTOR_PATH_SIZE + 32];
+	char        name[EFFECTOR_PATH_SIZE + 32];
+	effector_input_dir(map->input_hash, input_dir, sizeof(input_dir));
+	snprintf(temp_name, sizeof(temp_name), "%s/%d.tmp", input_dir, getpid());
+	snprintf(name, sizeof(name), "%s/%d", input_dir, getpid());
+	if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || (mkdir(input_dir, 0755) != 0 && errno != EEXIST)) {
+		log_warn("Can't create effector map directory: '%s'.", input_dir);
+		return;
+	}
+
+	FILE *file = fopen(temp_name, "wb");
+	if (file == NULL) {
+		log_warn("Can't write effector map: '%s'.", temp_name);
+		return;
+	}
+	u64  size = map->size;
+	bool ok   = fwrite(&size, sizeof(size), 1, file) == 1 && fwrite(map->effective, map->size, 1, file) == 1;
+	if (fclose(file) != 0 || !ok || rename(temp_name, name) != 0) {
+		log_warn("Can't write effector map: '%s'.", name);
+		unlink(temp_name);
+	}
+}
+
+// mark the byte a feedback's byte flip changed, once the map's origin is set.
+// Feedback arrives in order, so the first flip past the end of the input means every byte of it has been seen.
+void
+effector_flipped(effector_map *map, strategy_feedback *feedback)
+{
+	if (!map->has_clean || feedback->iteration < map->origin || map->size < EFF_MIN_LEN) {
+		return;
+	}
+
+	u64 pos = feedback->iteration - map->origin;
+	if (pos >= map->size) {
+		if (!map->saved) {
+			effector_save(map);
+		}
+		return;
+	}
+
+	// the first and last bytes are always effective, as in AFL
+	if (pos == 0 || pos == map->size - 1 || feedback->interesting) {
+		return;
+	}
+	if (effector_checksum(feedback->results, feedback->results_size) == map->clean_cksum) {
+		map->effective[pos] = 0;
+	}
+}
+
+// load every map written for the input in buf, a byte is ineffective as soon as any one of them says so.
+// Each worker only marks the bytes it flipped, and leaves the rest effective, so the maps are ANDed.
+// If there are none, or the bytes are nearly all effective, the map stays empty and nothing is skipped.
+void
+effector_load(effector_map *map, u8 *buf, size_t size)
+{
+	map->loaded     = true;
+	map->input_hash = effector_hash(buf, size);
+
+	// only the input's own directory is read, however many inputs have maps
+	char input_dir[EFFECTOR_PATH_SIZE];
+	effector_input_dir(map->input_hash, input_dir, sizeof(input_dir));
+	DIR *entries = opendir(input_dir);
+	if (entries == NULL) {
+		return;
+	}
+
+	u8            *loaded = malloc(size ? size : 1);
+	struct dirent *entry;
+	while ((entry = readdir(entries)) != NULL) {
+		size_t length = strlen(entry->d_name);
+		if (entry->d_name[0] == '.' || (length > 4 && strcmp(entry->d_name + length - 4, ".tmp") == 0)) {
+			continue;
+		}
+
+		char name[EFFECTOR_PATH_SIZE + 256];
+		snprintf(name, sizeof(name), "%s/%s", input_dir, entry->d_name);
+		FILE *file = fopen(name, "rb");
+		if (file == NULL) {
+			continue;
+		}
+		u64  file_size = 0;
+		bool ok        = fread(&file_size, sizeof(file_size), 1, file) == 1 && file_size == size && fread(loaded, size, 1, file) == 1;
+		fclose(file);
+		if (!ok) {
+			continue;
+		}
+
+		if (map->size == 0) {
+			map->size      = size;
+			map->effective = malloc(size);
+			memset(map->effective, 1, size);
+		}
+		for (size_t i = 0; i < size; i++) {
+			map->effective[i] &= loaded[i];
+		}
+	}
+	closedir(entries);
+	free(loaded);
+
+	// as AFL does, a map that is nearly all effective isn't worth skipping with
+	size_t effective = 0;
+	for (size_t i = 0; i < map->size; i++) {
+		effective += map->effective[i];
+	}
+	if (effective * 100 > map->size * EFF_MAX_PERC) {
+		free(map->effective);
+		map->effective = NULL;
+		map->size      = 0;
+	}
+}
+
+// whether a mutation of the len bytes at pos can be skipped, because none of them are effective.
+// Bytes past the end of the map, which the input didn't have, are never skipped.
+bool
+effector_skip(effector_map *map, u64 pos, u64 len)
+{
+	if (map == NULL || map->size == 0 || pos + len > map->size) {
+		return false;
+	}
+	for (u64 i = pos; i < pos + len; i++) {
+		if (map->effective[i]) {
+			return false;
+		}
+	}
+	return true;
+}
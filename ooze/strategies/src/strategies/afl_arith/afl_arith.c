@@ -18,6 +18,7 @@
 #include "det_four_byte_arith_le.h"
 #include "det_two_byte_arith_be.h"
 #include "det_two_byte_arith_le.h"
+#include "effector.h"
 #include "strategy.h"
 
 #ifdef AFL_ARITH_IS_MASTER
@@ -100,6 +101,9 @@ afl_arith_create(u8 *seed, size_t max_size, ...)
 	substates->det_four_byte_arith_le_substate = substates->det_four_byte_arith_le_strategy->create_state(seed, max_size);
 	substates->det_four_byte_arith_be_substate = substates->det_four_byte_arith_be_strategy->create_state(seed, max_size);
 
+	// the effector map is loaded on the first mutation, once the input is known
+	substates->effector = effector_create();
+
 	new_state->internal_state = substates;
 
 	return new_state;
@@ -231,6 +235,9 @@ afl_arith_deserialize(char *serialized_state, size_t serialized_state_size)
 	substates->det_four_byte_arith_le_substate = substates->det_four_byte_arith_le_strategy->deserialize(s_det_four_byte_arith_le_substate, serialized_state_size - (size_t)(s_det_four_byte_arith_le_substate - serialized_state));
 	substates->det_four_byte_arith_be_substate = substates->det_four_byte_arith_be_strategy->deserialize(s_det_four_byte_arith_be_substate, serialized_state_size - (size_t)(s_det_four_byte_arith_be_substate - serialized_state));
 
+	// the effector map isn't serialized, it is loaded again on the next mutation
+	substates->effector = effector_create();
+
 	// update new_state's pointer
 	new_state->internal_state = substates;
 
@@ -331,6 +338,7 @@ afl_arith_copy(strategy_state *state)
 	substates_copy->det_two_byte_arith_be_substate  = substates->det_two_byte_arith_be_strategy->copy_state(substates->det_two_byte_arith_be_substate);
 	substates_copy->det_four_byte_arith_le_substate = substates->det_four_byte_arith_le_strategy->copy_state(substates->det_four_byte_arith_le_substate);
 	substates_copy->det_four_byte_arith_be_substate = substates->det_four_byte_arith_be_strategy->copy_state(substates->det_four_byte_arith_be_substate);
+	substates_copy->effector                        = effector_copy(substates->effector);
 
 	// update internal_state ptr
 	copy_state->internal_state = substates_copy;
@@ -359,6 +367,8 @@ afl_arith_free_state(strategy_state *state)
 		free(substates->det_four_byte_arith_le_strategy);
 		free(substates->det_four_byte_arith_be_strategy);
 
+		effector_free(substates->effector);
+
 		// free substates container
 		free(substates);
 
@@ -426,6 +436,24 @@ afl_arith_copy_bytes(u32 *src, u32 *dest, strategy_state *state)
 	}
 }
 
+// number of bytes the current substrategy mutates
+static inline u64
+afl_arith_width(strategy_state *state)
+{
+	afl_arith_substates *substates = (afl_arith_substates *)state->internal_state;
+
+	switch (substates->current_substrategy) {
+	case TWO_BYTE_ARITH_LE:
+	case TWO_BYTE_ARITH_BE:
+		return 2;
+	case FOUR_BYTE_ARITH_LE:
+	case FOUR_BYTE_ARITH_BE:
+		return 4;
+	default:
+		return 1;
+	}
+}
+
 static inline bool
 afl_arith_check_pos(u64 pos, strategy_state *state)
 {
@@ -533,6 +561,10 @@ afl_arith(u8 *buf, size_t size, strategy_state *state)
 	u64  pos         = 0;
 	bool pos_changed = true;
 
+	if (!substates->effector->loaded) {
+		effector_load(substates->effector, buf, size);
+	}
+
 	while (size) {
 		u64 new_pos = afl_arith_get_pos(state);
 		// check for position change, if position changed, we need to update orig_bytes later.
@@ -551,6 +583,11 @@ afl_arith(u8 *buf, size_t size, strategy_state *state)
 			afl_arith_update(state);
 			continue;
 		}
+		// skip positions where afl_bit_flip found no byte that changes the path
+		if (effector_skip(substates->effector, pos, afl_arith_width(state))) {
+			afl_arith_update(state);
+			continue;
+		}
 		// if the position we are mutating is valid and has changed, we need to make a new backup
 		// of the bytes at that position.
 		if (pos_changed) {
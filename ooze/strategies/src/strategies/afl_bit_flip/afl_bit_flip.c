@@ -17,6 +17,7 @@
 #include <string.h>
 
 #include "afl.h"
+#include "auto_dict.h"
 #include "common/yaml_helper.h"
 #include "det_bit_flip.h"
 #include "det_byte_flip.h"
@@ -24,6 +25,7 @@
 #include "det_four_byte_flip.h"
 #include "det_two_bit_flip.h"
 #include "det_two_byte_flip.h"
+#include "effector.h"
 #include "strategy.h"
 
 #ifdef AFL_BIT_FLIP_IS_MASTER
@@ -34,7 +36,8 @@ get_fuzzing_strategy_function get_fuzzing_strategy = afl_bit_flip_populate;
 static inline void
 afl_bit_flip_update(strategy_state *state)
 {
-	afl_bit_flip_substates *substates = (afl_bit_flip_substates *)state->internal_state;
+	afl_bit_flip_substates *substates      = (afl_bit_flip_substates *)state->internal_state;
+	bool                    byte_flip_next = substates->substrategy_complete && substates->current_substrategy + 1 == BYTE_FLIP;
 
 	// if a substrategy was complete, move on to the next substrategy
 	if (substates->substrategy_complete) {
@@ -74,6 +77,11 @@ afl_bit_flip_update(strategy_state *state)
 	}
 	// update general purpose iterator
 	state->iteration++;
+
+	// the byte flips start at this iteration, which tells the effector map which byte each feedback flipped
+	if (byte_flip_next) {
+		substates->effector->origin = state->iteration;
+	}
 }
 
 // create an afl_bit_flip strategy_state object.
@@ -113,6 +121,8 @@ afl_bit_flip_create(u8 *seed, size_t max_size, ...)
 	substates->det_two_byte_flip_substate  = substates->det_two_byte_flip_strategy->create_state(seed, max_size);
 	substates->det_four_byte_flip_substate = substates->det_four_byte_flip_strategy->create_state(seed, max_size);
 
+	substates->effector       = effector_create();
+	substates->auto_dict      = auto_dict_collector_create();
 	new_state->internal_state = substates;
 
 	return new_state;
@@ -133,6 +143,8 @@ afl_bit_flip_serialize(strategy_state *state)
 	char *s_det_byte_flip_substate      = substates->det_byte_flip_strategy->serialize(substates->det_byte_flip_substate);
 	char *s_det_two_byte_flip_substate  = substates->det_two_byte_flip_strategy->serialize(substates->det_two_byte_flip_substate);
 	char *s_det_four_byte_flip_substate = substates->det_four_byte_flip_strategy->serialize(substates->det_four_byte_flip_substate);
+	char *s_effector                    = effector_serialize(substates->effector);
+	char *s_auto_dict                   = auto_dict_collector_serialize(substates->auto_dict);
 
 	// serialize base strategy structure
 	s_state           = strategy_state_serialize(state, "afl_bit_flip");
@@ -154,6 +166,8 @@ afl_bit_flip_serialize(strategy_state *state)
 	total_size += strlen(s_det_byte_flip_substate);
 	total_size += strlen(s_det_two_byte_flip_substate);
 	total_size += strlen(s_det_four_byte_flip_substate);
+	total_size += strlen(s_effector);
+	total_size += strlen(s_auto_dict);
 
 	// buffer to hold all serialized data
 	char *s_all = calloc(1, total_size + 1);
@@ -167,6 +181,8 @@ afl_bit_flip_serialize(strategy_state *state)
 	strcat(s_all, s_det_byte_flip_substate);
 	strcat(s_all, s_det_two_byte_flip_substate);
 	strcat(s_all, s_det_four_byte_flip_substate);
+	strcat(s_all, s_effector);
+	strcat(s_all, s_auto_dict);
 
 	// free these, don't need em anymore.
 	free(s_state);
@@ -177,6 +193,8 @@ afl_bit_flip_serialize(strategy_state *state)
 	free(s_det_byte_flip_substate);
 	free(s_det_two_byte_flip_substate);
 	free(s_det_four_byte_flip_substate);
+	free(s_effector);
+	free(s_auto_dict);
 
 	return s_all;
 }
@@ -193,6 +211,8 @@ afl_bit_flip_deserialize(char *serialized_state, size_t serialized_state_size)
 	char *s_det_byte_flip_substate;
 	char *s_det_two_byte_flip_substate;
 	char *s_det_four_byte_flip_substate;
+	char *s_effector;
+	char *s_auto_dict = NULL;
 
 	// create new state object and substates object
 	strategy_state         *new_state;
@@ -206,6 +226,7 @@ afl_bit_flip_deserialize(char *serialized_state, size_t serialized_state_size)
 	s_det_byte_flip_substate      = strstr(s_det_four_bit_flip_substate, "...") + 4;
 	s_det_two_byte_flip_substate  = strstr(s_det_byte_flip_substate, "...") + 4;
 	s_det_four_byte_flip_substate = strstr(s_det_two_byte_flip_substate, "...") + 4;
+	s_effector                    = strstr(s_det_four_byte_flip_substate, "...");
 
 	// deserialize base strategy structure;
 	new_state = strategy_state_deserialize(serialized_state, serialized_state_size);
@@ -254,6 +275,20 @@ afl_bit_flip_deserialize(char *serialized_state, size_t serialized_state_size)
 	substates->det_two_byte_flip_substate  = substates->det_two_byte_flip_strategy->deserialize(s_det_two_byte_flip_substate, serialized_state_size - (size_t)(s_det_two_byte_flip_substate - serialized_state));
 	substates->det_four_byte_flip_substate = substates->det_four_byte_flip_strategy->deserialize(s_det_four_byte_flip_substate, serialized_state_size - (size_t)(s_det_four_byte_flip_substate - serialized_state));
 
+	// states serialized before the effector map existed don't have one
+	if (s_effector && s_effector[3] != '\0' && s_effector[4] != '\0') {
+		substates->effector = effector_deserialize(s_effector + 4, serialized_state_size - (size_t)(s_effector + 4 - serialized_state));
+		s_auto_dict         = strstr(s_effector + 4, "...");
+	} else {
+		substates->effector = effector_create();
+	}
+	// nor do states serialized before auto dictionary extraction have a collector
+	if (s_auto_dict && s_auto_dict[3] != '\0' && s_auto_dict[4] != '\0') {
+		substates->auto_dict = auto_dict_collector_deserialize(s_auto_dict + 4, serialized_state_size - (size_t)(s_auto_dict + 4 - serialized_state));
+	} else {
+		substates->auto_dict = auto_dict_collector_create();
+	}
+
 	// update new_state's pointer
 	new_state->internal_state = substates;
 
@@ -275,6 +310,7 @@ afl_bit_flip_print(strategy_state *state)
 	char *p_det_byte_flip_substate      = substates->det_byte_flip_strategy->print_state(substates->det_byte_flip_substate);
 	char *p_det_two_byte_flip_substate  = substates->det_two_byte_flip_strategy->print_state(substates->det_two_byte_flip_substate);
 	char *p_det_four_byte_flip_substate = substates->det_four_byte_flip_strategy->print_state(substates->det_four_byte_flip_substate);
+	char *p_effector                    = effector_print(substates->effector);
 
 	char buf[64];
 	memset(buf, 0, 64);
@@ -287,6 +323,7 @@ afl_bit_flip_print(strategy_state *state)
 	total_size += strlen(p_det_byte_flip_substate);
 	total_size += strlen(p_det_two_byte_flip_substate);
 	total_size += strlen(p_det_four_byte_flip_substate);
+	total_size += strlen(p_effector);
 
 	// buffer to hold all serialized data, 128 is probably enough buffer.
 	char *p_all = calloc(1, 128 + total_size + 1);
@@ -310,6 +347,7 @@ afl_bit_flip_print(strategy_state *state)
 	strcat(p_all, p_det_byte_flip_substate);
 	strcat(p_all, p_det_two_byte_flip_substate);
 	strcat(p_all, p_det_four_byte_flip_substate);
+	strcat(p_all, p_effector);
 
 	// free these, don't need em anymore.
 	free(p_state);
@@ -319,6 +357,7 @@ afl_bit_flip_print(strategy_state *state)
 	free(p_det_byte_flip_substate);
 	free(p_det_two_byte_flip_substate);
 	free(p_det_four_byte_flip_substate);
+	free(p_effector);
 
 	return p_all;
 }
@@ -361,6 +400,8 @@ afl_bit_flip_copy(strategy_state *state)
 	substates_copy->det_byte_flip_substate      = substates->det_byte_flip_strategy->copy_state(substates->det_byte_flip_substate);
 	substates_copy->det_two_byte_flip_substate  = substates->det_two_byte_flip_strategy->copy_state(substates->det_two_byte_flip_substate);
 	substates_copy->det_four_byte_flip_substate = substates->det_four_byte_flip_strategy->copy_state(substates->det_four_byte_flip_substate);
+	substates_copy->effector                    = effector_copy(substates->effector);
+	substates_copy->auto_dict                   = auto_dict_collector_copy(substates->auto_dict);
 
 	// update internal_state ptr
 	copy_state->internal_state = substates_copy;
@@ -391,6 +432,11 @@ afl_bit_flip_free_state(strategy_state *state)
 		free(substates->det_two_byte_flip_strategy);
 		free(substates->det_four_byte_flip_strategy);
 
+		effector_free(substates->effector);
+		auto_dict_collector_free(substates->auto_dict);
+		// an entry left before its byte flips are done still keeps the tokens they found
+		auto_dict_flush();
+
 		// free substates container
 		free(substates);
 
@@ -473,11 +519,25 @@ afl_bit_flip(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+// this function builds the effector map and finds auto dictionary tokens from the results of the byte flips.
+static inline void
+afl_bit_flip_feedback(strategy_state *state, strategy_feedback *feedback)
+{
+	afl_bit_flip_substates *substates = (afl_bit_flip_substates *)state->internal_state;
+
+	if (feedback->clean) {
+		effector_clean(substates->effector, feedback);
+	} else {
+		effector_flipped(substates->effector, feedback);
+		auto_dict_flipped(substates->auto_dict, substates->effector, feedback);
+	}
+}
+
 // this function populates a fuzzing_strategy object with afl_bit_flip's function pointers.
 void
 afl_bit_flip_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_THREE;
 	strategy->name             = "afl_bit_flip";
 	strategy->create_state     = afl_bit_flip_create;
 	strategy->mutate           = afl_bit_flip;
@@ -491,4 +551,5 @@ afl_bit_flip_populate(fuzzing_strategy *strategy)
 	                             "after each single bit flip to detect dictionary tokens.";
 	strategy->update_state     = &afl_bit_flip_update;
 	strategy->is_deterministic = true;
+	strategy->report_feedback  = afl_bit_flip_feedback;
 }
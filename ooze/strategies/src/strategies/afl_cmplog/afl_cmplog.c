@@ -0,0 +1,354 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "afl_cmplog.h"
+#include "common/yaml_helper.h"
+#include "strategy.h"
+
+#ifdef AFL_CMPLOG_IS_MASTER
+get_fuzzing_strategy_function get_fuzzing_strategy = afl_cmplog_populate;
+#endif
+
+// Each comparison is tried both ways, finding one operand and writing the other, in the target's byte order and
+// swapped, and the written operand as it is, plus one and minus one, for the comparisons that test an order.
+#define CMPLOG_DIRECTIONS 2
+#define CMPLOG_ENCODINGS 2
+#define CMPLOG_VARIANTS 3
+#define CMPLOG_SUBSTITUTIONS (CMPLOG_DIRECTIONS * CMPLOG_ENCODINGS * CMPLOG_VARIANTS)
+
+#define SERIALIZE_CMPLOG_ENTRY(HELPER, ENTRY)              \
+	do {                                                   \
+		YAML_SERIALIZE_START_MAPPING(HELPER);              \
+		YAML_SERIALIZE_64HEX_STRUCT(HELPER, ENTRY, op0);   \
+		YAML_SERIALIZE_64HEX_STRUCT(HELPER, ENTRY, op1);   \
+		YAML_SERIALIZE_32HEX_STRUCT(HELPER, ENTRY, size);  \
+		YAML_SERIALIZE_END_MAPPING(HELPER);                \
+	} while (0);
+
+// where a substitution writes, and what
+typedef struct afl_cmplog_candidate {
+	u64 pos;
+	u32 size;
+	u8  replacement[sizeof(u64)];
+} afl_cmplog_candidate;
+
+// the operand's bytes, least significant first unless swapped
+static inline void
+afl_cmplog_encode(u64 value, u32 size, bool swapped, u8 *out)
+{
+	for (u32 i = 0; i < size; i++) {
+		out[swapped ? size - 1 - i : i] = (u8)(value >> (i * 8));
+	}
+}
+
+// move the state to the next substitution whose operand is in the input, and describe it.
+// An iteration is a position in the input, for each substitution of each comparison.
+static bool
+afl_cmplog_find(u8 *buf, size_t size, strategy_state *state, afl_cmplog_candidate *candidate)
+{
+	afl_cmplog_substates *substates = (afl_cmplog_substates *)state->internal_state;
+
+	if (size == 0) {
+		return false;
+	}
+	for (;; strategy_state_update(state)) {
+		u64 pos          = state->iteration % size;
+		u64 substitution = (state->iteration / size) % CMPLOG_SUBSTITUTIONS;
+		u64 cmp          = state->iteration / size / CMPLOG_SUBSTITUTIONS;
+		if (cmp >= substates->cmp_cnt) {
+			return false;
+		}
+
+		cmplog_entry *entry   = &substates->cmps[cmp];
+		bool          swapped = (substitution / CMPLOG_VARIANTS) % CMPLOG_ENCODINGS;
+		if (pos + entry->size > size || (swapped && entry->size == 1)) {
+			continue;
+		}
+
+		u64 mask    = entry->size == sizeof(u64) ? UINT64_MAX : (1ULL << (entry->size * 8)) - 1;
+		u64 found   = substitution / (CMPLOG_VARIANTS * CMPLOG_ENCODINGS) ? entry->op1 : entry->op0;
+		u64 written = substitution / (CMPLOG_VARIANTS * CMPLOG_ENCODINGS) ? entry->op0 : entry->op1;
+		switch (substitution % CMPLOG_VARIANTS) {
+		case 1:
+			written++;
+			break;
+		case 2:
+			written--;
+			break;
+		default:
+			break;
+		}
+
+		u8 pattern[sizeof(u64)];
+		afl_cmplog_encode(found & mask, entry->size, swapped, pattern);
+		if (memcmp(buf + pos, pattern, entry->size) != 0) {
+			continue;
+		}
+		afl_cmplog_encode(written & mask, entry->size, swapped, candidate->replacement);
+		if (memcmp(buf + pos, candidate->replacement, entry->size) == 0) {
+			continue;
+		}
+		candidate->pos  = pos;
+		candidate->size = entry->size;
+		return true;
+	}
+}
+
+// overwrite an operand found in the input with the one it was compared with
+static inline size_t
+afl_cmplog(u8 *buf, size_t size, strategy_state *state)
+{
+	afl_cmplog_candidate candidate;
+	if (!afl_cmplog_find(buf, size, state, &candidate)) {
+		return 0;
+	}
+	memcpy(buf + candidate.pos, candidate.replacement, candidate.size);
+	return size;
+}
+
+// afl_cmplog, saving the operand it overwrites
+static inline size_t
+afl_cmplog_delta(u8 *buf, size_t size, strategy_state *state, mutation_delta *delta)
+{
+	afl_cmplog_candidate candidate;
+	if (!afl_cmplog_find(buf, size, state, &candidate)) {
+		delta->op = DELTA_FULL;
+		return 0;
+	}
+	return strategy_mutate_overwrite(buf, size, state, delta, candidate.pos, candidate.size, afl_cmplog);
+}
+
+// keep the distinct comparisons of the clean input, which the substitutions are made from.
+// Comparisons of equal operands have nothing to substitute, and a pair compared either way is tried both ways anyway.
+static void
+afl_cmplog_feedback(strategy_state *state, strategy_feedback *feedback)
+{
+	afl_cmplog_substates *substates = (afl_cmplog_substates *)state->internal_state;
+
+	if (!feedback->clean) {
+		return;
+	}
+	free(substates->cmps);
+	substates->cmps    = NULL;
+	substates->cmp_cnt = 0;
+	if (feedback->comparisons == NULL || feedback->comparisons_size < sizeof(cmplog_map)) {
+		return;
+	}
+
+	u32 count;
+	memcpy(&count, feedback->comparisons + offsetof(cmplog_map, count), sizeof(count));
+	count           = MIN(count, CMPLOG_ENTRIES);
+	substates->cmps = calloc(count + 1, sizeof(cmplog_entry));
+
+	for (u32 i = 0; i < count; i++) {
+		cmplog_entry entry;
+		memcpy(&entry, feedback->comparisons + offsetof(cmplog_map, entries) + i * sizeof(cmplog_entry), sizeof(entry));
+		if (entry.size != 1 && entry.size != 2 && entry.size != 4 && entry.size != 8) {
+			continue;
+		}
+		u64 mask  = entry.size == sizeof(u64) ? UINT64_MAX : (1ULL << (entry.size * 8)) - 1;
+		entry.op0 = entry.op0 & mask;
+		entry.op1 = entry.op1 & mask;
+		entry.pad = 0;
+		if (entry.op0 == entry.op1) {
+			continue;
+		}
+
+		bool seen = false;
+		for (u64 j = 0; j < substates->cmp_cnt && !seen; j++) {
+			cmplog_entry *kept = &substates->cmps[j];
+			seen               = kept->size == entry.size && ((kept->op0 == entry.op0 && kept->op1 == entry.op1) || (kept->op0 == entry.op1 && kept->op1 == entry.op0));
+		}
+		if (!seen) {
+			substates->cmps[substates->cmp_cnt++] = entry;
+		}
+	}
+}
+
+// serialize a state, and the comparisons it substitutes
+static inline char *
+afl_cmplog_serialize(strategy_state *state)
+{
+	afl_cmplog_substates *substates = (afl_cmplog_substates *)state->internal_state;
+	yaml_serializer      *helper;
+	char                 *s_cmps;
+	size_t                mybuffersize;
+
+	char *s_state = strategy_state_serialize(state, "afl_cmplog");
+
+	helper = yaml_serializer_init("");
+
+	// We want to name the structure for readability.
+	YAML_SERIALIZE_NEST_MAP(helper, afl_cmplog_substates)
+	YAML_SERIALIZE_START_MAPPING(helper)
+	YAML_SERIALIZE_32HEX_KV(helper, version, 0)
+	YAML_SERIALIZE_64HEX_PSTRUCT(helper, substates, cmp_cnt)
+	YAML_SERIALIZE_STRUCT_ARRAY(helper, substates->cmps, cmps, substates->cmp_cnt, SERIALIZE_CMPLOG_ENTRY)
+	YAML_SERIALIZE_END_MAPPING(helper)
+	yaml_serializer_end(helper, &s_cmps, &mybuffersize);
+
+	char *s_all = calloc(1, strlen(s_state) + strlen(s_cmps) + 1);
+	strcat(s_all, s_state);
+	strcat(s_all, s_cmps);
+
+	free(s_state);
+	free(s_cmps);
+
+	return s_all;
+}
+
+// Yaml helper function to deserialize a comparison. Like the feedback, only operand sizes that can be substituted are
+// kept, and no more than the cmp_cnt the cmps were allocated for.
+static void
+afl_cmplog_entry_deserialize_yaml(yaml_deserializer *helper, __attribute__((unused)) cmplog_entry *slot, afl_cmplog_substates *substates, u64 cmp_max)
+{
+	cmplog_entry entry = {0};
+
+	YAML_DESERIALIZE_EAT(helper)
+
+	if (helper->event.type == YAML_SEQUENCE_END_EVENT) {
+		return;
+	}
+
+	YAML_DESERIALIZE_GET_KV_U64(helper, "op0", &entry.op0)
+	YAML_DESERIALIZE_GET_KV_U64(helper, "op1", &entry.op1)
+	YAML_DESERIALIZE_GET_KV_U32(helper, "size", &entry.size)
+	YAML_DESERIALIZE_MAPPING_END(helper)
+
+	if (entry.size != 1 && entry.size != 2 && entry.size != 4 && entry.size != 8) {
+		return;
+	}
+	if (substates->cmp_cnt < cmp_max) {
+		substates->cmps[substates->cmp_cnt++] = entry;
+	}
+}
+
+// deserialize a state, and the comparisons it substitutes
+static inline strategy_state *
+afl_cmplog_deserialize(char *serialized_state, size_t serialized_state_size)
+{
+	afl_cmplog_substates *substates = calloc(1, sizeof(afl_cmplog_substates));
+	yaml_deserializer    *helper;
+	u32                   version = 0;
+	u64                   cmp_max = 0;
+
+	char           *s_cmps = strstr(serialized_state, "...") + 4;
+	strategy_state *state  = strategy_state_deserialize(serialized_state, serialized_state_size);
+
+	helper = yaml_deserializer_init(NULL, s_cmps, serialized_state_size - (size_t)(s_cmps - serialized_state));
+
+	// Get to the document start
+	YAML_DESERIALIZE_PARSE(helper)
+	while (helper->event.type != YAML_DOCUMENT_START_EVENT) {
+		YAML_DESERIALIZE_EAT(helper)
+	}
+
+	YAML_DESERIALIZE_EAT(helper)
+	YAML_DESERIALIZE_MAPPING_START(helper, "afl_cmplog_substates")
+
+	// Deserialize the structure version. We have only one version, so we don't do anything with it.
+	YAML_DESERIALIZE_GET_KV_U32(helper, "version", &version)
+
+	YAML_DESERIALIZE_GET_KV_U64(helper, "cmp_cnt", &cmp_max)
+	cmp_max         = MIN(cmp_max, CMPLOG_ENTRIES);
+	substates->cmps = calloc(cmp_max + 1, sizeof(cmplog_entry));
+	YAML_DESERIALIZE_SEQUENCE(helper, "cmps", afl_cmplog_entry_deserialize_yaml, substates->cmps, substates, cmp_max)
+	YAML_DESERIALIZE_MAPPING_END(helper)
+
+	yaml_deserializer_end(helper);
+
+	state->internal_state = substates;
+
+	return state;
+}
+
+// print a state, and how many comparisons it substitutes
+static inline char *
+afl_cmplog_print(strategy_state *state)
+{
+	afl_cmplog_substates *substates     = (afl_cmplog_substates *)state->internal_state;
+	char                 *printed_state = strategy_state_print(state, "afl_cmplog");
+	char                 *printed_all   = calloc(1, strlen(printed_state) + 64);
+
+	snprintf(printed_all, strlen(printed_state) + 64, "%sComparisons: %" PRIu64 "\n", printed_state, substates->cmp_cnt);
+	free(printed_state);
+
+	return printed_all;
+}
+
+static inline strategy_state *
+afl_cmplog_copy(strategy_state *state)
+{
+	afl_cmplog_substates *substates = (afl_cmplog_substates *)state->internal_state;
+	afl_cmplog_substates *copy      = calloc(1, sizeof(afl_cmplog_substates));
+	strategy_state       *new_state = calloc(1, sizeof(strategy_state));
+	memcpy(new_state, state, sizeof(strategy_state));
+
+	copy->cmp_cnt = substates->cmp_cnt;
+	copy->cmps    = calloc(substates->cmp_cnt + 1, sizeof(cmplog_entry));
+	memcpy(copy->cmps, substates->cmps, substates->cmp_cnt * sizeof(cmplog_entry));
+
+	new_state->internal_state = copy;
+
+	return new_state;
+}
+
+static inline void
+afl_cmplog_free(strategy_state *state)
+{
+	afl_cmplog_substates *substates = (afl_cmplog_substates *)state->internal_state;
+	if (substates) {
+		free(substates->cmps);
+		free(substates);
+	}
+	state->internal_state = NULL;
+	strategy_state_free(state);
+}
+
+// the comparisons come with the clean input's feedback, so a new state has none
+static inline strategy_state *
+afl_cmplog_create(u8 *seed, size_t max_size, ...)
+{
+	strategy_state *new_state = strategy_state_create(seed, max_size);
+	new_state->internal_state = calloc(1, sizeof(afl_cmplog_substates));
+
+	return new_state;
+}
+
+/* populates fuzzing_strategy structure */
+void
+afl_cmplog_populate(fuzzing_strategy *strategy)
+{
+	strategy->version          = VERSION_THREE;
+	strategy->name             = "afl_cmplog";
+	strategy->create_state     = afl_cmplog_create;
+	strategy->mutate           = afl_cmplog;
+	strategy->serialize        = afl_cmplog_serialize;
+	strategy->deserialize      = afl_cmplog_deserialize;
+	strategy->print_state      = afl_cmplog_print;
+	strategy->copy_state       = afl_cmplog_copy;
+	strategy->free_state       = afl_cmplog_free;
+	strategy->description      = "Finds the operands of the comparisons the target made with the clean input in the input, "
+	                             "as they are and byte swapped, and overwrites each with the value it was compared with, "
+	                             "as it is, plus one and minus one.";
+	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = afl_cmplog_delta;
+	strategy->report_feedback  = afl_cmplog_feedback;
+	strategy->is_deterministic = true;
+}
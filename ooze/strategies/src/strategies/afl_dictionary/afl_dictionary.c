@@ -21,6 +21,8 @@
 #include "afl_dictionary_insert.h"
 #include "afl_dictionary_overwrite.h"
 #include "common/yaml_helper.h"
+#include "dictionary.h"
+#include "effector.h"
 #include "strategy.h"
 
 #ifdef AFL_DICTIONARY_IS_MASTER
@@ -121,7 +123,7 @@ afl_dictionary_serialize(strategy_state *state)
 		total_size += strlen(s_user_insert_substate);
 	}
 	if (substates->auto_overwrite_substate) {
-		s_auto_overwrite_substate = substates->overwrite_strategy->serialize(substates->auto_overwrite_substate);
+		s_auto_overwrite_substate = substates->auto_overwrite_strategy->serialize(substates->auto_overwrite_substate);
 		total_size += strlen(s_auto_overwrite_substate);
 	}
 
@@ -166,9 +168,10 @@ afl_dictionary_deserialize(char *serialized_state, size_t serialized_state_size)
 	afl_dictionary_substates *new_substates = calloc(1, sizeof(afl_dictionary_substates));
 
 	// strategy objects, exposes API of substrategies.
-	new_substates->overwrite_strategy = calloc(1, sizeof(fuzzing_strategy));
-	new_substates->insert_strategy    = calloc(1, sizeof(fuzzing_strategy));
-	new_state                         = strategy_state_deserialize(serialized_state, serialized_state_size);
+	new_substates->overwrite_strategy      = calloc(1, sizeof(fuzzing_strategy));
+	new_substates->insert_strategy         = calloc(1, sizeof(fuzzing_strategy));
+	new_substates->auto_overwrite_strategy = calloc(1, sizeof(fuzzing_strategy));
+	new_state                              = strategy_state_deserialize(serialized_state, serialized_state_size);
 
 	// deserialize substates header
 	yaml_deserializer *helper;
@@ -205,11 +208,17 @@ afl_dictionary_deserialize(char *serialized_state, size_t serialized_state_size)
 		// We ignore cases where a strategy_name is not seen as that is probably part of a dictionary paired with the preceeding strategy.
 		if (sscanf(serialized_substrategy, "---\nstrategy_name: %s", substrategy_name) == 1) {
 
-			if (strcmp(substrategy_name, "afl_dictionary_overwrite") == 0) {
+			// both overwrites have the same name, the user's comes before the user's insert and the auto one after it or alone
+			if (strcmp(substrategy_name, "afl_dictionary_overwrite") == 0 && !new_substates->user_insert_substate && strstr(serialized_substrategy, "strategy_name: afl_dictionary_insert")) {
 
 				afl_dictionary_overwrite_populate(new_substates->overwrite_strategy);
 				new_substates->user_overwrite_substate = new_substates->overwrite_strategy->deserialize(serialized_substrategy, serialized_state_size - (size_t)(serialized_substrategy - serialized_state));
 
+			} else if (strcmp(substrategy_name, "afl_dictionary_overwrite") == 0) {
+
+				afl_dictionary_overwrite_populate(new_substates->auto_overwrite_strategy);
+				new_substates->auto_overwrite_substate = new_substates->auto_overwrite_strategy->deserialize(serialized_substrategy, serialized_state_size - (size_t)(serialized_substrategy - serialized_state));
+
 			} else if (strcmp(substrategy_name, "afl_dictionary_insert") == 0) {
 
 				afl_dictionary_insert_populate(new_substates->insert_strategy);
@@ -217,7 +226,7 @@ afl_dictionary_deserialize(char *serialized_state, size_t serialized_state_size)
 
 			} else if (strcmp(substrategy_name, "afl_dictionary_auto_overwrite") == 0) {
 
-				afl_dictionary_insert_populate(new_substates->auto_overwrite_strategy);
+				afl_dictionary_overwrite_populate(new_substates->auto_overwrite_strategy);
 				new_substates->auto_overwrite_substate = new_substates->auto_overwrite_strategy->deserialize(serialized_substrategy, serialized_state_size - (size_t)(serialized_substrategy - serialized_state));
 
 			} else {
@@ -227,6 +236,9 @@ afl_dictionary_deserialize(char *serialized_state, size_t serialized_state_size)
 		}
 	}
 
+	// the effector map isn't serialized, it is loaded again on the next mutation
+	new_substates->effector = effector_create();
+
 	// fixup internal_state pointer.
 	new_state->internal_state = new_substates;
 
@@ -322,12 +334,14 @@ afl_dictionary_copy(strategy_state *state)
 	copy_substates->substrategy_complete = substates->substrategy_complete;
 
 	// strategy objects, exposes API of substrategies.
-	copy_substates->overwrite_strategy = calloc(1, sizeof(fuzzing_strategy));
-	copy_substates->insert_strategy    = calloc(1, sizeof(fuzzing_strategy));
+	copy_substates->overwrite_strategy      = calloc(1, sizeof(fuzzing_strategy));
+	copy_substates->insert_strategy         = calloc(1, sizeof(fuzzing_strategy));
+	copy_substates->auto_overwrite_strategy = calloc(1, sizeof(fuzzing_strategy));
 
 	// fill in substrategies
 	afl_dictionary_overwrite_populate(copy_substates->overwrite_strategy);
 	afl_dictionary_insert_populate(copy_substates->insert_strategy);
+	afl_dictionary_overwrite_populate(copy_substates->auto_overwrite_strategy);
 
 	// copy substates if they exist.
 	if (substates->user_overwrite_substate) {
@@ -339,6 +353,7 @@ afl_dictionary_copy(strategy_state *state)
 	if (substates->auto_overwrite_substate) {
 		copy_substates->auto_overwrite_substate = substates->auto_overwrite_strategy->copy_state(substates->auto_overwrite_substate);
 	}
+	copy_substates->effector = effector_copy(substates->effector);
 	copy_state->internal_state = copy_substates;
 
 	return copy_state;
@@ -361,6 +376,8 @@ afl_dictionary_free(strategy_state *state)
 	}
 	free(substates->overwrite_strategy);
 	free(substates->insert_strategy);
+	free(substates->auto_overwrite_strategy);
+	effector_free(substates->effector);
 
 	// free the substate object
 	free(substates);
@@ -376,15 +393,17 @@ afl_dictionary_create(u8 *seed, size_t max_size, ...)
 	afl_dictionary_substates *new_substates = calloc(1, sizeof(afl_dictionary_substates));
 	// get path to files describing dictionaries to use.
 	char *user_dict_file = getenv("USER_DICTIONARY_FILE");
-	char *auto_dict_file = getenv("AUTO_DICTIONARY_FILE");
+	char *auto_dict_file = dictionary_auto_file();
 
 	// strategy objects, exposes API of substrategies.
-	new_substates->overwrite_strategy = calloc(1, sizeof(fuzzing_strategy));
-	new_substates->insert_strategy    = calloc(1, sizeof(fuzzing_strategy));
+	new_substates->overwrite_strategy      = calloc(1, sizeof(fuzzing_strategy));
+	new_substates->insert_strategy         = calloc(1, sizeof(fuzzing_strategy));
+	new_substates->auto_overwrite_strategy = calloc(1, sizeof(fuzzing_strategy));
 
 	// fill in objects
 	afl_dictionary_overwrite_populate(new_substates->overwrite_strategy);
 	afl_dictionary_insert_populate(new_substates->insert_strategy);
+	afl_dictionary_overwrite_populate(new_substates->auto_overwrite_strategy);
 
 	if (user_dict_file) {
 		// set starting substrategy to user_dictionary_overwrite
@@ -405,10 +424,44 @@ afl_dictionary_create(u8 *seed, size_t max_size, ...)
 	if (!new_substates->current_substrategy) {
 		new_substates->current_substrategy = 0xff;
 	}
+	// the effector map is loaded on the first mutation, once the input is known
+	new_substates->effector   = effector_create();
 	new_state->internal_state = new_substates;
 	return new_state;
 }
 
+// skip overwrites that would only replace bytes afl_bit_flip found don't change the path.
+// Inserts shift every byte after them, so, as in AFL, they are never skipped.
+static inline void
+afl_dictionary_skip_ineffective(strategy_state *state)
+{
+	afl_dictionary_substates *substates = (afl_dictionary_substates *)state->internal_state;
+
+	while (true) {
+		strategy_state *substate = NULL;
+		if (substates->substrategy_complete) {
+			return;
+		} else if (substates->current_substrategy == USER_DICTIONARY_OVERWRITE) {
+			substate = substates->user_overwrite_substate;
+		} else if (substates->current_substrategy == AUTO_DICTIONARY_OVERWRITE) {
+			substate = substates->auto_overwrite_substate;
+		}
+		if (substate == NULL) {
+			return;
+		}
+
+		dictionary *dict = (dictionary *)substate->internal_state;
+		if (dict->entry_cnt == 0) {
+			return;
+		}
+		dictionary_entry *entry = (*dict->entries)[substate->iteration % dict->entry_cnt];
+		if (!effector_skip(substates->effector, substate->iteration / dict->entry_cnt, entry->len)) {
+			return;
+		}
+		afl_dictionary_update(state);
+	}
+}
+
 // do the mutation, returns 0 when complete.
 static inline size_t
 afl_dictionary(u8 *buf, size_t size, strategy_state *state)
@@ -416,6 +469,11 @@ afl_dictionary(u8 *buf, size_t size, strategy_state *state)
 	afl_dictionary_substates *substates    = (afl_dictionary_substates *)state->internal_state;
 	size_t                    results_size = 0;
 
+	if (!substates->effector->loaded) {
+		effector_load(substates->effector, buf, size);
+	}
+	afl_dictionary_skip_ineffective(state);
+
 	switch (substates->current_substrategy) {
 	case USER_DICTIONARY_OVERWRITE: {
 		if (substates->user_overwrite_substate) {
@@ -208,7 +208,7 @@ afl_havoc_create(u8 *seed, size_t max_size, ...)
 	afl_havoc_substates *substates = calloc(1, sizeof(afl_havoc_substates));
 	// get path to files describing dictionaries to use.
 	char *user_dict_file = getenv("USER_DICTIONARY_FILE");
-	char *auto_dict_file = getenv("AUTO_DICTIONARY_FILE");
+	char *auto_dict_file = dictionary_auto_file();
 
 	if (user_dict_file) {
 		substates->user_dict = dictionary_load_file(user_dict_file, MAX_USER_DICT_ENTRIES, MAX_USER_DICT_ENTRY_LEN);
@@ -467,6 +467,11 @@ afl_havoc(u8 *buf, size_t size, strategy_state *state)
 				break;
 			}
 
+			// the token has to fit inside the buffer it overwrites
+			if (entry->len > size) {
+				break;
+			}
+
 			// position is somewhere inside of the buffer to be mutated
 			u64 pos = prng_state_UR(prng_state, size - entry->len + 1);
 
@@ -19,6 +19,7 @@
 #include "det_four_byte_interesting_le.h"
 #include "det_two_byte_interesting_be.h"
 #include "det_two_byte_interesting_le.h"
+#include "effector.h"
 #include "strategy.h"
 
 #ifdef AFL_INTERESTING_IS_MASTER
@@ -104,6 +105,9 @@ afl_interesting_create(u8 *seed, size_t max_size, ...)
 	substates->det_four_byte_interesting_le_substate = substates->det_four_byte_interesting_le_strategy->create_state(seed, max_size);
 	substates->det_four_byte_interesting_be_substate = substates->det_four_byte_interesting_be_strategy->create_state(seed, max_size);
 
+	// the effector map is loaded on the first mutation, once the input is known
+	substates->effector = effector_create();
+
 	new_state->internal_state = substates;
 
 	return new_state;
@@ -236,6 +240,9 @@ afl_interesting_deserialize(char *serialized_state, size_t serialized_state_size
 	substates->det_four_byte_interesting_le_substate = substates->det_four_byte_interesting_le_strategy->deserialize(s_det_four_byte_interesting_le_substate, serialized_state_size - (size_t)(s_det_four_byte_interesting_le_substate - serialized_state));
 	substates->det_four_byte_interesting_be_substate = substates->det_four_byte_interesting_be_strategy->deserialize(s_det_four_byte_interesting_be_substate, serialized_state_size - (size_t)(s_det_four_byte_interesting_be_substate - serialized_state));
 
+	// the effector map isn't serialized, it is loaded again on the next mutation
+	substates->effector = effector_create();
+
 	// update new_state's pointer
 	new_state->internal_state = substates;
 
@@ -336,6 +343,7 @@ afl_interesting_copy(strategy_state *state)
 	substates_copy->det_two_byte_interesting_be_substate  = substates->det_two_byte_interesting_be_strategy->copy_state(substates->det_two_byte_interesting_be_substate);
 	substates_copy->det_four_byte_interesting_le_substate = substates->det_four_byte_interesting_le_strategy->copy_state(substates->det_four_byte_interesting_le_substate);
 	substates_copy->det_four_byte_interesting_be_substate = substates->det_four_byte_interesting_be_strategy->copy_state(substates->det_four_byte_interesting_be_substate);
+	substates_copy->effector                              = effector_copy(substates->effector);
 
 	// update internal_state ptr
 	copy_state->internal_state = substates_copy;
@@ -364,6 +372,8 @@ afl_interesting_free_state(strategy_state *state)
 		free(substates->det_four_byte_interesting_le_strategy);
 		free(substates->det_four_byte_interesting_be_strategy);
 
+		effector_free(substates->effector);
+
 		// free substates container
 		free(substates);
 
@@ -456,6 +466,24 @@ afl_interesting_get_value(strategy_state *state)
 }
 #pragma clang diagnostic pop
 
+// number of bytes the current substrategy mutates
+static inline u64
+afl_interesting_width(strategy_state *state)
+{
+	afl_interesting_substates *substates = (afl_interesting_substates *)state->internal_state;
+
+	switch (substates->current_substrategy) {
+	case TWO_BYTE_INTERESTING_LE:
+	case TWO_BYTE_INTERESTING_BE:
+		return 2;
+	case FOUR_BYTE_INTERESTING_LE:
+	case FOUR_BYTE_INTERESTING_BE:
+		return 4;
+	default:
+		return 1;
+	}
+}
+
 static inline bool
 afl_interesting_check_pos(u64 pos, u8 j, strategy_state *state)
 {
@@ -537,6 +565,10 @@ afl_interesting(u8 *buf, size_t size, strategy_state *state)
 	u64                        pos;
         u8                         j; 
 
+	if (!substates->effector->loaded) {
+		effector_load(substates->effector, buf, size);
+	}
+
 	while (size) {
 
 		pos = afl_interesting_get_pos(state);  // this is i
@@ -557,6 +589,10 @@ afl_interesting(u8 *buf, size_t size, strategy_state *state)
                     	// If not, we can update and move on to next 
 			afl_interesting_update(state);
 		}
+		// skip positions where afl_bit_flip found no byte that changes the path
+		else if (effector_skip(substates->effector, pos, afl_interesting_width(state))) {
+			afl_interesting_update(state);
+		}
 		// If the input we are about to generate was not produced by a previous mutation strategy.
 		else if (afl_interesting_check_could_be_list(buf, state)) {
 
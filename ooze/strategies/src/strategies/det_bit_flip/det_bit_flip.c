@@ -39,11 +39,13 @@ det_bit_flip(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_bit_flip_delta, det_bit_flip, state->iteration / CHAR_BIT, 1)
+
 /* populates fuzzing_strategy structure */
 void
 det_bit_flip_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_bit_flip";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_bit_flip;
@@ -54,5 +56,6 @@ det_bit_flip_populate(fuzzing_strategy *strategy)
 	strategy->free_state       = strategy_state_free;
 	strategy->description      = "On the first iteration it flips the first bit, and so on...";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_bit_flip_delta;
 	strategy->is_deterministic = true;
 }
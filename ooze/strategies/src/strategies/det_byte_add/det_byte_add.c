@@ -43,11 +43,13 @@ det_byte_add(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_byte_add_delta, det_byte_add, state->iteration / UCHAR_MAX, 1)
+
 /* populates fuzzing_strategy structure */
 void
 det_byte_add_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_byte_add";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_byte_add;
@@ -61,5 +63,6 @@ det_byte_add_populate(fuzzing_strategy *strategy)
 	                             "It adds a single value from the range, depending on the iteration number. "
 	                             "Once it is done iterating through the range, it moves to the next byte in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_byte_add_delta;
 	strategy->is_deterministic = true;
 }
@@ -58,11 +58,13 @@ det_byte_arith(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_byte_arith_delta, det_byte_arith, state->iteration / (MAX_ARITH * 2), 1)
+
 /* populates fuzzing_strategy structure */
 void
 det_byte_arith_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_byte_arith";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_byte_arith;
@@ -77,5 +79,6 @@ det_byte_arith_populate(fuzzing_strategy *strategy)
 	                             "It adds a single value from the range, depending on the iteration number. "
 	                             "Once it is done iterating through the range, it moves to the next byte in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_byte_arith_delta;
 	strategy->is_deterministic = true;
 }
@@ -43,11 +43,13 @@ det_byte_dec(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_byte_dec_delta, det_byte_dec, state->iteration, 1)
+
 /* populates fuzzing_strategy structure */
 void
 det_byte_dec_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_byte_dec";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_byte_dec;
@@ -59,5 +61,6 @@ det_byte_dec_populate(fuzzing_strategy *strategy)
 	strategy->description      = "Deterministically decrements a byte by one. "
 	                             "On the first iteration it decrements the first byte, then it decrements the next byte, and so on.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_byte_dec_delta;
 	strategy->is_deterministic = true;
 }
@@ -51,11 +51,13 @@ det_byte_flip(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_byte_flip_delta, det_byte_flip, state->iteration, 1)
+
 /* populates fuzzing_strategy structure */
 void
 det_byte_flip_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_byte_flip";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_byte_flip;
@@ -68,5 +70,6 @@ det_byte_flip_populate(fuzzing_strategy *strategy)
 	                             "On the next iteration, it flips the byte at byte position 1. "
 	                             "And so on and so forth etc etc etc...";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_byte_flip_delta;
 	strategy->is_deterministic = true;
 }
@@ -42,11 +42,13 @@ det_byte_inc(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_byte_inc_delta, det_byte_inc, state->iteration, 1)
+
 /* populates fuzzing_strategy structure */
 void
 det_byte_inc_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_byte_inc";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_byte_inc;
@@ -58,5 +60,6 @@ det_byte_inc_populate(fuzzing_strategy *strategy)
 	strategy->description      = "Deterministically increments a byte by one. "
 	                             "On the first iteration it increments the first byte, then it increments the next byte, and so on.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_byte_inc_delta;
 	strategy->is_deterministic = true;
 }
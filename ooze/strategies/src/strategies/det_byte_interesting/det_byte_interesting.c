@@ -41,11 +41,13 @@ det_byte_interesting(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_byte_interesting_delta, det_byte_interesting, state->iteration / INTERESTING_8_SIZE, 1)
+
 /* populates fuzzing_strategy structure */
 void
 det_byte_interesting_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_byte_interesting";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_byte_interesting;
@@ -60,5 +62,6 @@ det_byte_interesting_populate(fuzzing_strategy *strategy)
 	                             "It replaces a byte with a single value, depending on the iteration number. "
 	                             "Once it is done iterating through the values, it moves to the next byte in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_byte_interesting_delta;
 	strategy->is_deterministic = true;
 }
@@ -41,11 +41,13 @@ det_four_bit_flip(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_four_bit_flip_delta, det_four_bit_flip, state->iteration / CHAR_BIT, 2)
+
 /* populates fuzzing_strategy structure */
 void
 det_four_bit_flip_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_four_bit_flip";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_four_bit_flip;
@@ -58,5 +60,6 @@ det_four_bit_flip_populate(fuzzing_strategy *strategy)
 	                             "On the next iteration, it flips the 4 bits at bit position 1. "
 	                             "etc etc blah blah blah.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_four_bit_flip_delta;
 	strategy->is_deterministic = true;
 }
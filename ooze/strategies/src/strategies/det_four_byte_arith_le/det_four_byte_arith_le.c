@@ -55,11 +55,13 @@ det_four_byte_arith_le(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_four_byte_arith_le_delta, det_four_byte_arith_le, state->iteration / (MAX_ARITH * 2), 4)
+
 /* populates fuzzing_strategy structure */
 void
 det_four_byte_arith_le_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_four_byte_arith_le";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_four_byte_arith_le;
@@ -75,5 +77,6 @@ det_four_byte_arith_le_populate(fuzzing_strategy *strategy)
 	                             "It adds a single value from the range, depending on the iteration number. "
 	                             "Once it is done iterating through the range, it moves to the next byte in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_four_byte_arith_le_delta;
 	strategy->is_deterministic = true;
 }
@@ -41,11 +41,13 @@ det_four_byte_flip(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_four_byte_flip_delta, det_four_byte_flip, state->iteration, 4)
+
 /* populates fuzzing_strategy structure */
 void
 det_four_byte_flip_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_four_byte_flip";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_four_byte_flip;
@@ -58,5 +60,6 @@ det_four_byte_flip_populate(fuzzing_strategy *strategy)
 	                             "On the next iteration, it flips the four bytes at byte position 1. "
 	                             "And so on and so forth etc etc etc...";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_four_byte_flip_delta;
 	strategy->is_deterministic = true;
 }
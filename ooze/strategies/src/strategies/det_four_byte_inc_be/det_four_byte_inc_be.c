@@ -43,11 +43,13 @@ det_four_byte_inc_be(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_four_byte_inc_be_delta, det_four_byte_inc_be, state->iteration, 4)
+
 /* populates fuzzing_strategy structure */
 void
 det_four_byte_inc_be_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_four_byte_inc_be";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_four_byte_inc_be;
@@ -60,5 +62,6 @@ det_four_byte_inc_be_populate(fuzzing_strategy *strategy)
 	                             "The four bytes in question are treated as a single big-endian integer. "
 	                             "it moves forward a single byte position in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_four_byte_inc_be_delta;
 	strategy->is_deterministic = true;
 }
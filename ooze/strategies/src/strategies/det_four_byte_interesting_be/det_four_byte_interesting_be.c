@@ -44,11 +44,13 @@ det_four_byte_interesting_be(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_four_byte_interesting_be_delta, det_four_byte_interesting_be, state->iteration / (INTERESTING_8_SIZE + INTERESTING_16_SIZE + INTERESTING_32_SIZE), 4)
+
 /* populates fuzzing_strategy structure */
 void
 det_four_byte_interesting_be_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_four_byte_interesting_be";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_four_byte_interesting_be;
@@ -64,5 +66,6 @@ det_four_byte_interesting_be_populate(fuzzing_strategy *strategy)
 	                             "It replaces four bytes with a single value, depending on the iteration number. "
 	                             "Once it is done iterating through the values, it moves to the next byte in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_four_byte_interesting_be_delta;
 	strategy->is_deterministic = true;
 }
@@ -56,11 +56,13 @@ det_two_byte_arith_be(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_two_byte_arith_be_delta, det_two_byte_arith_be, state->iteration / (MAX_ARITH * 2), 2)
+
 /* populates fuzzing_strategy structure */
 void
 det_two_byte_arith_be_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_two_byte_arith_be";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_two_byte_arith_be;
@@ -76,5 +78,6 @@ det_two_byte_arith_be_populate(fuzzing_strategy *strategy)
 	                             "It adds a single value from the range, depending on the iteration number. "
 	                             "Once it is done iterating through the range, it moves to the next byte in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_two_byte_arith_be_delta;
 	strategy->is_deterministic = true;
 }
@@ -57,11 +57,13 @@ det_two_byte_arith_le(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_two_byte_arith_le_delta, det_two_byte_arith_le, state->iteration / (MAX_ARITH * 2), 2)
+
 /* populates fuzzing_strategy structure */
 void
 det_two_byte_arith_le_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_two_byte_arith_le";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_two_byte_arith_le;
@@ -77,5 +79,6 @@ det_two_byte_arith_le_populate(fuzzing_strategy *strategy)
 	                             "It adds a single value from the range, depending on the iteration number. "
 	                             "Once it is done iterating through the range, it moves to the next byte in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_two_byte_arith_le_delta;
 	strategy->is_deterministic = true;
 }
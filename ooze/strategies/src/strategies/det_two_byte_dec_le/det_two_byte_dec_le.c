@@ -43,11 +43,13 @@ det_two_byte_dec_le(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_two_byte_dec_le_delta, det_two_byte_dec_le, state->iteration, 2)
+
 /* populates fuzzing_strategy structure */
 void
 det_two_byte_dec_le_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_two_byte_dec_le";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_two_byte_dec_le;
@@ -60,5 +62,6 @@ det_two_byte_dec_le_populate(fuzzing_strategy *strategy)
 	                             "The two bytes in question are treated as a single little-endian integer. "
 	                             "it moves forward a single byte position in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_two_byte_dec_le_delta;
 	strategy->is_deterministic = true;
 }
@@ -42,11 +42,13 @@ det_two_byte_interesting_be(u8 *buf, size_t size, strategy_state *state)
 	return size;
 }
 
+MUTATE_DELTA_FUNC(det_two_byte_interesting_be_delta, det_two_byte_interesting_be, state->iteration / (INTERESTING_8_SIZE + INTERESTING_16_SIZE), 2)
+
 /* populates fuzzing_strategy structure */
 void
 det_two_byte_interesting_be_populate(fuzzing_strategy *strategy)
 {
-	strategy->version          = VERSION_ONE;
+	strategy->version          = VERSION_TWO;
 	strategy->name             = "det_two_byte_interesting_be";
 	strategy->create_state     = strategy_state_create;
 	strategy->mutate           = det_two_byte_interesting_be;
@@ -62,5 +64,6 @@ det_two_byte_interesting_be_populate(fuzzing_strategy *strategy)
 	                             "It replaces two bytes with a single value, depending on the iteration number. "
 	                             "Once it is done iterating through the values, it moves to the next byte in the buffer and repeats.";
 	strategy->update_state     = strategy_state_update;
+	strategy->mutate_delta     = det_two_byte_interesting_be_delta;
 	strategy->is_deterministic = true;
 }
@@ -175,3 +175,18 @@ strategy_state_update(strategy_state *state)
 {
 	state->iteration++;
 }
+
+// this function saves the bytes a mutation is about to overwrite, then performs the mutation.
+// Mutations that would reach past max_size are left for mutate to reject.
+inline size_t
+strategy_mutate_overwrite(u8 *buf, size_t size, strategy_state *state, mutation_delta *delta, u64 pos, u64 span, fuzz_function *mutate)
+{
+	delta->op = DELTA_FULL;
+	if (pos < state->max_size && span <= MUTATION_DELTA_MAX) {
+		delta->op     = DELTA_OVERWRITE;
+		delta->offset = pos;
+		delta->length = MIN(span, state->max_size - pos);
+		memcpy(delta->saved, buf + pos, delta->length);
+	}
+	return mutate(buf, size, state);
+}
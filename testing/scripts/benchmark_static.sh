@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+# DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+#
+# This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+#
+# © 2019 Massachusetts Institute of Technology.
+#
+# Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+#
+# The software/firmware is provided to you on an As-Is basis
+#
+# Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+# Compares execs/sec of the dlopen build of the_fuzz against the all-in-one the_fuzz_static.
+# Both are run with the same arguments from a fresh directory, so paths in them should be absolute.
+# Module names should be paths the dlopen build can load, the_fuzz_static only uses their base names.
+# Each binary runs $RUNS times (default 3), and the median execs_per_sec in fuzzer_stats is reported.
+#
+# usage: benchmark_static.sh [the_fuzz] [the_fuzz_static] [the_fuzz arguments...]
+# e.g.:  JIG_TARGET=$PWD/target ANALYSIS_SIZE=65536 JIG_MAP_SIZE=65536 \
+#          benchmark_static.sh build/the_fuzz/the_fuzz build/the_fuzz/the_fuzz_static \
+#          -S $PWD/gtfo/analysis/afl_bitmap_analysis.so -J $PWD/gtfo/the_fuzz/afl_jig.so -O $PWD/gtfo/ooze/afl_havoc.so \
+#          -i $PWD/seed -x 1024 -n 100000 -s 0123456789abcdef0123456789abcdef
+
+if [ $# -lt 3 ]; then
+  echo "usage: $0 [the_fuzz] [the_fuzz_static] [the_fuzz arguments...]"
+  exit 1
+fi
+
+dynamic=$(realpath $1)
+static=$(realpath $2)
+shift 2
+runs=${RUNS:-3}
+work_dir=$(mktemp -d)
+
+# prints the execs_per_sec of each run of a binary, one per line
+benchmark() {
+  binary=$1
+  shift
+  for run in $(seq $runs); do
+    rm -rf $work_dir/run
+    mkdir $work_dir/run
+    (cd $work_dir/run && $binary -k 0 "$@" >/dev/null 2>&1)
+    grep "^execs_per_sec " $work_dir/run/fuzzer_stats | awk '{ print $3 }'
+  done
+}
+
+# the median of the numbers on stdin
+median() {
+  sort -n | awk '{ v[NR] = $1 } END { if (NR % 2) print v[(NR + 1) / 2]; else print (v[NR / 2] + v[NR / 2 + 1]) / 2 }'
+}
+
+dynamic_rate=$(benchmark $dynamic "$@" | median)
+static_rate=$(benchmark $static "$@" | median)
+rm -rf $work_dir
+
+echo "the_fuzz:        $dynamic_rate execs/sec"
+echo "the_fuzz_static: $static_rate execs/sec"
+awk -v d=$dynamic_rate -v s=$static_rate 'BEGIN { if (d > 0) printf "speedup:         %.3fx\n", s / d }'
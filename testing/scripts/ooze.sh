@@ -45,8 +45,14 @@ if [ $virt != "docker" ]; then
 
       if [[ -f $F1 ]]; then
         $gtfo_dir/testing/tap_tester/build/ooze_tap $F1 $gtfo_dir/testing/tap_tester/tap_tests/ooze/$strategy/testfile.txt
+        if [[ -f $gtfo_dir/testing/tap_tester/tap_tests/ooze/$strategy/feedback.txt ]]; then
+          $gtfo_dir/testing/tap_tester/build/ooze_tap $F1 $gtfo_dir/testing/tap_tester/tap_tests/ooze/$strategy/feedback.txt
+        fi
       elif [[ -f $F2 ]]; then
         $gtfo_dir/testing/tap_tester/build/ooze_tap $F2 $gtfo_dir/testing/tap_tester/tap_tests/ooze/$strategy/testfile.txt
+        if [[ -f $gtfo_dir/testing/tap_tester/tap_tests/ooze/$strategy/feedback.txt ]]; then
+          $gtfo_dir/testing/tap_tester/build/ooze_tap $F2 $gtfo_dir/testing/tap_tester/tap_tests/ooze/$strategy/feedback.txt
+        fi
       else
         echo -e "Cannot find either:\n  $F1\n  $F2\n"
         exit 1
@@ -77,6 +83,9 @@ else
       echo "[+] Testing $strategy strategy."
 
       ASAN_SYMBOLIZER_PATH=/usr/lib/llvm-6.0/bin/llvm-symbolizer ASAN_OPTIONS=halt_on_error=false:detect_odr_violation=0 /home/testing/tap_tester/make/ooze_tap /home/ooze/make/strategies/src/strategies/$strategy/$strategy.so /home/testing/tap_tester/tap_tests/ooze/$strategy/testfile.txt 1>$1/ooze/${strategy}_stdout.txt 2>$1/ooze/${strategy}_stderr.txt
+      if [[ -f /home/testing/tap_tester/tap_tests/ooze/$strategy/feedback.txt ]]; then
+        ASAN_SYMBOLIZER_PATH=/usr/lib/llvm-6.0/bin/llvm-symbolizer ASAN_OPTIONS=halt_on_error=false:detect_odr_violation=0 /home/testing/tap_tester/make/ooze_tap /home/ooze/make/strategies/src/strategies/$strategy/$strategy.so /home/testing/tap_tester/tap_tests/ooze/$strategy/feedback.txt 1>$1/ooze/${strategy}_feedback_stdout.txt 2>$1/ooze/${strategy}_feedback_stderr.txt
+      fi
       echo "[+] Done!"
     fi
   done
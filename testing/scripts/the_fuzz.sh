@@ -40,6 +40,30 @@ echo "[+] Done!"
 echo "[+] Testing jig 'afl'"
 ASAN_SYMBOLIZER_PATH=/usr/lib/llvm-6.0/bin/llvm-symbolizer ASAN_OPTIONS=halt_on_error=false:detect_odr_violation=0 JIG_MAP_SIZE=65536 JIG_TARGET=/home/testing/tap_tester/tap_tests/jig/tiff2rgba JIG_TARGET_ARGV="-c jpeg fuzzfile /dev/null" ./make/jig_tap -J /home/the_fuzz/make/afl_jig.so -t /home/testing/tap_tester/tap_tests/jig/afl/testfile.txt 1>$1/the_fuzz/jig_afl_stdout.txt 2>$1/the_fuzz/jig_afl_stderr.txt
 echo "[+] Done!"
+echo "[+] Testing jig 'afl' with the forkserver options"
+# the target offers the comparison log, the input channel and batches, and declines them all for declined.txt.
+# large.txt says the inputs can be larger than the input channel, so the jig declines it.
+clang -I/home/common/include -o /home/testing/tap_tester/tap_tests/jig/options/forkserver_options /home/testing/test_binaries/forkserver_options/forkserver_options.c
+ASAN_SYMBOLIZER_PATH=/usr/lib/llvm-6.0/bin/llvm-symbolizer ASAN_OPTIONS=halt_on_error=false:detect_odr_violation=0 ./make/jig_tap -J /home/the_fuzz/make/afl_jig.so -t /home/testing/tap_tester/tap_tests/jig/options/testfile.txt 1>$1/the_fuzz/jig_afl_options_stdout.txt 2>$1/the_fuzz/jig_afl_options_stderr.txt
+ASAN_SYMBOLIZER_PATH=/usr/lib/llvm-6.0/bin/llvm-symbolizer ASAN_OPTIONS=halt_on_error=false:detect_odr_violation=0 ./make/jig_tap -J /home/the_fuzz/make/afl_jig.so -t /home/testing/tap_tester/tap_tests/jig/options/declined.txt 1>$1/the_fuzz/jig_afl_options_declined_stdout.txt 2>$1/the_fuzz/jig_afl_options_declined_stderr.txt
+ASAN_SYMBOLIZER_PATH=/usr/lib/llvm-6.0/bin/llvm-symbolizer ASAN_OPTIONS=halt_on_error=false:detect_odr_violation=0 ./make/jig_tap -J /home/the_fuzz/make/afl_jig.so -t /home/testing/tap_tester/tap_tests/jig/options/large.txt 1>$1/the_fuzz/jig_afl_options_large_stdout.txt 2>$1/the_fuzz/jig_afl_options_large_stderr.txt
+echo "[+] Done!"
+echo "[+] Testing cmin with jig 'afl'"
+rm -rf /tmp/the_fuzz_cmin
+mkdir -p /tmp/the_fuzz_cmin/in
+cp /home/testing/tap_tester/tap_tests/jig/afl/io/*.input /tmp/the_fuzz_cmin/in/
+pushd /tmp/the_fuzz_cmin 1>/dev/null
+# the jig is initialized again for every worker and for the selection, and each must run the target with all of its arguments,
+# or the crashing input goes unnoticed
+ASAN_SYMBOLIZER_PATH=/usr/lib/llvm-6.0/bin/llvm-symbolizer ASAN_OPTIONS=halt_on_error=false:detect_odr_violation=0 JIG_MAP_SIZE=65536 JIG_TARGET=/home/testing/tap_tester/tap_tests/jig/afl/tiff2rgba JIG_TARGET_ARGV="-c jpeg fuzzfile /dev/null" /home/the_fuzz/make/the_fuzz -J /home/the_fuzz/make/afl_jig.so -i in --cmin out -j 2 1>$1/the_fuzz/cmin_afl_stdout.txt 2>$1/the_fuzz/cmin_afl_stderr.txt
+if grep -q "kept 2 of 3 inputs covering [0-9]* tuples, 1 crashed" $1/the_fuzz/cmin_afl_stdout.txt $1/the_fuzz/cmin_afl_stderr.txt; then
+  echo "ok 1 - cmin keeps the two clean inputs and finds the crashing one" >>$1/the_fuzz/cmin_afl_stdout.txt
+else
+  echo "not ok 1 - cmin keeps the two clean inputs and finds the crashing one" >>$1/the_fuzz/cmin_afl_stdout.txt
+fi
+popd 1>/dev/null
+rm -rf /tmp/the_fuzz_cmin
+echo "[+] Done!"
 echo "[+] Testing jig 'dummy'"
 ASAN_SYMBOLIZER_PATH=/usr/lib/llvm-6.0/bin/llvm-symbolizer ASAN_OPTIONS=halt_on_error=false:detect_odr_violation=0 ./make/jig_tap -J /home/the_fuzz/make/dummy_jig.so -t /home/testing/tap_tester/tap_tests/jig/dummy/testfile.txt 1>$1/the_fuzz/jig_dummy_stdout.txt 2>$1/the_fuzz/jig_dummy_stderr.txt
 echo "[+] Tests complete! cleaning up..."
@@ -47,5 +71,6 @@ popd 1>/dev/null
 
 rm -rv /home/the_fuzz/make 1>/dev/null 2>/dev/null
 rm /home/testing/tap_tester/tap_tests/jig/afl/fuzzfile 2>/dev/null
+rm /home/testing/tap_tester/tap_tests/jig/options/forkserver_options /home/testing/tap_tester/tap_tests/jig/options/fuzzfile 2>/dev/null
 echo "[+] Done!"
 echo ""
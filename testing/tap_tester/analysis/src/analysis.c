@@ -27,6 +27,9 @@ static analysis_api s;
 
 #define VERSION_ONE_TEST_COUNT_PER_INPUT 2
 #define VERSION_ONE_TEST_EXTRA 2
+#define VERSION_TWO_TEST_EXTRA 2
+#define VERSION_THREE_TEST_EXTRA (VERSION_TWO_TEST_EXTRA + 4)
+#define VERSION_FOUR_TEST_EXTRA (VERSION_THREE_TEST_EXTRA + 3)
 static __attribute__((noreturn)) void
 usage(char *arg0)
 {
@@ -35,7 +38,7 @@ usage(char *arg0)
 }
 
 static void
-test_version_one(char *test_filename)
+test_version_one(char *test_filename, u64 extra_tests)
 {
 
 	FILE *testfile = fopen(test_filename, "r");
@@ -44,13 +47,16 @@ test_version_one(char *test_filename)
 	}
 
 	u64 input_count = count_tests(testfile, 2);
-	u64 test_count  = (input_count * VERSION_ONE_TEST_COUNT_PER_INPUT) + VERSION_ONE_TEST_EXTRA;
+	u64 test_count  = (input_count * VERSION_ONE_TEST_COUNT_PER_INPUT) + VERSION_ONE_TEST_EXTRA + extra_tests;
 	plan((unsigned int)test_count);
 
 	char *meta = NULL;
 	check_header(testfile, &meta);
 	free(meta);
 	s.initialize(NULL);
+	if (s.version >= VERSION_TWO) {
+		ok(s.density() == 0.0, "Checking the density of an empty analysis");
+	}
 
 	char *desc      = NULL;
 	int   desc_size = 0;
@@ -87,6 +93,25 @@ test_version_one(char *test_filename)
 		free(io_file);
 		free(expected);
 	}
+	if (s.version >= VERSION_TWO) {
+		double density = s.density();
+		ok(density > 0.0 && density <= 1.0, "Checking the density after adding elements");
+	}
+	// the buckets keep their own views, apart from add's and each other's
+	if (s.version >= VERSION_THREE && input_count > 0) {
+		ok(s.add_bucket(ANALYSIS_CRASH, inputs[0], inputs_size[0]) == false, "adding an element to the crash bucket");
+		ok(s.add_bucket(ANALYSIS_CRASH, inputs[0], inputs_size[0]) == true, "adding an element the crash bucket has seen");
+		ok(s.add_bucket(ANALYSIS_HANG, inputs[0], inputs_size[0]) == false, "adding the element to the hang bucket");
+	}
+	// masking an element's positions makes them variable, which lowers the stability
+	double stability = 1.0;
+	if (s.version >= VERSION_FOUR && input_count > 0) {
+		ok(s.stability() == 1.0, "Checking the stability before masking");
+		s.mask(inputs[0], inputs_size[0]);
+		stability = s.stability();
+		ok(stability < 1.0 && stability >= 0.0, "Checking the stability after masking an element");
+	}
+
 	// save and reload
 	char *save_file = "analysis_save";
 	s.save(save_file);
@@ -107,6 +132,12 @@ test_version_one(char *test_filename)
 		free(io_file);
 		free(expected);
 	}
+	if (s.version >= VERSION_THREE && input_count > 0) {
+		ok(s.add_bucket(ANALYSIS_CRASH, inputs[0], inputs_size[0]) == true, "checking the crash bucket was reloaded");
+	}
+	if (s.version >= VERSION_FOUR && input_count > 0) {
+		ok(s.stability() == stability, "checking the mask was reloaded");
+	}
 
 	unlink(save_file);
 	for (size_t i = 0; i < input_count; i++) {
@@ -165,8 +196,17 @@ main(int argc, char *argv[])
 	(*get_analysis)(&s);
 
 	switch (s.version) {
-	case 1:
-		test_version_one(test_filename);
+	case VERSION_ONE:
+		test_version_one(test_filename, 0);
+		break;
+	case VERSION_TWO:
+		test_version_one(test_filename, VERSION_TWO_TEST_EXTRA);
+		break;
+	case VERSION_THREE:
+		test_version_one(test_filename, VERSION_THREE_TEST_EXTRA);
+		break;
+	case VERSION_FOUR:
+		test_version_one(test_filename, VERSION_FOUR_TEST_EXTRA);
 		break;
 	default:
 		plan(1);
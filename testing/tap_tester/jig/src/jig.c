@@ -10,6 +10,7 @@
 //
 // Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
 
+#include "common/forkserver.h"
 #include "jig.h"
 #include "tap.h"
 #include "testfile.h"
@@ -17,6 +18,7 @@
 #include <dlfcn.h>
 #include <errno.h>
 #include <getopt.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +30,10 @@
 static jig_api j;
 
 #define VERSION_ONE_TESTS 1
+#define RUN_TESTS         5
+#define START_TESTS       3
+#define CMPLOG_TESTS      3
+#define BATCH_TESTS       2
 static void __attribute__((noreturn))
 usage(char *arg0)
 {
@@ -35,6 +41,21 @@ usage(char *arg0)
 	exit(EXIT_FAILURE);
 }
 
+static bool
+status_matches(char *run_output, char *status)
+{
+	if (status == NULL) {
+		return !strncmp(run_output, "NULL", 4);
+	}
+	size_t len = 0;
+	for (; len < strlen(run_output); len++) {
+		if (run_output[len] == '\n') {
+			break;
+		}
+	}
+	return strncmp(run_output, status, len) == 0;
+}
+
 static void
 test_version_one(char *test_filename)
 {
@@ -50,13 +71,30 @@ test_version_one(char *test_filename)
 		bail_out(strerror(errno));
 	}
 
-	u64 test_count = (count_tests(testfile, 3) * 5) + VERSION_ONE_TESTS;
+	// jigs with start and finish also run each input through them, checking the results of the previous finish
+	// are still intact after the next one. Jigs with run_cmplog run each input through it, and the testfile's meta
+	// says whether the target logs comparisons. Jigs with run_batch run all of the inputs at once at the end.
+	bool split    = j.version >= VERSION_TWO && j.start != NULL && j.finish != NULL;
+	bool cmplog   = j.version >= VERSION_THREE && j.run_cmplog != NULL;
+	bool batch    = j.version >= VERSION_FOUR && j.run_batch != NULL;
+	u64  per_test = RUN_TESTS;
+	if (split) {
+		per_test += START_TESTS;
+	}
+	if (cmplog) {
+		per_test += CMPLOG_TESTS;
+	}
+	if (batch) {
+		per_test += BATCH_TESTS;
+	}
+	u64 cases = count_tests(testfile, 3);
 
-	plan((unsigned int)test_count);
+	plan((unsigned int)(cases * per_test + VERSION_ONE_TESTS));
 
 	char *meta = NULL;
 	check_header(testfile, &meta);
 
+	bool logs_comparisons = meta != NULL && strncmp(meta, "cmplog", 6) == 0;
 	free(meta);
 	char *diag      = NULL;
 	int   diag_size = 0;
@@ -70,17 +108,24 @@ test_version_one(char *test_filename)
 
 	u8    *results      = NULL;
 	size_t results_size = 0;
-	j.initialize();
-	while (1) {
-		char  *input_filename = NULL;
-		u8    *input          = NULL;
-		size_t input_size     = 0;
 
-		char  *output_filename = NULL;
-		u8    *output          = NULL;
-		size_t output_size     = 0;
+	// every case is kept for the batch
+	u8    **inputs       = calloc(cases + 1, sizeof(u8 *));
+	size_t *input_sizes  = calloc(cases + 1, sizeof(size_t));
+	u8    **outputs      = calloc(cases + 1, sizeof(u8 *));
+	size_t *output_sizes = calloc(cases + 1, sizeof(size_t));
+	char  **run_outputs  = calloc(cases + 1, sizeof(char *));
+	if (inputs == NULL || input_sizes == NULL || outputs == NULL || output_sizes == NULL || run_outputs == NULL) {
+		bail_out("calloc failed");
+	}
 
-		char *run_output = NULL;
+	u8    *previous_results = NULL;
+	size_t previous_size    = 0;
+	u64    count            = 0;
+	j.initialize();
+	for (; count < cases; count++) {
+		char *input_filename  = NULL;
+		char *output_filename = NULL;
 
 		char *input_filename_rel = get_line_from_test_file(testfile);
 		if (input_filename_rel == NULL) {
@@ -90,7 +135,7 @@ test_version_one(char *test_filename)
 		if (output_filename_rel == NULL) {
 			bail_out("testfile corrupt");
 		}
-		run_output = get_line_from_test_file(testfile);
+		char *run_output = get_line_from_test_file(testfile);
 		if (run_output == NULL) {
 			bail_out("testfile corrupt");
 		}
@@ -99,38 +144,102 @@ test_version_one(char *test_filename)
 		free(input_filename_rel);
 		free(output_filename_rel);
 
+		u8    *input       = NULL;
+		size_t input_size  = 0;
+		u8    *output      = NULL;
+		size_t output_size = 0;
 		read_file(0, input_filename, &input_size, &input);
 		read_file(0, output_filename, &output_size, &output);
+		free(input_filename);
+		free(output_filename);
+
+		inputs[count]       = input;
+		input_sizes[count]  = input_size;
+		outputs[count]      = output;
+		output_sizes[count] = output_size;
+		run_outputs[count]  = run_output;
 
 		char *run_results = j.run(input, input_size, &results, &results_size);
 
 		ok(results_size == output_size, "size check");
 		ok(memcmp(results, output, output_size) == 0, "results check");
 
-		if (run_results == NULL) {
-			ok(!strncmp(run_output, "NULL", 4), "status_check");
-		} else {
-			size_t len = 0;
-			for (; len < strlen(run_output); len++) {
-				if (run_output[len] == '\n') {
-					break;
-				}
-			}
-			ok(strncmp(run_output, run_results, len) == 0, "status check");
-		}
+		ok(status_matches(run_output, run_results), "status check");
 
 		j.run(input, input_size, &results, &results_size);
 
 		ok(results_size == output_size, "size check, second run");
 		ok(memcmp(results, output, output_size) == 0, "results check, second run");
 
-		free(input_filename);
-		free(input);
-		free(output_filename);
-		free(output);
-		free(run_output);
+		if (split) {
+			u8    *split_results = NULL;
+			size_t split_size    = 0;
+			j.start(input, input_size);
+			char *split_status = j.finish(&split_results, &split_size);
+
+			ok(split_size == output_size && memcmp(split_results, output, output_size) == 0,
+			   "results check, start and finish");
+			ok(status_matches(run_output, split_status), "status check, start and finish");
+			if (previous_results == NULL) {
+				skip("no previous finish");
+			} else {
+				ok(previous_size == output_sizes[count - 1] &&
+				       memcmp(previous_results, outputs[count - 1], previous_size) == 0,
+				   "previous finish results kept");
+			}
+			previous_results = split_results;
+			previous_size    = split_size;
+		}
+
+		if (cmplog) {
+			u8    *comparisons      = NULL;
+			size_t comparisons_size = 0;
+			char  *cmplog_status    = j.run_cmplog(input, input_size, &results, &results_size, &comparisons, &comparisons_size);
+
+			ok(results_size == output_size && memcmp(results, output, output_size) == 0, "results check, run_cmplog");
+			ok(status_matches(run_output, cmplog_status), "status check, run_cmplog");
+			if (logs_comparisons) {
+				u32 logged = 0;
+				if (comparisons != NULL && comparisons_size >= sizeof(cmplog_map)) {
+					memcpy(&logged, comparisons + offsetof(cmplog_map, count), sizeof(logged));
+				}
+				ok(logged > 0, "comparisons logged");
+			} else {
+				ok(comparisons == NULL, "no comparisons from a target that can't log them");
+			}
+		}
+	}
+
+	// the statuses come back in the order of the inputs, and an input that crashes doesn't take the rest with it
+	if (batch) {
+		u8    **batch_results = calloc(count + 1, sizeof(u8 *));
+		size_t *batch_sizes   = calloc(count + 1, sizeof(size_t));
+		char  **statuses      = calloc(count + 1, sizeof(char *));
+		if (batch_results == NULL || batch_sizes == NULL || statuses == NULL) {
+			bail_out("calloc failed");
+		}
+		j.run_batch(inputs, input_sizes, count, batch_results, batch_sizes, statuses);
+		for (u64 i = 0; i < count; i++) {
+			ok(batch_sizes[i] == output_sizes[i] && memcmp(batch_results[i], outputs[i], output_sizes[i]) == 0,
+			   "results check, run_batch");
+			ok(status_matches(run_outputs[i], statuses[i]), "status check, run_batch");
+		}
+		free(batch_results);
+		free(batch_sizes);
+		free(statuses);
 	}
 	j.destroy();
+
+	for (u64 i = 0; i < count; i++) {
+		free(inputs[i]);
+		free(outputs[i]);
+		free(run_outputs[i]);
+	}
+	free(inputs);
+	free(input_sizes);
+	free(outputs);
+	free(output_sizes);
+	free(run_outputs);
 }
 
 int
@@ -175,8 +284,13 @@ main(int argc, char *argv[])
 
 	(*get_jig)(&j);
 
+	// later versions add optional functions, run is tested the same way
 	switch (j.version) {
-	case 1:
+	case VERSION_ONE:
+	case VERSION_TWO:
+	case VERSION_THREE:
+	case VERSION_FOUR:
+	case VERSION_FIVE:
 		test_version_one(test_filename);
 		break;
 	default:
@@ -19,8 +19,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define VERSION_ONE_TESTS 4
+#define VERSION_TWO_MUTATION_TESTS 2
+#define FEEDBACK_HEADER_TESTS 2
+#define FEEDBACK_TESTS 3
+#define FEEDBACK_MAX_ITERATIONS 1000000
+#define FEEDBACK_META "feedback "
 
 static fuzzing_strategy strategy;
 static FILE            *test_file;
@@ -38,6 +44,29 @@ iteration_check(int multiplier __attribute__((unused)), int fudge __attribute__(
 	todo("I need to implement the iteration check.");
 }
 
+// check that mutate_delta performs the same mutation as mutate, and that its delta undoes it.
+static void
+check_mutation_delta(strategy_state *state, u8 *input, size_t input_size, u8 *output, size_t output_size, u8 *mutated)
+{
+	mutation_delta delta = {0};
+
+	memset(mutated, 0, state->max_size);
+	memcpy(mutated, input, input_size);
+	size_t mutated_size = (*strategy.mutate_delta)(mutated, input_size, state, &delta);
+	if (mutated_size != 0) {
+		ok(mutated_size == output_size && memcmp(mutated, output, mutated_size) == 0, "delta mutation check");
+	} else {
+		ok(input_size == output_size && memcmp(mutated, input, input_size) == 0, "delta mutation check");
+	}
+
+	size_t reverted_size = mutation_delta_revert(mutated, input, input_size, &delta);
+	bool   reverted      = reverted_size == input_size && memcmp(mutated, input, input_size) == 0;
+	for (size_t i = input_size; reverted && i < state->max_size; i++) {
+		reverted = mutated[i] == 0;
+	}
+	ok(reverted, "Checking that the delta reverts the mutation");
+}
+
 static void
 check_mutation(char *serialized_begin_state, size_t serialized_begin_state_size, u8 *input, size_t input_size, u8 *output, size_t output_size)
 {
@@ -145,6 +174,10 @@ check_mutation(char *serialized_begin_state, size_t serialized_begin_state_size,
 	}
 	ok(stateless, "Checking that the mutation is stateless between runs");
 
+	if (strategy.version >= VERSION_TWO && strategy.mutate_delta != NULL) {
+		check_mutation_delta(deserialized_state, input, input_size, output, output_size, mutated);
+	}
+
 	(*(free_state *)strategy.free_state)(deserialized_state);
 	free(reserialized_state);
 	free(mutated);
@@ -192,6 +225,164 @@ check_iteration(char *iteration_line)
 	}
 }
 
+// the results of a target that reaches its second edge only while the input holds the token
+static void
+feedback_results(u8 *input, size_t size, char *token, u8 *results)
+{
+	results[0] = 1;
+	results[1] = memmem(input, size, token, strlen(token)) != NULL;
+}
+
+// read the auto dictionary the strategy wrote, NULL if there is none
+static char *
+read_auto_dictionary(void)
+{
+	char *name = getenv("AUTO_DICTIONARY_FILE");
+	FILE *file = name != NULL ? fopen(name, "r") : NULL;
+	if (file == NULL) {
+		return NULL;
+	}
+	fclose(file);
+	u8    *contents = NULL;
+	size_t size     = 0;
+	read_file(0, name, &size, &contents);
+	return (char *)contents;
+}
+
+// run a strategy over an input until it has no mutations left, telling it how each one did,
+// and check the state it ends in and that the auto dictionary found the token
+static void
+check_feedback(char *serialized_begin_state, size_t serialized_begin_state_size, u8 *input, size_t input_size, char *serialized_end_state, size_t serialized_end_state_size, char *token)
+{
+	strategy_state *state              = (*strategy.deserialize)(serialized_begin_state, serialized_begin_state_size);
+	char           *reserialized_state = (*strategy.serialize)(state);
+	ok(strlen(reserialized_state) == serialized_begin_state_size && memcmp(serialized_begin_state, reserialized_state, serialized_begin_state_size) == 0,
+	   "The state is correctly serialized and deserialized, with everything after it.");
+	free(reserialized_state);
+
+	// tokens an earlier run found don't count
+	char *auto_dictionary = getenv("AUTO_DICTIONARY_FILE");
+	if (auto_dictionary != NULL) {
+		char *hits = NULL;
+		if (asprintf(&hits, "%s.hits", auto_dictionary) < 0) {
+			bail_out("asprintf failed");
+		}
+		unlink(auto_dictionary);
+		unlink(hits);
+		free(hits);
+	}
+
+	// the unmodified input first, then every mutation in order, as the fuzzer reports them
+	u8                results[2];
+	u8               *mutated  = calloc(1, state->max_size);
+	strategy_feedback feedback = {.iteration = state->iteration, .clean = true, .input = input, .size = input_size, .results = results, .results_size = sizeof(results)};
+	feedback_results(input, input_size, token, results);
+	(*strategy.report_feedback)(state, &feedback);
+	for (u64 i = 0; i < FEEDBACK_MAX_ITERATIONS; i++) {
+		memset(mutated, 0, state->max_size);
+		memcpy(mutated, input, input_size);
+		u64    iteration = state->iteration;
+		size_t size      = (*strategy.mutate)(mutated, input_size, state);
+		if (size == 0) {
+			break;
+		}
+		(*strategy.update_state)(state);
+		feedback_results(mutated, size, token, results);
+		feedback = (strategy_feedback){.iteration = iteration, .input = mutated, .size = size, .results = results, .results_size = sizeof(results)};
+		(*strategy.report_feedback)(state, &feedback);
+	}
+
+	char *end_state = (*strategy.serialize)(state);
+	bool  matches   = strlen(end_state) == serialized_end_state_size && memcmp(serialized_end_state, end_state, serialized_end_state_size) == 0;
+	ok(matches, "The feedback leaves the expected state.");
+	if (!matches) {
+		diagnostics(end_state);
+	}
+	free(end_state);
+
+	char *quoted = NULL;
+	if (asprintf(&quoted, "\"%s\"", token) < 0) {
+		bail_out("asprintf failed");
+	}
+	char *dictionary = read_auto_dictionary();
+	ok(dictionary != NULL && strstr(dictionary, quoted) != NULL, "The auto dictionary has the token.");
+	free(dictionary);
+	free(quoted);
+
+	(*(free_state *)strategy.free_state)(state);
+	free(mutated);
+}
+
+// Feedback testfiles have "feedback [token]" as their meta line, and each test is a begin state,
+// an input holding the token and the state the strategy is left in once it has no mutations left.
+static void
+test_feedback(char *testfile_name, char *token)
+{
+	if (strategy.version < VERSION_THREE || strategy.report_feedback == NULL) {
+		bail_out("Feedback tests need a strategy that takes feedback.");
+	}
+
+	while (1) {
+		char *begin_state_file_rel = get_line_from_test_file(test_file);
+		if (!begin_state_file_rel) {
+			break;
+		}
+		char *input_file_rel     = get_line_from_test_file(test_file);
+		char *end_state_file_rel = get_line_from_test_file(test_file);
+		if (input_file_rel == NULL || end_state_file_rel == NULL) {
+			bail_out("Test file has the wrong number of lines.");
+		}
+		char *begin_state_file_name = get_io_file(testfile_name, begin_state_file_rel);
+		char *input_file_name       = get_io_file(testfile_name, input_file_rel);
+		char *end_state_file_name   = get_io_file(testfile_name, end_state_file_rel);
+
+		char  *serialized_begin_state      = NULL;
+		size_t serialized_begin_state_size = 0;
+		u8    *input_data                  = NULL;
+		size_t input_data_size             = 0;
+		char  *serialized_end_state        = NULL;
+		size_t serialized_end_state_size   = 0;
+		read_file(0, begin_state_file_name, &serialized_begin_state_size, (u8 **)&serialized_begin_state);
+		read_file(0, input_file_name, &input_data_size, &input_data);
+		read_file(0, end_state_file_name, &serialized_end_state_size, (u8 **)&serialized_end_state);
+
+		char *diag = NULL;
+		if (asprintf(&diag, "Running feedback test %s", end_state_file_name) < 0) {
+			fprintf(stderr, "asprintf failed near line %d\n", __LINE__);
+		}
+		diagnostics(diag);
+		free(diag);
+
+		check_feedback(serialized_begin_state, serialized_begin_state_size, input_data, input_data_size, serialized_end_state, serialized_end_state_size, token);
+
+		free(begin_state_file_rel);
+		free(input_file_rel);
+		free(end_state_file_rel);
+		free(begin_state_file_name);
+		free(input_file_name);
+		free(end_state_file_name);
+		free(serialized_begin_state);
+		free(input_data);
+		free(serialized_end_state);
+	}
+}
+
+// the meta line of the testfile, read ahead of the header so the plan can count the right tests
+static char *
+peek_meta(void)
+{
+	char *meta = NULL;
+	for (int line = 0; line < 3; line++) {
+		free(meta);
+		meta = get_line_from_test_file(test_file);
+		if (meta == NULL) {
+			break;
+		}
+	}
+	rewind(test_file);
+	return meta;
+}
+
 static void
 test_version_one_strategy(char *testfile_name)
 {
@@ -200,10 +391,18 @@ test_version_one_strategy(char *testfile_name)
 	print_tap_header();
 
 	// record the number of tests to perform
-	plan((unsigned int)(count_tests(test_file, 3) * 4 + VERSION_ONE_TESTS));
+	char        *meta           = peek_meta();
+	bool         feedback       = meta != NULL && strncmp(meta, FEEDBACK_META, strlen(FEEDBACK_META)) == 0;
+	unsigned int mutation_tests = strategy.version >= VERSION_TWO && strategy.mutate_delta != NULL ? 4 + VERSION_TWO_MUTATION_TESTS : 4;
+	free(meta);
+	if (feedback) {
+		plan((unsigned int)(count_tests(test_file, 3) * FEEDBACK_TESTS + FEEDBACK_HEADER_TESTS));
+	} else {
+		plan((unsigned int)(count_tests(test_file, 3) * mutation_tests + VERSION_ONE_TESTS));
+	}
 
 	// Check that the version field of the strategy struct is correct
-	ok(strategy.version == VERSION_ONE, "The correct version number has been set in the fuzzing_strategy struct.");
+	ok(strategy.version >= VERSION_ONE && strategy.version <= VERSION_THREE, "The correct version number has been set in the fuzzing_strategy struct.");
 
 	// get the iteration line.
 	char *iter_line = NULL;
@@ -212,6 +411,11 @@ test_version_one_strategy(char *testfile_name)
 	if (!iter_line) {
 		bail_out("Could not get the third line (ITER) of the test file!");
 	}
+	if (feedback) {
+		test_feedback(testfile_name, iter_line + strlen(FEEDBACK_META));
+		free(iter_line);
+		return;
+	}
 	check_iteration(iter_line);
 	free(iter_line);
 
@@ -334,6 +538,8 @@ main(int argc, char *argv[])
 	switch (strategy.version) {
 
 	case VERSION_ONE:
+	case VERSION_TWO:
+	case VERSION_THREE:
 		test_version_one_strategy(argv[2]);
 		break;
 	default:
@@ -0,0 +1,196 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+/*
+    A target with a hand written forkserver that offers the options of common/forkserver.h, so afl_jig's
+    comparison log, input channel and batches can be tested without an instrumenting compiler.
+
+        cc -I common/include -o forkserver_options testing/test_binaries/forkserver_options/forkserver_options.c
+
+    It is run as `forkserver_options [file]`. The options it offers are FORKSERVER_OPTIONS, as a number,
+    or all of them if that isn't set, and FORKSERVER_OPTIONS=0 sends a plain AFL hello. The trace has a
+    handful of edges, below TRACE_SIZE, so the jig can run it with JIG_MAP_SIZE=256:
+    one for every run, one for an input read from shared memory rather than the file, and a ladder of
+    edges for the bytes of "FUZZ", which crashes when it is complete. The first four bytes are logged
+    as a comparison with "FUZZ".
+*/
+
+#include "common/forkserver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/shm.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define TRACE_SIZE 256
+#define FORKSRV_FD 198
+#define SHM_ENV_VAR "__AFL_SHM_ID"
+#define OPTIONS_ENV_VAR "FORKSERVER_OPTIONS"
+#define MAX_INPUT 4096
+
+#define EDGE_RUN 1    // every run
+#define EDGE_SHARED 2 // the input came from shared memory
+#define EDGE_LADDER 8 // and one more for each byte of "FUZZ" matched
+
+static uint8_t     fallback_trace[TRACE_SIZE];
+static uint8_t    *trace  = fallback_trace;
+static cmplog_map *cmplog = NULL;
+static fuzz_shm   *input  = NULL;
+static fuzz_batch *batch  = NULL;
+
+static void
+edge(uint32_t id)
+{
+	trace[id % TRACE_SIZE]++;
+}
+
+// what an instrumented target would do with one input
+static void
+body(const uint8_t *buf, size_t size, int shared)
+{
+	const char magic[] = "FUZZ";
+
+	edge(EDGE_RUN);
+	if (shared) {
+		edge(EDGE_SHARED);
+	}
+	if (size >= 4) {
+		uint32_t value;
+		uint32_t expected;
+		memcpy(&value, buf, sizeof(value));
+		memcpy(&expected, magic, sizeof(expected));
+		cmplog_add(cmplog, value, expected, sizeof(value));
+	}
+	for (size_t i = 0; i < size && i < 4 && buf[i] == (uint8_t)magic[i]; i++) {
+		edge(EDGE_LADDER + (uint32_t)i);
+		if (i == 3) {
+			abort();
+		}
+	}
+}
+
+// run the input from the input channel, or the file
+static void
+run_one(const char *path)
+{
+	if (input != NULL) {
+		body(input->data, input->size, 1);
+		return;
+	}
+	uint8_t buf[MAX_INPUT];
+	size_t  size = 0;
+	FILE   *file = fopen(path, "rb");
+	if (file != NULL) {
+		size = fread(buf, 1, sizeof(buf), file);
+		fclose(file);
+	}
+	body(buf, size, 0);
+}
+
+// run every input of the batch, leaving each one's trace in its results
+static void
+run_batch(void)
+{
+	for (uint32_t i = 0; i < batch->count; i++) {
+		memset(trace, 0, batch->map_size);
+		body(batch->data + batch->offsets[i], batch->sizes[i], 1);
+		memcpy(fuzz_batch_results(batch, i), trace, batch->map_size);
+		memset(trace, 0, batch->map_size);
+		batch->done = i + 1;
+	}
+}
+
+static void *
+attach(const char *env_var)
+{
+	char *id = getenv(env_var);
+	if (id == NULL) {
+		return NULL;
+	}
+	void *region = shmat(atoi(id), NULL, 0);
+	return region == (void *)-1 ? NULL : region;
+}
+
+// offer the options, and map the regions of the ones the jig accepted
+static void
+negotiate(void)
+{
+	char    *env_options = getenv(OPTIONS_ENV_VAR);
+	uint32_t offered     = FS_OPT_CMPLOG | FS_OPT_SHDMEM_FUZZ | FS_OPT_BATCH;
+	if (env_options != NULL) {
+		offered = (uint32_t)strtoul(env_options, NULL, 0) & offered;
+	}
+	uint32_t hello = offered != 0 ? FS_OPT_ENABLED | offered : 0;
+	if (write(FORKSRV_FD + 1, &hello, 4) != 4) {
+		_exit(1);
+	}
+	if (hello == 0) {
+		return;
+	}
+
+	uint32_t accepted = 0;
+	if (read(FORKSRV_FD, &accepted, 4) != 4) {
+		_exit(1);
+	}
+	if (accepted & FS_OPT_CMPLOG) {
+		cmplog = attach(CMPLOG_SHM_ENV_VAR);
+	}
+	if (accepted & FS_OPT_SHDMEM_FUZZ) {
+		input = attach(FUZZ_SHM_ENV_VAR);
+	}
+	if (accepted & FS_OPT_BATCH) {
+		batch = attach(BATCH_SHM_ENV_VAR);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *path = argc > 1 ? argv[1] : "fuzzfile";
+
+	uint8_t *shared_trace = attach(SHM_ENV_VAR);
+	if (shared_trace == NULL) {
+		run_one(path);
+		return 0;
+	}
+	trace = shared_trace;
+	negotiate();
+
+	// AFL's forkserver loop, with a batch run when the request asks for one
+	while (1) {
+		uint32_t request = 0;
+		if (read(FORKSRV_FD, &request, 4) != 4) {
+			_exit(0);
+		}
+		pid_t child = fork();
+		if (child < 0) {
+			_exit(1);
+		}
+		if (child == 0) {
+			close(FORKSRV_FD);
+			close(FORKSRV_FD + 1);
+			if (batch != NULL && (request & FS_BATCH_RUN)) {
+				run_batch();
+			} else {
+				run_one(path);
+			}
+			return 0;
+		}
+		int status = 0;
+		if (write(FORKSRV_FD + 1, &child, 4) != 4 || waitpid(child, &status, 0) < 0 ||
+		    write(FORKSRV_FD + 1, &status, 4) != 4) {
+			_exit(1);
+		}
+	}
+}
@@ -17,13 +17,29 @@
 #include "common.h"
 #include <stdbool.h>
 #define VERSION_ONE 1
+#define VERSION_TWO 2
+#define VERSION_THREE 3
+#define VERSION_FOUR 4
+
+// separate views of coverage for inputs that crash or hang, so that one bug doesn't fill the pack
+typedef enum analysis_bucket {
+	ANALYSIS_CRASH,
+	ANALYSIS_HANG,
+	ANALYSIS_BUCKETS,
+} analysis_bucket;
 
 typedef bool(analysis_add_function)(u8 *element, size_t element_size);
 typedef void(analysis_init_function)(char *filename);
 typedef void(analysis_save_function)(char *filename);
 typedef void(analysis_destroy_function)(void);
 typedef void(analysis_merge_function)(char *a, char *b, char *merged);
+typedef double(analysis_density_function)(void);
+typedef bool(analysis_add_bucket_function)(analysis_bucket bucket, u8 *element, size_t element_size);
+typedef void(analysis_mask_function)(u8 *variable, size_t variable_size);
+typedef double(analysis_stability_function)(void);
 
+// the_fuzz -j initializes the analysis once and then forks its workers, so state that decides
+// novelty should be allocated with analysis_shared_alloc to give every worker the same view.
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
 typedef struct analysis_api {
@@ -37,6 +53,16 @@ typedef struct analysis_api {
 			analysis_save_function    *save;
 			analysis_destroy_function *destroy;
 			analysis_merge_function   *merge;
+
+			// version two
+			analysis_density_function *density; // fraction of the analysis that has been filled in, from 0 to 1
+
+			// version three
+			analysis_add_bucket_function *add_bucket; // like add, against the bucket's own view, and saved and loaded with the rest
+
+			// version four
+			analysis_mask_function      *mask;      // stop looking at the positions that are non-zero in variable, which the same input doesn't reproduce
+			analysis_stability_function *stability; // fraction of the covered positions that are not masked, from 0 to 1
 		};
 	};
 } analysis_api;
@@ -13,6 +13,10 @@
 //
 // Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
 
-void bit_merge(char *a, char *b, char *merge);
+#include <stddef.h>
+
+void  bit_merge(char *a, char *b, char *merge);
+void *analysis_shared_alloc(size_t size);
+void  analysis_shared_free(void *buffer, size_t size);
 
 #endif
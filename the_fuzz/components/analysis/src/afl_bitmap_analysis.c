@@ -23,8 +23,14 @@
 
 // the size of the AFL bitmap
 static size_t map_size = 0;
-// Regions yet untouched by fuzzing
+// Regions yet untouched by fuzzing, followed by the regions untouched by each bucket's inputs
+// and the bytes whose values the same input doesn't reproduce
 static u8 *virgin_bits = NULL;
+static u8 *var_bytes   = NULL;
+// a trace reduced to which tuples were hit, for the buckets
+static u8 *simplified = NULL;
+
+#define VIRGIN_SIZE (map_size * (2 + ANALYSIS_BUCKETS))
 // checksum of the last seen results
 static u32 last_checksum = 0;
 
@@ -54,7 +60,7 @@ afl_hash32(const void *key, u32 len, u32 seed)
 	return (u32)h1;
 }
 
-// loads a bitmap from a file
+// loads a bitmap from a file, which may be missing the buckets' bitmaps and the variable bytes
 static int
 load_from_file(char *filename)
 {
@@ -64,11 +70,12 @@ load_from_file(char *filename)
 		if (file_fd == -1) {
 			log_fatal("loading analysis open failed");
 		}
-		ssize_t read_size = read(file_fd, virgin_bits, map_size);
+		ssize_t read_size = read(file_fd, virgin_bits, VIRGIN_SIZE);
 		if (read_size == -1) {
 			log_fatal("loading analysis read failed");
 		}
-		if (read_size >= 0 && (size_t)read_size != map_size) {
+		if (read_size >= 0 && (size_t)read_size != map_size &&
+		    (size_t)read_size != map_size * (1 + ANALYSIS_BUCKETS) && (size_t)read_size != VIRGIN_SIZE) {
 			log_fatal("file wrong size");
 		}
 		close(file_fd);
@@ -85,11 +92,11 @@ save_to_file(char *filename)
 		log_fatal("saving analysis open failed");
 	}
 
-	ssize_t write_size = write(file_fd, virgin_bits, map_size);
+	ssize_t write_size = write(file_fd, virgin_bits, VIRGIN_SIZE);
 	if (write_size == -1) {
 		log_fatal("saving analysis write failed");
 	}
-	if (write_size >= 0 && (size_t)write_size != map_size) {
+	if (write_size >= 0 && (size_t)write_size != VIRGIN_SIZE) {
 		log_fatal("saving failed");
 	}
 	close(file_fd);
@@ -109,8 +116,10 @@ init(char *filename)
 		log_fatal("ANALYSIS_SIZE must be <= uint32 max.");
 	}
 	map_size    = size;
-	virgin_bits = malloc(map_size);
-	memset(virgin_bits, 255, map_size);
+	virgin_bits = analysis_shared_alloc(VIRGIN_SIZE);
+	simplified  = calloc(map_size, 1);
+	var_bytes   = virgin_bits + map_size * (1 + ANALYSIS_BUCKETS);
+	memset(virgin_bits, 255, map_size * (1 + ANALYSIS_BUCKETS));
 	if (filename != NULL) {
 		load_from_file(filename);
 	}
@@ -119,8 +128,12 @@ init(char *filename)
 static void
 destroy()
 {
-	map_size = 0;
-	free(virgin_bits);
+	analysis_shared_free(virgin_bits, VIRGIN_SIZE);
+	free(simplified);
+	virgin_bits = NULL;
+	var_bytes   = NULL;
+	simplified  = NULL;
+	map_size    = 0;
 }
 
 /*	Comment from AFL source:
@@ -199,10 +212,62 @@ add(u8 *element, size_t element_size)
 	log_fatal("unknown return value");
 }
 
+// like add, but against a bucket's bitmap and only counting which tuples were hit, as AFL's simplify_trace does
+static bool
+add_bucket(analysis_bucket bucket, u8 *element, size_t element_size)
+{
+	if (element_size != map_size) {
+		log_fatal("illegal element size");
+	}
+	for (size_t i = 0; i < map_size; i++) {
+		simplified[i] = element[i] ? 0x80 : 0x01;
+	}
+	return has_new_bits(simplified, virgin_bits + map_size * (1 + (size_t)bucket)) == 0;
+}
+
+// fraction of the bitmap's bytes that have been hit
+static double
+density()
+{
+	size_t touched = 0;
+	for (size_t i = 0; i < map_size; i++) {
+		touched += virgin_bits[i] != 0xff;
+	}
+	return map_size ? (double)touched / (double)map_size : 0.0;
+}
+
+// variable bytes are marked as fully seen, so has_new_bits never finds anything new in them
+static void
+mask(u8 *variable, size_t variable_size)
+{
+	if (variable_size != map_size) {
+		log_fatal("illegal mask size");
+	}
+	for (size_t i = 0; i < map_size; i++) {
+		if (variable[i] && !var_bytes[i]) {
+			var_bytes[i]   = 1;
+			virgin_bits[i] = 0;
+		}
+	}
+}
+
+// fraction of the bitmap's hit bytes that are not variable, as AFL's stability
+static double
+stability()
+{
+	size_t touched  = 0;
+	size_t variable = 0;
+	for (size_t i = 0; i < map_size; i++) {
+		touched += virgin_bits[i] != 0xff;
+		variable += var_bytes[i];
+	}
+	return touched ? 1.0 - (double)variable / (double)touched : 1.0;
+}
+
 static void
 create_analysis(analysis_api *s)
 {
-	s->version     = VERSION_ONE;
+	s->version     = VERSION_FOUR;
 	s->name        = "AFL bitmap";
 	s->description = "This is an implementation of AFL's bitmap logic.";
 	s->initialize  = init;
@@ -210,6 +275,10 @@ create_analysis(analysis_api *s)
 	s->save        = save_to_file;
 	s->destroy     = destroy;
 	s->merge       = bit_merge;
+	s->density     = density;
+	s->add_bucket  = add_bucket;
+	s->mask        = mask;
+	s->stability   = stability;
 }
 
 analysis_api_getter get_analysis_api = create_analysis;
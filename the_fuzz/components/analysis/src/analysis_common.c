@@ -12,6 +12,7 @@
 
 #include <fcntl.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -46,6 +47,26 @@ load(char *filename, size_t *size, u8 **buffer)
 	close(file_fd);
 }
 
+// allocate zeroed analysis state that stays shared with processes forked afterwards,
+// so that all of the_fuzz's workers see one view of coverage
+void *
+analysis_shared_alloc(size_t size)
+{
+	void *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (buffer == MAP_FAILED) {
+		log_fatal("analysis mmap failed");
+	}
+	return buffer;
+}
+
+void
+analysis_shared_free(void *buffer, size_t size)
+{
+	if (buffer != NULL) {
+		munmap(buffer, size);
+	}
+}
+
 void
 bit_merge(char *a, char *b, char *merge)
 {
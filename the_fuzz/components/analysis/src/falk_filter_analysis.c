@@ -20,9 +20,12 @@
 #include "common/logger.h"
 #include "common/types.h"
 
+// one filter for coverage followed by one for each bucket, each analysis_buffer_size bytes
 static u8    *analysis_buffer;
 static size_t analysis_buffer_size;
 
+#define FILTERS_SIZE (analysis_buffer_size * (1 + ANALYSIS_BUCKETS))
+
 // this should be replaces with a Bloom filter / Quotient filter
 #include <x86intrin.h>
 
@@ -130,31 +133,45 @@ hash_func64(void *to_hash, size_t size)
 }
 
 static int
-analysis_contains(void *element, size_t element_size)
+analysis_contains(u8 *filter, void *element, size_t element_size)
 {
 	u64    sum = hash_func64(element, element_size);
 	size_t bit = sum % (analysis_buffer_size * 8);
-	return (analysis_buffer[bit / 8]) & (u8)(1 << (bit % 8));
+	return (filter[bit / 8]) & (u8)(1 << (bit % 8));
 }
 
 static void
-add_to_analysis(void *element, size_t element_size)
+add_to_analysis(u8 *filter, void *element, size_t element_size)
 {
 	u64    sum = hash_func64(element, element_size);
 	size_t bit = sum % (analysis_buffer_size * 8);
-	analysis_buffer[bit / 8] |= (u8)(1 << (bit % 8));
+	filter[bit / 8] |= (u8)(1 << (bit % 8));
 }
 
 static bool
-check_add_to_analysis(u8 *element, size_t element_size)
+check_add_to_filter(u8 *filter, u8 *element, size_t element_size)
 {
-	if (analysis_contains((void *)element, element_size)) {
+	if (analysis_contains(filter, (void *)element, element_size)) {
 		return 1;
 	}
-	add_to_analysis((void *)element, element_size);
+	add_to_analysis(filter, (void *)element, element_size);
 	return 0;
 }
 
+static bool
+check_add_to_analysis(u8 *element, size_t element_size)
+{
+	return check_add_to_filter(analysis_buffer, element, element_size);
+}
+
+// like add, but against a bucket's own filter
+static bool
+check_add_to_bucket(analysis_bucket bucket, u8 *element, size_t element_size)
+{
+	return check_add_to_filter(analysis_buffer + analysis_buffer_size * (1 + (size_t)bucket), element, element_size);
+}
+
+// loads the filters from a file, which may be missing the buckets' filters
 static int
 load_from_file(char *filename)
 {
@@ -163,11 +180,11 @@ load_from_file(char *filename)
 	if (file_fd == -1) {
 		log_fatal("loading analysis open failed");
 	}
-	ssize_t read_size = read(file_fd, analysis_buffer, analysis_buffer_size);
+	ssize_t read_size = read(file_fd, analysis_buffer, FILTERS_SIZE);
 	if (read_size == -1) {
 		log_fatal("loading analysis read failed");
 	}
-	if (read_size >= 0 && (size_t)read_size != analysis_buffer_size) {
+	if (read_size >= 0 && (size_t)read_size != analysis_buffer_size && (size_t)read_size != FILTERS_SIZE) {
 		log_fatal("loading analysis size mismatch");
 	}
 	close(file_fd);
@@ -181,11 +198,11 @@ save_to_file(char *filename)
 	if (file_fd == -1) {
 		log_fatal("saving analysis open failed");
 	}
-	ssize_t write_size = write(file_fd, analysis_buffer, analysis_buffer_size);
+	ssize_t write_size = write(file_fd, analysis_buffer, FILTERS_SIZE);
 	if (write_size == -1) {
 		log_fatal("saving analysis write failed");
 	}
-	if (write_size >= 0 && (size_t)write_size != analysis_buffer_size) {
+	if (write_size >= 0 && (size_t)write_size != FILTERS_SIZE) {
 		log_fatal("saving analysis size mismatch");
 	}
 	close(file_fd);
@@ -205,8 +222,8 @@ init(char *filename)
 		log_fatal("ANALYSIS_SIZE invalid");
 	}
 
-	analysis_buffer      = (u8 *)calloc(1, size);
 	analysis_buffer_size = size;
+	analysis_buffer      = analysis_shared_alloc(FILTERS_SIZE);
 	if (filename != NULL) {
 		load_from_file(filename);
 	}
@@ -215,15 +232,26 @@ init(char *filename)
 static void
 destroy()
 {
-	free(analysis_buffer);
+	analysis_shared_free(analysis_buffer, FILTERS_SIZE);
 	analysis_buffer      = NULL;
 	analysis_buffer_size = 0;
 }
 
+// fraction of the filter's bits that are set
+static double
+density()
+{
+	size_t set = 0;
+	for (size_t i = 0; i < analysis_buffer_size; i++) {
+		set += (size_t)__builtin_popcount(analysis_buffer[i]);
+	}
+	return analysis_buffer_size ? (double)set / (double)(analysis_buffer_size * 8) : 0.0;
+}
+
 static void
 create_analysis(analysis_api *s)
 {
-	s->version     = VERSION_ONE;
+	s->version     = VERSION_THREE;
 	s->name        = "we should come up with a name for this";
 	s->description = "This is some weird bloom filter like thing";
 	s->initialize  = init;
@@ -231,6 +259,8 @@ create_analysis(analysis_api *s)
 	s->save        = save_to_file;
 	s->destroy     = destroy;
 	s->merge       = bit_merge;
+	s->density     = density;
+	s->add_bucket  = check_add_to_bucket;
 }
 
 analysis_api_getter      get_analysis_api = create_analysis;
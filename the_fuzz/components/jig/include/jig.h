@@ -14,8 +14,16 @@
 // Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
 
 #pragma once
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "common.h"
 #define VERSION_ONE 1
+#define VERSION_TWO 2
+#define VERSION_THREE 3
+#define VERSION_FOUR 4
+#define VERSION_FIVE 5
 #define CRASH "crash"
 #define HANG "hang"
 #define NO_CRASH NULL
@@ -26,6 +34,13 @@
 typedef void(jig_init_function)(void);
 typedef char *(jig_run_function)(u8 *input, size_t input_size, u8 **results, size_t *results_size);
 typedef void(jig_destroy_function)(void);
+typedef void(jig_start_function)(u8 *input, size_t input_size);
+typedef char *(jig_finish_function)(u8 **results, size_t *results_size);
+typedef char *(jig_run_cmplog_function)(u8 *input, size_t input_size, u8 **results, size_t *results_size, u8 **comparisons, size_t *comparisons_size);
+typedef void(jig_run_batch_function)(u8 **inputs, size_t *input_sizes, size_t count, u8 **results, size_t *results_sizes, char **statuses);
+typedef bool(jig_submit_function)(u8 *input, size_t input_size, u64 tag);
+typedef bool(jig_poll_completed_function)(u64 *tag, u8 **results, size_t *results_size, char **status);
+typedef size_t(jig_pool_size_function)(void);
 
 typedef struct jig_api {
 	int version;
@@ -36,12 +51,60 @@ typedef struct jig_api {
 			jig_init_function    *initialize;
 			jig_run_function     *run;
 			jig_destroy_function *destroy;
+
+			// version two, run split in two so the fuzzer can work while the target runs
+			jig_start_function  *start;  // start running an input, nothing else may be run until finish is called
+			jig_finish_function *finish; // like run, for the input passed to start; the results stay valid through the next start and finish
+
+			// version three, runs an input and logs the comparisons the target made, a cmplog_map from common/forkserver.h.
+			// comparisons is NULL if the target can't log them, and stays valid until the next run.
+			jig_run_cmplog_function *run_cmplog;
+
+			// version four, runs count inputs in order, as run would, filling in results[i], results_sizes[i] and statuses[i]
+			// for each. The results stay valid until the next run.
+			jig_run_batch_function *run_batch;
+
+			// version five, a pool of targets that run inputs side by side. submit hands an input to an idle one, and returns
+			// false if there isn't one. poll_completed waits for any submitted input to finish, returning false if none are
+			// running, and its results stay valid until the next submit. pool_size is how many can run at once.
+			// The other functions may only be used while nothing submitted is running.
+			jig_submit_function         *submit;
+			jig_poll_completed_function *poll_completed;
+			jig_pool_size_function      *pool_size;
 		};
 	};
 } jig_api;
 
 typedef void (*jig_api_getter)(jig_api *j);
 
+// run_batch for a jig that runs one input at a time: runs each input with run and copies its results to copies,
+// which is grown to hold them all. Jigs keep copies between calls and free it when they're destroyed.
+static inline void
+jig_run_batch_single(jig_run_function *run, u8 **inputs, size_t *input_sizes, size_t count, u8 **results, size_t *results_sizes, char **statuses, sized_buffer *copies)
+{
+	size_t used = 0;
+	for (size_t i = 0; i < count; i++) {
+		u8 *single       = NULL;
+		results_sizes[i] = 0;
+		statuses[i]      = run(inputs[i], input_sizes[i], &single, &results_sizes[i]);
+		if (copies->content_size < used + results_sizes[i]) {
+			copies->content_size = MAX(copies->content_size * 2, used + results_sizes[i]);
+			copies->content      = realloc(copies->content, copies->content_size);
+			if (copies->content == NULL) {
+				log_fatal("realloc() failed");
+			}
+		}
+		memcpy(copies->content + used, single, results_sizes[i]);
+		used += results_sizes[i];
+	}
+	// copies may have moved while it grew
+	used = 0;
+	for (size_t i = 0; i < count; i++) {
+		results[i] = copies->content + used;
+		used += results_sizes[i];
+	}
+}
+
 #pragma clang diagnostic pop
 extern jig_api_getter    get_jig_api;
 
@@ -10,22 +10,27 @@
 //
 // Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
 
-#include <bits/types/struct_timeval.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/ipc.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
 #include <sys/shm.h>
 #include <sys/stat.h>
-#include <sys/time.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "common/forkserver.h"
 #include "common/logger.h"
 #include "common/types.h"
 #include "jig.h"
@@ -33,32 +38,76 @@
 // These are in common, unclear why this is needed but the compiler is complaining
 #define unlikely(x) __builtin_expect(!!(x), 0)
 
+// a forkserver and the state of the target it runs, the jig has one for each input it can run at once
+typedef struct forkserver {
+	int       pid;             // pid of the fork server
+	s32       ctl_fd;          // Fork server control pipe (write)
+	s32       st_fd;           // Fork server status pipe (read)
+	s32       shm_id;          // ID of the SHM region
+	u8       *trace_bits;      // SHM with instrumentation bitmap
+	int       out_fd;          // the file descriptor which we write our fuzzed input to
+	char     *out_file;        // the name of the file we write our fuzzed input to
+	char     *pool_file;       // the fuzzfile made for a forkserver after the first, removed by destroy
+	s32       fuzz_shm_id;     // ID of the input channel's SHM region
+	fuzz_shm *fuzz_input;      // SHM the target reads its input from, NULL unless the forkserver accepted FS_OPT_SHDMEM_FUZZ
+	int       child_pid;       // pid of the child process
+	bool      child_timed_out; // did the child process timeout
+	u64       run_started;     // when the running child was started, in ns of CLOCK_MONOTONIC
+	u32       run_inputs;      // inputs the running child runs, more than one for a batch
+	u32       prev_timed_out;  // told to the forkserver so it can reap a killed child
+	u64       child_iters;     // inputs the stopped persistent child has run
+	bool      child_stopped;   // is the child stopped, waiting to be resumed for the next input
+	bool      submitted;       // running an input from submit that poll_completed hasn't reported
+	u64       tag;             // the tag it was submitted with
+} forkserver;
+
 // Global variables
-static s32    shm_id          = 0;     // ID of the SHM region
-static u8    *trace_bits      = NULL;  // SHM with instrumentation bitmap
-static size_t map_size        = 0;     // size of the bitmap
-static u64    timeout         = 0;     // timeout before we consider the program hung
-static int    child_pid       = -1;    // pid of the child process
-static bool   child_timed_out = false; // did the child process timeout
-static int    forksrv_pid     = -1;    // pid of the fork server
-static int    dev_null_fd     = 0;     // file descriptor for /dev/null
-static size_t memory_limit    = 0;     // how much memory the target can use
-static int    out_fd          = 0;     // the file descriptor which we write our fuzzed input to
-static char  *out_file        = NULL;  // the name of the file we write our fuzzed input to
-static s32    fsrv_ctl_fd     = 0;     // Fork server control pipe (write)
-static s32    fsrv_st_fd      = 0;     // Fork server status pipe (read)
+static forkserver *servers       = NULL; // the pool of forkservers, JIG_POOL of them
+static u32         server_count  = 1;    // how many
+static forkserver *primary       = NULL; // the first of them, which runs everything but the inputs from submit
+static u32         submitted     = 0;    // inputs submitted and not yet reported by poll_completed
+static int         pool_epoll_fd = -1;   // epoll instance watching every forkserver's status pipe
+static size_t      map_size      = 0;    // size of the bitmap
+static u64         timeout       = 0;    // timeout in ms before we consider the program hung
+static int         dev_null_fd   = 0;    // file descriptor for /dev/null
+static size_t      memory_limit  = 0;    // how much memory the target can use
+static u8         *finished[2]   = {0};  // results of the last two runs finished with finish()
+static u32         finished_next = 0;    // which of them the next finish() overwrites
+static int         target_cpu    = -1;   // core the forkserver and the target are bound to, -1 to run where the fuzzer runs
+static size_t      max_input     = 0;    // size of the largest input the fuzzer runs, 0 if it didn't say
+
+static bool persistent       = false; // does the target run several inputs in each child, stopping itself after each
+static u64  persistent_iters = 0;     // inputs a persistent child runs before it is replaced, 0 to leave it to the target
+
+static s32         cmplog_shm_id = -1;   // ID of the comparison log's SHM region
+static cmplog_map *cmplog        = NULL; // SHM the target logs comparisons to, NULL unless the forkserver accepted FS_OPT_CMPLOG
+static s32         batch_shm_id  = -1;   // ID of the batch's SHM region
+static fuzz_batch *batch         = NULL; // SHM batches are run from, NULL unless the forkserver accepted FS_OPT_BATCH
+
+static sized_buffer batch_copies = {0}; // results of the last run_batch
 
 #define DEFAULT_TIMEOUT 1000       // The default timeout in ms
+#define CALIBRATION_RUNS 8         // runs measured to calibrate the timeout, when JIG_TIMEOUT isn't set
+#define CALIBRATION_MULT 5         // the calibrated timeout is this many times the median run
+#define CALIBRATION_ROUND 20       // and rounded up to a multiple of this many ms, like afl-fuzz's EXEC_TM_ROUND
 #define DEFAULT_MEMORY_LIMIT 25    // The default memory limit in MB
+#define MAX_POOL 64                // most forkservers JIG_POOL can ask for
+#define MAX_ARGS 20                // most arguments JIG_TARGET_ARGV can have, with the target
 #define FORKSRV_FD 198             // The forkserver file descriptor used for control messages
 #define EXEC_FAIL_SIG 0xfee1dead   // constant used for the forkserver to signal something is wrong
 #define SHM_ENV_VAR "__AFL_SHM_ID" // environment variable used to pass the shared memory between the fuzzer and the fork server
+#define PERSIST_SIG "##SIG_AFL_PERSISTENT##" // signature of a target built for persistent mode
+#define PERSIST_ENV_VAR "__AFL_PERSISTENT"    // environment variable telling the target to run in persistent mode
 #define STRINGIFY_INTERNAL(x) #x
 #define STRINGIFY(x) STRINGIFY_INTERNAL(x)
 #define FORK_WAIT_MULT 10 // how long we're willing to wait for the forkserver to start
 #define MEM_BARRIER() __asm__ volatile("" :: \
 	                                   : "memory") // memory barrier to prevent race conditions
 
+static bool calibrating                      = false; // is the timeout still to be calibrated from the first runs
+static u32  calibration_count                = 0;     // runs measured for the calibration so far
+static u64  calibration_us[CALIBRATION_RUNS] = {0};   // how long each of them took
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wcast-align"
 // lookup used for loop binning
@@ -112,10 +161,170 @@ classify_counts(u64 *mem)
 	}
 }
 
+// monotonic time in ns
+static inline u64
+now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+// wait until the forkserver has something to say, or until deadline (in ns of CLOCK_MONOTONIC, 0 to wait forever).
+// Returns false if the deadline passed first.
+static bool
+wait_status(forkserver *fs, u64 deadline)
+{
+	struct pollfd pfd = {.fd = fs->st_fd, .events = POLLIN};
+	while (1) {
+		int wait_ms = -1;
+		if (deadline != 0) {
+			u64 now = now_ns();
+			if (now >= deadline) {
+				wait_ms = 0;
+			} else {
+				wait_ms = (int)MIN((deadline - now + 999999) / 1000000, INT32_MAX);
+			}
+		}
+		int ready = poll(&pfd, 1, wait_ms);
+		if (ready > 0) {
+			return true;
+		}
+		if (ready == 0) {
+			return false;
+		}
+		if (errno != EINTR) {
+			log_fatal("poll() failed");
+		}
+	}
+}
+
+// record how long a run took, and set the timeout once enough runs are in.
+// The timeout is CALIBRATION_MULT times the median run, like afl-fuzz's calibration, but never more than the default.
+static void
+calibrate(u64 run_us)
+{
+	calibration_us[calibration_count++] = run_us;
+	if (calibration_count < CALIBRATION_RUNS) {
+		return;
+	}
+	calibrating = false;
+
+	// insertion sort, there are only a few of them
+	for (u32 i = 1; i < CALIBRATION_RUNS; i++) {
+		u64 us = calibration_us[i];
+		u32 j  = i;
+		for (; j > 0 && calibration_us[j - 1] > us; j--) {
+			calibration_us[j] = calibration_us[j - 1];
+		}
+		calibration_us[j] = us;
+	}
+	u64 median_us = calibration_us[CALIBRATION_RUNS / 2];
+	u64 ms        = median_us * CALIBRATION_MULT / 1000;
+	timeout       = MIN((ms / CALIBRATION_ROUND + 1) * CALIBRATION_ROUND, DEFAULT_TIMEOUT);
+	log_info("Timeout calibrated to %" PRIu64 " ms from a median run of %" PRIu64 " us", timeout, median_us);
+}
+
+// create a SHM region for the target, whose ID it finds in env_var
+static void *
+shm_region_create(size_t size, const char *env_var, s32 *id)
+{
+	*id = shmget(IPC_PRIVATE, size, IPC_CREAT | IPC_EXCL | 0600);
+	if (*id < 0) {
+		log_fatal("shmget() failed");
+	}
+	char id_str[40];
+	snprintf(id_str, sizeof(id_str) - 1, "%d", *id);
+	setenv(env_var, id_str, 1);
+	void *region = shmat(*id, NULL, 0);
+	if (region == (void *)-1) {
+		log_fatal("shmat() failed");
+	}
+	memset(region, 0, size);
+	return region;
+}
+
+// drop a SHM region created by shm_region_create
+static void
+shm_region_remove(void *region, s32 id)
+{
+	if (region != NULL) {
+		shmdt(region);
+	}
+	if (id >= 0) {
+		shmctl(id, IPC_RMID, NULL);
+	}
+}
+
+// drop the comparison log, for a target that can't write it
+static void
+cmplog_remove()
+{
+	shm_region_remove(cmplog, cmplog_shm_id);
+	cmplog        = NULL;
+	cmplog_shm_id = -1;
+}
+
+// drop a forkserver's input channel, for a target that reads the fuzzfile
+static void
+fuzz_shm_remove(forkserver *fs)
+{
+	shm_region_remove(fs->fuzz_input, fs->fuzz_shm_id);
+	fs->fuzz_input  = NULL;
+	fs->fuzz_shm_id = -1;
+}
+
+// drop the batch region, for a target that runs one input per child
+static void
+batch_remove()
+{
+	shm_region_remove(batch, batch_shm_id);
+	batch        = NULL;
+	batch_shm_id = -1;
+}
+
+// answer the options a forkserver offers in its hello, see common/forkserver.h.
+// A plain AFL hello offers nothing and gets no reply. Only the primary forkserver gets the comparison log and batches.
+static void
+negotiate_options(forkserver *fs, u32 hello)
+{
+	bool is_primary = fs == primary;
+	if ((hello & FS_OPT_ENABLED) != FS_OPT_ENABLED) {
+		if (is_primary) {
+			cmplog_remove();
+			batch_remove();
+		}
+		fuzz_shm_remove(fs);
+		return;
+	}
+
+	u32 accepted = FS_OPT_ENABLED;
+	if ((hello & FS_OPT_CMPLOG) && is_primary && cmplog != NULL) {
+		accepted |= FS_OPT_CMPLOG;
+	} else if (is_primary) {
+		cmplog_remove();
+	}
+	if ((hello & FS_OPT_SHDMEM_FUZZ) && fs->fuzz_input != NULL) {
+		accepted |= FS_OPT_SHDMEM_FUZZ;
+	} else {
+		fuzz_shm_remove(fs);
+	}
+	// a persistent child already runs many inputs, and would have to be resumed rather than forked for a batch
+	if ((hello & FS_OPT_BATCH) && is_primary && batch != NULL && !persistent) {
+		accepted |= FS_OPT_BATCH;
+	} else if (is_primary) {
+		batch_remove();
+	}
+	if (write(fs->ctl_fd, &accepted, 4) != 4) {
+		log_fatal("Unable to answer the fork server's options");
+	}
+	log_debug("fork server options offered 0x%08x, accepted 0x%08x", hello, accepted);
+}
+
 // setup the forkserver that runs the target
 // taken from afl-fuzz.c
 static void
-init_forkserver(char *target, char *target_argv[])
+init_forkserver(forkserver *fs, char *target, char *target_argv[])
 {
 	int st_pipe[2], ctl_pipe[2];
 	int status;
@@ -125,12 +334,12 @@ init_forkserver(char *target, char *target_argv[])
 		log_fatal("pipe() failed");
 	}
 
-	forksrv_pid = fork();
+	fs->pid = fork();
 
-	if (forksrv_pid < 0) {
+	if (fs->pid < 0) {
 		log_fatal("fork() failed");
 	}
-	if (!forksrv_pid) {
+	if (!fs->pid) {
 		struct rlimit r;
 
 		/* Umpf. On OpenBSD, the default fd limit for root users is set to soft 128. Let's try to fix that... */
@@ -147,16 +356,32 @@ init_forkserver(char *target, char *target_argv[])
 		r.rlim_max = r.rlim_cur = 0;
 		setrlimit(RLIMIT_CORE, &r); /* Ignore errors */
 
+		// the target's children inherit the forkserver's core. The rest of the pool may run on any core,
+		// rather than inherit the fuzzer's and share it.
+		if (fs == primary && target_cpu >= 0) {
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(target_cpu, &cpus);
+			sched_setaffinity(0, sizeof(cpus), &cpus); /* Ignore errors */
+		} else if (fs != primary) {
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			for (long c = 0; c < sysconf(_SC_NPROCESSORS_CONF) && c < CPU_SETSIZE; c++) {
+				CPU_SET(c, &cpus);
+			}
+			sched_setaffinity(0, sizeof(cpus), &cpus); /* Ignore errors */
+		}
+
 		/* Isolate the process and configure standard descriptors. If out_file is specified, stdin is /dev/null; otherwise, out_fd is cloned instead. */
 		setsid();
 		dup2(dev_null_fd, 1);
 		dup2(dev_null_fd, 2);
 
-		if (out_file) {
+		if (fs->out_file) {
 			dup2(dev_null_fd, 0);
 		} else {
-			dup2(out_fd, 0);
-			close(out_fd);
+			dup2(fs->out_fd, 0);
+			close(fs->out_fd);
 		}
 
 		/* Set up control and status pipes, close the unneeded original fds. */
@@ -167,8 +392,8 @@ init_forkserver(char *target, char *target_argv[])
 		if (dup2(st_pipe[1], FORKSRV_FD + 1) < 0) {
 			log_fatal("dup2() failed");
 		}
-		fsrv_ctl_fd = ctl_pipe[1];
-		fsrv_st_fd  = st_pipe[0];
+		fs->ctl_fd = ctl_pipe[1];
+		fs->st_fd  = st_pipe[0];
 
 		close(ctl_pipe[0]);
 		close(ctl_pipe[1]);
@@ -197,42 +422,41 @@ init_forkserver(char *target, char *target_argv[])
 			log_fatal(strerror(errno));
 		}
 		/* Use a distinctive bitmap signature to tell the parent about execv() falling through. */
-		*(u32 *)trace_bits = EXEC_FAIL_SIG;
+		*(u32 *)fs->trace_bits = EXEC_FAIL_SIG;
 		exit(0);
 	}
 	/* Close the unneeded endpoints. */
 	close(ctl_pipe[0]);
 	close(st_pipe[1]);
 
-	fsrv_ctl_fd = ctl_pipe[1];
-	fsrv_st_fd  = st_pipe[0];
-
-	/* Wait for the fork server to come up, but don't wait too long. */
-	struct itimerval it;
-	it.it_value.tv_sec  = ((timeout * FORK_WAIT_MULT) / 1000);
-	it.it_value.tv_usec = ((timeout * FORK_WAIT_MULT) % 1000) * 1000;
-
-	setitimer(ITIMER_REAL, &it, NULL);
+	fs->ctl_fd = ctl_pipe[1];
+	fs->st_fd  = st_pipe[0];
 
-	rlen = (s32)read(fsrv_st_fd, &status, 4);
+	// the forkservers started after this one mustn't hold its pipes open, or it wouldn't see the fuzzer exit
+	fcntl(fs->ctl_fd, F_SETFD, FD_CLOEXEC);
+	fcntl(fs->st_fd, F_SETFD, FD_CLOEXEC);
 
-	it.it_value.tv_sec  = 0;
-	it.it_value.tv_usec = 0;
+	/* Wait for the fork server to come up, but don't wait too long. */
+	if (!wait_status(fs, now_ns() + timeout * FORK_WAIT_MULT * 1000000)) {
+		fs->child_timed_out = true;
+		kill(fs->pid, SIGKILL);
+	}
 
-	setitimer(ITIMER_REAL, &it, NULL);
+	rlen = fs->child_timed_out ? 0 : (s32)read(fs->st_fd, &status, 4);
 
 	/* If we have a four-byte "hello" message from the server, we're all set. Otherwise, try to figure out what went wrong. */
 
 	if (rlen == 4) {
+		negotiate_options(fs, (u32)status);
 		log_debug("All right - fork server is up.");
 		return;
 	}
 
-	if (child_timed_out) {
+	if (fs->child_timed_out) {
 		log_fatal("Timeout while initializing fork server");
 	}
 
-	if (waitpid(forksrv_pid, &status, 0) <= 0) {
+	if (waitpid(fs->pid, &status, 0) <= 0) {
 		log_fatal("waitpid() failed");
 	}
 
@@ -240,40 +464,35 @@ init_forkserver(char *target, char *target_argv[])
 		log_fatal("Whoops, the target binary crashed suddenly, before receiving any input from the fuzzer! Fork server crashed with signal %d", WTERMSIG(status));
 	}
 
-	if (*(u32 *)trace_bits == EXEC_FAIL_SIG) {
+	if (*(u32 *)fs->trace_bits == EXEC_FAIL_SIG) {
 		log_fatal("Unable to execute target application");
 	}
 
 	log_fatal("Fork server handshake failed");
 }
 
-/* UNUSED FUNCTION
-// what to do if the timeout is reached
-// taken from afl-fuzz.c
-static void
-handle_timeout()
-{
-        if (child_pid > 0) {
-                child_timed_out = true;
-                kill(child_pid, SIGKILL);
-
-        } else if (child_pid == -1 && forksrv_pid > 0) {
-                child_timed_out = true;
-                kill(forksrv_pid, SIGKILL);
-        }
-}
-*/
 /* Write modified data to file for testing. If out_file is set, the old file is unlinked and a new one is created. Otherwise, out_fd is rewound and truncated. */
 // taken from afl-fuzz.c
 static void
-write_to_testcase(void *input, size_t input_size)
+write_to_testcase(forkserver *fs, void *input, size_t input_size)
 {
-	int fd = out_fd;
-	if (out_file) {
-		unlink(out_file); /* Ignore errors. */
-		fd = open(out_file, O_WRONLY | O_CREAT | O_EXCL, 0600);
+	// a target that reads its input from SHM doesn't look at the fuzzfile, so it can't be given the rest of an input
+	if (fs->fuzz_input != NULL) {
+		if (input_size > FUZZ_SHM_MAX_INPUT) {
+			log_fatal("Input of %zu bytes doesn't fit the target's input channel, set JIG_MAX_INPUT above %d to use the fuzzfile.",
+			          input_size, FUZZ_SHM_MAX_INPUT);
+		}
+		memcpy(fs->fuzz_input->data, input, input_size);
+		fs->fuzz_input->size = (u32)input_size;
+		return;
+	}
+
+	int fd = fs->out_fd;
+	if (fs->out_file) {
+		unlink(fs->out_file); /* Ignore errors. */
+		fd = open(fs->out_file, O_WRONLY | O_CREAT | O_EXCL, 0600);
 		if (fd < 0) {
-			log_fatal("Unable to create '%s'", out_file);
+			log_fatal("Unable to create '%s'", fs->out_file);
 		}
 	} else {
 		lseek(fd, 0, SEEK_SET);
@@ -282,7 +501,7 @@ write_to_testcase(void *input, size_t input_size)
 	if (bytes_written > 0 && (size_t)bytes_written != input_size) {
 		log_fatal("write failed");
 	}
-	if (!out_file) {
+	if (!fs->out_file) {
 		if (ftruncate(fd, (off_t)input_size)) {
 			log_fatal("ftruncate() failed");
 		}
@@ -291,60 +510,87 @@ write_to_testcase(void *input, size_t input_size)
 		close(fd);
 }
 
-// signals the forkserver to run the target
+// when the input a forkserver is running times out, in ns of CLOCK_MONOTONIC. A batch gets the timeout of each of its inputs.
+static inline u64
+run_deadline(forkserver *fs)
+{
+	return fs->run_started + timeout * fs->run_inputs * 1000000;
+}
+
+// signals the forkserver to run the target, or the batch_count inputs of the fuzz_batch if that isn't 0, without waiting for it
 // most of the code is taken and modified from run_target function in afl-fuzz.c
-static char *
-fork_run()
+static void
+fork_start(forkserver *fs, u32 batch_count)
 {
-	static struct itimerval it;
-	static u32              prev_timed_out = false;
-	memset(trace_bits, 0, map_size);
+	memset(fs->trace_bits, 0, map_size);
 	MEM_BARRIER();
 
-	if (write(fsrv_ctl_fd, &prev_timed_out, 4) != 4) {
+	// a persistent child that has run its share of inputs is killed while it is stopped. Telling the forkserver
+	// the last run timed out makes it reap the child and fork a new one instead of resuming it.
+	if (fs->child_stopped && persistent_iters != 0 && fs->child_iters >= persistent_iters) {
+		kill(fs->child_pid, SIGKILL);
+		fs->child_stopped  = false;
+		fs->child_iters    = 0;
+		fs->prev_timed_out = true;
+	}
+
+	// the timeout counts from the request, so it covers the fork, and fork_finish waits for what is left of it
+	fs->child_timed_out = false;
+	fs->run_started     = now_ns();
+	fs->run_inputs      = MAX(batch_count, 1);
+
+	u32 request = fs->prev_timed_out | (batch_count != 0 ? FS_BATCH_RUN : 0);
+	if (write(fs->ctl_fd, &request, 4) != 4) {
 		log_fatal("Unable to request new process from fork server (OOM?)");
 	}
 
-	if (read(fsrv_st_fd, &child_pid, 4) != 4) {
+	if (read(fs->st_fd, &fs->child_pid, 4) != 4) {
 		log_fatal("Unable to request new process from fork server (OOM?)");
 	}
 
-	if (child_pid <= 0) {
+	if (fs->child_pid <= 0) {
 		log_fatal("Fork server is misbehaving (OOM?)");
 	}
+}
 
-	/* Configure timeout, as requested by user, then wait for child to terminate. */
-	it.it_value.tv_sec  = (timeout / 1000);
-	it.it_value.tv_usec = (timeout % 1000) * 1000;
-
-	setitimer(ITIMER_REAL, &it, NULL);
-
+// waits for the target started by fork_start and classifies its trace
+static char *
+fork_finish(forkserver *fs)
+{
 	int status = 0;
-	/* The SIGALRM handler simply kills the child_pid and sets child_timed_out. */
-	if (read(fsrv_st_fd, &status, 4) != 4) {
+	// a child still running at the deadline is killed, and the forkserver then reports it as killed
+	if (!wait_status(fs, run_deadline(fs))) {
+		fs->child_timed_out = true;
+		kill(fs->child_pid, SIGKILL);
+	}
+	if (read(fs->st_fd, &status, 4) != 4) {
 		log_fatal("Unable to communicate with fork server (OOM?)");
 	}
-
-	if (!WIFSTOPPED(status)) {
-		child_pid = 0;
+	if (calibrating && fs->run_inputs == 1 && !fs->child_timed_out && !WIFSIGNALED(status)) {
+		calibrate((now_ns() - fs->run_started) / 1000);
 	}
 
-	it.it_value.tv_sec  = 0;
-	it.it_value.tv_usec = 0;
-
-	setitimer(ITIMER_REAL, &it, NULL);
+	// a persistent child stops itself after each input and is resumed for the next one,
+	// unless it was killed as it stopped, then the forkserver reaps it when told it timed out
+	fs->child_stopped = WIFSTOPPED(status) && !fs->child_timed_out;
+	if (fs->child_stopped) {
+		fs->child_iters++;
+	} else {
+		fs->child_pid   = 0;
+		fs->child_iters = 0;
+	}
 
 	/* Any subsequent operations on trace_bits must not be moved by the compiler below this point. Past this location, trace_bits[] behave very normally and do not have to be treated as volatile. */
 	MEM_BARRIER();
 
-	classify_counts((u64 *)trace_bits);
+	classify_counts((u64 *)fs->trace_bits);
 
-	prev_timed_out = child_timed_out;
+	fs->prev_timed_out = fs->child_timed_out;
 
 	/* Report outcome to caller. */
 	if (WIFSIGNALED(status)) {
 		int kill_signal = WTERMSIG(status);
-		if (child_timed_out && kill_signal == SIGKILL) {
+		if (fs->child_timed_out && kill_signal == SIGKILL) {
 			return "timeout";
 		}
 		return "crash";
@@ -352,6 +598,81 @@ fork_run()
 	return NULL;
 }
 
+static char *
+fork_run(forkserver *fs)
+{
+	fork_start(fs, 0);
+	return fork_finish(fs);
+}
+
+// check whether the target was built for persistent mode, like afl-fuzz does
+// taken from afl-fuzz.c
+static bool
+is_persistent(char *target)
+{
+	int fd = open(target, O_RDONLY);
+	if (fd < 0) {
+		log_fatal("Unable to open the target");
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) < 0 || file_stat.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	void *image = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (image == MAP_FAILED) {
+		log_fatal("Unable to map the target");
+	}
+	bool found = memmem(image, (size_t)file_stat.st_size, PERSIST_SIG, strlen(PERSIST_SIG) + 1) != NULL;
+	munmap(image, (size_t)file_stat.st_size);
+	return found;
+}
+
+// give a forkserver its fuzzfile and SHM regions and start it. The pool's forkservers after the first
+// get fuzzfiles of their own, and the target's arguments naming the fuzzfile are pointed at them.
+static void
+forkserver_launch(forkserver *fs, u32 index, char *fuzzfile, bool named, char *target, char *target_argv[])
+{
+	char *file = fuzzfile;
+	if (index > 0 && asprintf(&file, "%s.pool%u", fuzzfile, index) < 0) {
+		log_fatal("asprintf() failed");
+	}
+	char *argv[MAX_ARGS] = {0};
+	for (size_t a = 0; a < MAX_ARGS && target_argv[a] != NULL; a++) {
+		argv[a] = (a > 0 && strcmp(target_argv[a], fuzzfile) == 0) ? file : target_argv[a];
+	}
+
+	unlink(file);
+	fs->out_fd = open(file, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+	if (fs->out_fd < 0) {
+		log_fatal("Creating the fuzzfile failed");
+	}
+	if (named) {
+		fs->out_file = file;
+	}
+	if (index > 0) {
+		fs->pool_file = file;
+	}
+
+	// the map is faulted in from the fuzzer, so first touch places it on the fuzzer's NUMA node.
+	// The input channel is kept only if the forkserver says the target can use it, and isn't
+	// offered at all if the fuzzer's inputs can be larger than it.
+	fs->trace_bits  = shm_region_create(map_size, SHM_ENV_VAR, &fs->shm_id);
+	fs->fuzz_input  = NULL;
+	fs->fuzz_shm_id = -1;
+	if (max_input <= FUZZ_SHM_MAX_INPUT) {
+		fs->fuzz_input = shm_region_create(sizeof(fuzz_shm), FUZZ_SHM_ENV_VAR, &fs->fuzz_shm_id);
+	}
+
+	init_forkserver(fs, target, argv);
+
+	struct epoll_event event = {.events = EPOLLIN, .data.u32 = index};
+	if (epoll_ctl(pool_epoll_fd, EPOLL_CTL_ADD, fs->st_fd, &event) < 0) {
+		log_fatal("epoll_ctl() failed");
+	}
+}
+
 // initalize the jig
 static void
 init()
@@ -361,15 +682,18 @@ init()
 	if (env_map_size == NULL) {
 		log_fatal("Missing JIG_MAP_SIZE environment variable.");
 	}
+	errno    = 0;
 	map_size = strtoull(env_map_size, NULL, 0);
 
 	if (errno != 0) {
 		log_fatal(strerror(errno));
 	}
 
+	// without JIG_TIMEOUT, the default timeout only holds until the first runs calibrate it
 	char *env_timeout = getenv("JIG_TIMEOUT");
 	if (env_timeout == NULL) {
-		timeout = DEFAULT_TIMEOUT;
+		timeout     = DEFAULT_TIMEOUT;
+		calibrating = true;
 	} else {
 		timeout = strtoul(env_timeout, NULL, 0);
 		if (errno != 0) {
@@ -387,6 +711,22 @@ init()
 		}
 	}
 
+	char *env_max_input = getenv("JIG_MAX_INPUT");
+	if (env_max_input != NULL) {
+		max_input = strtoull(env_max_input, NULL, 0);
+		if (errno != 0) {
+			log_fatal(strerror(errno));
+		}
+	}
+
+	char *env_target_cpu = getenv("JIG_CPU");
+	if (env_target_cpu != NULL) {
+		target_cpu = (int)strtol(env_target_cpu, NULL, 0);
+		if (errno != 0) {
+			log_fatal(strerror(errno));
+		}
+	}
+
 	char *env_target = getenv("JIG_TARGET");
 	if (env_target == NULL) {
 		log_fatal("Missing JIG_TARGET environment variable.");
@@ -399,12 +739,33 @@ init()
 		log_debug("Target is executable.");
 	}
 
+	// persistent mode is used for targets with the persistent signature, or any target if JIG_PERSISTENT is set
+	persistent = getenv("JIG_PERSISTENT") != NULL || is_persistent(target);
+	if (persistent) {
+		setenv(PERSIST_ENV_VAR, "1", 1);
+		log_debug("Target runs in persistent mode.");
+	}
+
+	char *env_persistent_iters = getenv("JIG_PERSISTENT_ITERS");
+	if (env_persistent_iters != NULL) {
+		persistent_iters = strtoull(env_persistent_iters, NULL, 0);
+		if (errno != 0) {
+			log_fatal(strerror(errno));
+		}
+	}
+
 	char *env_target_argv = getenv("JIG_TARGET_ARGV");
 	if (env_target_argv == NULL) {
 		log_fatal("Missing JIG_TARGET_ARGV environment variable.");
 	}
+	// split a copy, the jig may be initialized again in this process, as --cmin does
+	char *target_args = strdup(env_target_argv);
+	if (target_args == NULL) {
+		log_fatal("strdup() failed");
+	}
+	env_target_argv = target_args;
 	// Only supporting 20 arguments
-	char  *target_argv[20] = {0};
+	char  *target_argv[MAX_ARGS] = {0};
 	char **target_argv_ptr;
 
 	target_argv[0] = target;
@@ -412,78 +773,332 @@ init()
 	// very simple argument parsing that doesn't support quotes
 	for (target_argv_ptr = &target_argv[1]; (*target_argv_ptr = strsep(&env_target_argv, " \t")) != NULL;) {
 		if (**target_argv_ptr != '\0') {
-			if (++target_argv_ptr >= &target_argv[20]) {
+			if (++target_argv_ptr >= &target_argv[MAX_ARGS - 1]) {
 				break;
 			}
 		}
 	}
 
 	char *fuzzfile = getenv("JIG_FUZZFILE");
+	bool  named    = fuzzfile != NULL; // is the fuzzfile recreated for each input rather than rewritten
 	if (fuzzfile == NULL) {
 		fuzzfile = "fuzzfile";
-	} else {
-		out_file = fuzzfile;
-	}
-	unlink(fuzzfile);
-	out_fd = open(fuzzfile, O_RDWR | O_CREAT | O_EXCL, 0600);
-	if (out_fd < 0) {
-		log_fatal("Creating the fuzzfile failed");
 	}
 
-	// Create a new shared memory region
-	shm_id = shmget(IPC_PRIVATE, map_size, IPC_CREAT | IPC_EXCL | 0600);
-	if (shm_id < 0) {
-		log_fatal("shmget() failed");
+	// the_fuzz -j runs one jig per worker, so each one needs a fuzzfile of its own.
+	// Arguments naming the fuzzfile are pointed at the worker's copy.
+	char *env_instance = getenv("JIG_INSTANCE");
+	if (env_instance != NULL) {
+		char *instance_fuzzfile = NULL;
+		if (asprintf(&instance_fuzzfile, "%s.%s", fuzzfile, env_instance) < 0) {
+			log_fatal("asprintf() failed");
+		}
+		for (target_argv_ptr = &target_argv[1]; target_argv_ptr < &target_argv[MAX_ARGS] && *target_argv_ptr != NULL; target_argv_ptr++) {
+			if (strcmp(*target_argv_ptr, fuzzfile) == 0) {
+				*target_argv_ptr = instance_fuzzfile;
+			}
+		}
+		fuzzfile = instance_fuzzfile;
 	}
 
-	// Setup environment variable
-	char shm_str[40];
-	snprintf(shm_str, sizeof(shm_str) - 1, "%d", shm_id);
-	setenv(SHM_ENV_VAR, shm_str, 1);
-
-	// Save a pointer to the region in trace_bits
-	trace_bits = shmat(shm_id, NULL, 0);
-	if (!trace_bits) {
-		log_fatal("shmat() failed");
+	// JIG_POOL forkservers run the inputs given to submit side by side
+	char *env_pool = getenv("JIG_POOL");
+	if (env_pool != NULL) {
+		server_count = (u32)strtoul(env_pool, NULL, 0);
+		if (errno != 0 || server_count == 0 || server_count > MAX_POOL) {
+			log_fatal("JIG_POOL must be between 1 and " STRINGIFY(MAX_POOL) ".");
+		}
 	}
+	servers = calloc(server_count, sizeof(forkserver));
+	if (servers == NULL) {
+		log_fatal("calloc() failed");
+	}
+	primary = &servers[0];
+
 	init_count_class16();
+	finished[0] = calloc(map_size, 1);
+	finished[1] = calloc(map_size, 1);
+	if (finished[0] == NULL || finished[1] == NULL) {
+		log_fatal("calloc() failed");
+	}
 
 	dev_null_fd = open("/dev/null", O_RDWR);
 	if (dev_null_fd < 0) {
 		log_fatal("Unable to open /dev/null");
 	}
 
-	init_forkserver(target, target_argv);
+	pool_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (pool_epoll_fd < 0) {
+		log_fatal("epoll_create1() failed");
+	}
+
+	// regions for the comparison log and batches, each kept only if the primary forkserver says the target can use it
+	cmplog = shm_region_create(sizeof(cmplog_map), CMPLOG_SHM_ENV_VAR, &cmplog_shm_id);
+	batch  = shm_region_create(sizeof(fuzz_batch) + BATCH_MAX_INPUTS * map_size, BATCH_SHM_ENV_VAR, &batch_shm_id);
+
+	batch->map_size = (u32)map_size;
+	for (u32 index = 0; index < server_count; index++) {
+		if (index == 1) {
+			unsetenv(CMPLOG_SHM_ENV_VAR);
+			unsetenv(BATCH_SHM_ENV_VAR);
+		}
+		forkserver_launch(&servers[index], index, fuzzfile, named, target, target_argv);
+	}
+	free(target_args);
 }
 
 // run an input and collect instrumentation
 static char *
 run(u8 *input, size_t input_size, u8 **results, size_t *results_size)
 {
-	write_to_testcase(input, input_size);
-	char *status  = fork_run();
+	write_to_testcase(primary, input, input_size);
+	char *status  = fork_run(primary);
 	*results_size = map_size;
-	*results      = trace_bits;
+	*results      = primary->trace_bits;
 	return status;
 }
 
+// run an input with the target logging its comparisons, if it can
+static char *
+run_cmplog(u8 *input, size_t input_size, u8 **results, size_t *results_size, u8 **comparisons, size_t *comparisons_size)
+{
+	if (cmplog == NULL) {
+		*comparisons      = NULL;
+		*comparisons_size = 0;
+		return run(input, input_size, results, results_size);
+	}
+
+	cmplog->count   = 0;
+	cmplog->enabled = 1;
+	char *status    = run(input, input_size, results, results_size);
+	cmplog->enabled = 0;
+
+	*comparisons      = (u8 *)cmplog;
+	*comparisons_size = sizeof(cmplog_map);
+	return status;
+}
+
+// run inputs as batches in the fuzz_batch, each batch in one child, or one at a time if the target can't
+static void
+run_batch(u8 **inputs, size_t *input_sizes, size_t count, u8 **results, size_t *results_sizes, char **statuses)
+{
+	if (batch == NULL) {
+		jig_run_batch_single(run, inputs, input_sizes, count, results, results_sizes, statuses, &batch_copies);
+		return;
+	}
+	if (batch_copies.content_size < count * map_size) {
+		batch_copies.content_size = count * map_size;
+		batch_copies.content      = realloc(batch_copies.content, batch_copies.content_size);
+		if (batch_copies.content == NULL) {
+			log_fatal("realloc() failed");
+		}
+	}
+
+	size_t next = 0;
+	while (next < count) {
+		// pack as many of the inputs as fit, in order
+		u32    n    = 0;
+		size_t used = 0;
+		while (next + n < count && n < BATCH_MAX_INPUTS && input_sizes[next + n] <= BATCH_MAX_DATA - used) {
+			batch->offsets[n] = (u32)used;
+			batch->sizes[n]   = (u32)input_sizes[next + n];
+			memcpy(batch->data + used, inputs[next + n], input_sizes[next + n]);
+			used += input_sizes[next + n];
+			n++;
+		}
+
+		// an input too large for a batch runs on its own
+		if (n == 0) {
+			u8    *single      = NULL;
+			size_t single_size = 0;
+			statuses[next]     = run(inputs[next], input_sizes[next], &single, &single_size);
+			memcpy(batch_copies.content + next * map_size, single, map_size);
+			next++;
+			continue;
+		}
+
+		batch->count = n;
+		batch->done  = 0;
+		fork_start(primary, n);
+		char *status = fork_finish(primary);
+		u32   done   = MIN(batch->done, n);
+		for (u32 i = 0; i < done; i++) {
+			u8 *copy = batch_copies.content + (next + i) * map_size;
+			memcpy(copy, fuzz_batch_results(batch, i), map_size);
+			classify_counts((u64 *)copy);
+			statuses[next + i] = NULL;
+		}
+		next += done;
+
+		// the input the child stopped at crashed or hung, and its trace is the one fork_finish classified.
+		// The inputs after it go in the next batch.
+		if (done < n) {
+			memcpy(batch_copies.content + next * map_size, primary->trace_bits, map_size);
+			statuses[next] = status;
+			next++;
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		results[i]       = batch_copies.content + i * map_size;
+		results_sizes[i] = map_size;
+	}
+}
+
+// start running an input, the fuzzer can do other work until it calls finish
+static void
+start(u8 *input, size_t input_size)
+{
+	write_to_testcase(primary, input, input_size);
+	fork_start(primary, 0);
+}
+
+// wait for the input passed to start, its results stay valid until finish is called twice more
+static char *
+finish(u8 **results, size_t *results_size)
+{
+	char *status = fork_finish(primary);
+	u8   *copy   = finished[finished_next];
+	finished_next ^= 1;
+	memcpy(copy, primary->trace_bits, map_size);
+	*results_size = map_size;
+	*results      = copy;
+	return status;
+}
+
+// hand an input to an idle forkserver of the pool, returning false if they are all busy.
+// poll_completed reports it with tag once it is done.
+static bool
+submit(u8 *input, size_t input_size, u64 tag)
+{
+	for (u32 index = 0; index < server_count; index++) {
+		forkserver *fs = &servers[index];
+		if (fs->submitted) {
+			continue;
+		}
+		write_to_testcase(fs, input, input_size);
+		fork_start(fs, 0);
+		fs->submitted = true;
+		fs->tag       = tag;
+		submitted++;
+		return true;
+	}
+	return false;
+}
+
+// wait for any submitted input to finish, returning false if none are running.
+// Its results stay valid until the next submit.
+static bool
+poll_completed(u64 *tag, u8 **results, size_t *results_size, char **status)
+{
+	if (submitted == 0) {
+		return false;
+	}
+	while (1) {
+		// inputs past their deadline are killed, and the wait lasts until the earliest of the others
+		u64 now      = now_ns();
+		u64 deadline = UINT64_MAX;
+		for (u32 index = 0; index < server_count; index++) {
+			forkserver *fs = &servers[index];
+			if (!fs->submitted || fs->child_timed_out) {
+				continue;
+			}
+			if (run_deadline(fs) <= now) {
+				fs->child_timed_out = true;
+				kill(fs->child_pid, SIGKILL);
+			} else {
+				deadline = MIN(deadline, run_deadline(fs));
+			}
+		}
+		int wait_ms = deadline == UINT64_MAX ? -1 : (int)MIN((deadline - now + 999999) / 1000000, INT32_MAX);
+
+		struct epoll_event event;
+		int                ready = epoll_wait(pool_epoll_fd, &event, 1, wait_ms);
+		if (ready < 0 && errno != EINTR) {
+			log_fatal("epoll_wait() failed");
+		}
+		if (ready <= 0) {
+			continue;
+		}
+
+		// the status is waiting, so fork_finish reads it without blocking
+		forkserver *fs = &servers[event.data.u32];
+		*status        = fork_finish(fs);
+		*tag           = fs->tag;
+		*results       = fs->trace_bits;
+		*results_size  = map_size;
+		fs->submitted  = false;
+		submitted--;
+		return true;
+	}
+}
+
+// how many inputs can be submitted at once
+static size_t
+pool_size()
+{
+	return server_count;
+}
+
 // cleanup
 static void
 destroy()
 {
-	trace_bits = NULL;
-	shmctl(shm_id, IPC_RMID, NULL);
+	free(finished[0]);
+	free(finished[1]);
+	finished[0] = NULL;
+	finished[1] = NULL;
+	for (u32 index = 0; index < server_count; index++) {
+		forkserver *fs = &servers[index];
+		// a stopped persistent child, or one still running a submitted input, would outlive the forkserver
+		if (fs->child_stopped || fs->submitted) {
+			kill(fs->child_pid, SIGKILL);
+			fs->child_stopped = false;
+		}
+		close(fs->ctl_fd);
+		close(fs->st_fd);
+		kill(fs->pid, SIGKILL);
+		waitpid(fs->pid, NULL, 0);
+
+		shm_region_remove(fs->trace_bits, fs->shm_id);
+		fs->trace_bits = NULL;
+		fuzz_shm_remove(fs);
+		close(fs->out_fd);
+		if (fs->pool_file != NULL) {
+			unlink(fs->pool_file);
+			free(fs->pool_file);
+		}
+	}
+	free(servers);
+	servers      = NULL;
+	primary      = NULL;
+	server_count = 1;
+	submitted    = 0;
+	close(pool_epoll_fd);
+	pool_epoll_fd = -1;
+	close(dev_null_fd);
+	cmplog_remove();
+	batch_remove();
+	free(batch_copies.content);
+	batch_copies = (sized_buffer){0};
 }
 
 static void
 create_api(jig_api *j)
 {
-	j->version     = VERSION_ONE;
-	j->name        = "afl_forkserver";
-	j->description = "This is a jig for the AFL forkserver";
-	j->initialize  = init;
-	j->run         = run;
-	j->destroy     = destroy;
+	j->version        = VERSION_FIVE;
+	j->name           = "afl_forkserver";
+	j->description    = "This is a jig for the AFL forkserver";
+	j->initialize     = init;
+	j->run            = run;
+	j->destroy        = destroy;
+	j->start          = start;
+	j->finish         = finish;
+	j->run_cmplog     = run_cmplog;
+	j->run_batch      = run_batch;
+	j->submit         = submit;
+	j->poll_completed = poll_completed;
+	j->pool_size      = pool_size;
 }
 
 jig_api_getter           get_jig_api = create_api;
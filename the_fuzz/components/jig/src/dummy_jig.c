@@ -29,7 +29,8 @@ static unsigned char ___test_data_intelpt_loop_tnt_tnt_pt[] = {
     0x01};
 static unsigned int ___test_data_intelpt_loop_tnt_tnt_pt_len = 37;
 
-static u8 *results_buf = NULL;
+static u8          *results_buf = NULL;
+static sized_buffer batch_copies = {0}; // results of the last run_batch
 
 static void
 init()
@@ -41,8 +42,8 @@ run(u8 *input, size_t input_size, u8 **results, size_t *results_size)
 {
 	if (!results_buf) {
 		results_buf = calloc(100, 1);
-		*results    = results_buf;
 	}
+	*results = results_buf;
 	memcpy(*results, ___test_data_intelpt_loop_tnt_pt, ___test_data_intelpt_loop_tnt_pt_len);
 	*results_size = ___test_data_intelpt_loop_tnt_pt_len;
 
@@ -56,21 +57,33 @@ run(u8 *input, size_t input_size, u8 **results, size_t *results_size)
 	}
 	return NULL;
 }
+
+// runs each input with run
+static void
+run_batch(u8 **inputs, size_t *input_sizes, size_t count, u8 **results, size_t *results_sizes, char **statuses)
+{
+	jig_run_batch_single(run, inputs, input_sizes, count, results, results_sizes, statuses, &batch_copies);
+}
+
 static void
 destroy()
 {
 	free(results_buf);
+	free(batch_copies.content);
+	results_buf  = NULL;
+	batch_copies = (sized_buffer){0};
 }
 
 static void
 create_api(jig_api *j)
 {
-	j->version     = VERSION_ONE;
+	j->version     = VERSION_FOUR;
 	j->name        = "dummy jig";
 	j->description = "This is for testing.";
 	j->initialize  = init;
 	j->run         = run;
 	j->destroy     = destroy;
+	j->run_batch   = run_batch;
 }
 
 jig_api_getter get_jig_api = create_api;
@@ -0,0 +1,191 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include "affinity.h"
+#include "common/logger.h"
+
+#define AFFINITY_LINE_SIZE 256
+
+// cores that some process is bound to, kernel threads without memory don't count
+static void
+busy_cores(cpu_set_t *busy)
+{
+	CPU_ZERO(busy);
+	DIR *proc = opendir("/proc");
+	if (proc == NULL) {
+		log_warn("Can't open /proc to find free cores.");
+		return;
+	}
+
+	struct dirent *entry;
+	while ((entry = readdir(proc)) != NULL) {
+		if (!isdigit((unsigned char)entry->d_name[0])) {
+			continue;
+		}
+		char name[sizeof(entry->d_name) + 16];
+		snprintf(name, sizeof(name), "/proc/%s/status", entry->d_name);
+		FILE *status = fopen(name, "r");
+		if (status == NULL) {
+			continue;
+		}
+
+		char line[AFFINITY_LINE_SIZE];
+		bool has_vmsize = false;
+		int  core       = AFFINITY_NONE;
+		while (fgets(line, sizeof(line), status) != NULL) {
+			if (strncmp(line, "VmSize:\t", 8) == 0) {
+				has_vmsize = true;
+			}
+			// a process bound to one core lists just that core
+			if (strncmp(line, "Cpus_allowed_list:\t", 19) == 0 && strpbrk(line + 19, ",-") == NULL) {
+				core = atoi(line + 19);
+			}
+		}
+		fclose(status);
+		if (has_vmsize && core >= 0 && core < CPU_SETSIZE) {
+			CPU_SET(core, busy);
+		}
+	}
+	closedir(proc);
+}
+
+// a core's hyperthread sibling, AFFINITY_NONE if it has none
+static int
+smt_sibling(int core)
+{
+	char name[AFFINITY_LINE_SIZE];
+	snprintf(name, sizeof(name), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", core);
+	FILE *siblings = fopen(name, "r");
+	if (siblings == NULL) {
+		return AFFINITY_NONE;
+	}
+	int  first  = AFFINITY_NONE;
+	int  second = AFFINITY_NONE;
+	char separator;
+	int  fields = fscanf(siblings, "%d%c%d", &first, &separator, &second);
+	fclose(siblings);
+	if (fields != 3 || second < 0 || second >= CPU_SETSIZE) {
+		return AFFINITY_NONE;
+	}
+	return first == core ? second : first;
+}
+
+static bool
+bind_to(int core)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// cores this process may run on that no process is bound to
+static void
+free_cores(cpu_set_t *free)
+{
+	cpu_set_t busy;
+	busy_cores(&busy);
+	CPU_ZERO(free);
+	if (sched_getaffinity(0, sizeof(cpu_set_t), free) != 0) {
+		CPU_ZERO(free);
+		return;
+	}
+	for (int core = 0; core < CPU_SETSIZE; core++) {
+		if (CPU_ISSET(core, &busy)) {
+			CPU_CLR(core, free);
+		}
+	}
+}
+
+// how many cores are free to bind to
+u32
+affinity_free_cores(void)
+{
+	cpu_set_t free;
+	free_cores(&free);
+	return (u32)CPU_COUNT(&free);
+}
+
+// bind this process to a free core, and pick the core for the jig's forkserver, the lock is held until affinity_release
+bool
+affinity_bind(bool pair, affinity *bound)
+{
+	bound->fuzzer  = AFFINITY_NONE;
+	bound->target  = AFFINITY_NONE;
+	bound->lock_fd = -1;
+
+	// with one core, or when someone already bound us, there is nothing to pick
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) < 2) {
+		return false;
+	}
+
+	bound->lock_fd = open(AFFINITY_LOCK_FILE, O_CREAT | O_RDWR, 0666);
+	if (bound->lock_fd >= 0 && flock(bound->lock_fd, LOCK_EX) != 0) {
+		close(bound->lock_fd);
+		bound->lock_fd = -1;
+	}
+
+	cpu_set_t free;
+	free_cores(&free);
+	for (int core = 0; core < CPU_SETSIZE && pair && bound->fuzzer == AFFINITY_NONE; core++) {
+		if (!CPU_ISSET(core, &free)) {
+			continue;
+		}
+		int sibling = smt_sibling(core);
+		if (sibling != AFFINITY_NONE && CPU_ISSET(sibling, &free)) {
+			bound->fuzzer = core;
+			bound->target = sibling;
+		}
+	}
+	for (int core = 0; core < CPU_SETSIZE && bound->fuzzer == AFFINITY_NONE; core++) {
+		if (CPU_ISSET(core, &free)) {
+			bound->fuzzer = core;
+			bound->target = core;
+		}
+	}
+
+	if (bound->fuzzer == AFFINITY_NONE) {
+		log_warn("No free core to bind to, leaving this worker unbound.");
+	} else if (!bind_to(bound->fuzzer)) {
+		log_warn("Can't bind to core %d, leaving this worker unbound.", bound->fuzzer);
+		bound->fuzzer = AFFINITY_NONE;
+		bound->target = AFFINITY_NONE;
+	}
+	if (bound->fuzzer == AFFINITY_NONE) {
+		affinity_release(bound);
+		return false;
+	}
+	return true;
+}
+
+// let other workers pick cores, once the jig's forkserver is bound
+void
+affinity_release(affinity *bound)
+{
+	if (bound->lock_fd >= 0) {
+		flock(bound->lock_fd, LOCK_UN);
+		close(bound->lock_fd);
+		bound->lock_fd = -1;
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include <stdbool.h>
+
+#include "common/types.h"
+
+/*
+    Workers bind themselves to cores no other process is bound to, found by scanning
+    /proc the way afl-fuzz does, and the jig binds its forkserver and the target next
+    to them: to the core's hyperthread sibling when there are cores to spare, so the two
+    share an L2 and can run at the same time, or to the worker's own core otherwise.
+    A worker binds before its jig allocates the trace map, so first touch puts the map
+    on the worker's NUMA node. A lock file is held from picking the cores until the
+    forkserver is bound, so workers of this and other instances pick disjoint cores.
+*/
+
+#define AFFINITY_LOCK_FILE "/tmp/.gtfo_affinity.lock"
+#define AFFINITY_NONE -1
+
+typedef struct affinity {
+	int fuzzer;  // core the worker is bound to, AFFINITY_NONE if it isn't
+	int target;  // core the forkserver and the target are bound to
+	int lock_fd; // held until the forkserver is bound
+} affinity;
+
+u32  affinity_free_cores(void);
+bool affinity_bind(bool pair, affinity *bound);
+void affinity_release(affinity *bound);
+
+#endif
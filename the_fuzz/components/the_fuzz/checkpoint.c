@@ -0,0 +1,165 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "common/logger.h"
+
+#define CHECKPOINT_MAGIC 0x34504b434f465447ULL // "GTFOCKP4"
+
+// name of a worker's checkpoint file
+static void
+checkpoint_name(char *name, size_t size, u32 worker, bool temp)
+{
+	snprintf(name, size, CHECKPOINT_DIR "worker.%u%s", worker, temp ? ".tmp" : "");
+}
+
+static void
+write_or_die(FILE *file, void *buffer, size_t size, char *name)
+{
+	if (size > 0 && fwrite(buffer, size, 1, file) != 1) {
+		log_fatal("Can't write checkpoint: '%s'.", name);
+	}
+}
+
+static bool
+read_all(FILE *file, void *buffer, size_t size)
+{
+	return size == 0 || fread(buffer, size, 1, file) == 1;
+}
+
+// make a file durable and move it into place
+void
+checkpoint_publish(char *temp_name, char *name)
+{
+	int fd = open(temp_name, O_RDONLY);
+	if (fd < 0) {
+		log_fatal("Can't open checkpoint: '%s'.", temp_name);
+	}
+	fsync(fd);
+	close(fd);
+	if (rename(temp_name, name) != 0) {
+		log_fatal("Can't rename checkpoint '%s' to '%s'.", temp_name, name);
+	}
+
+	// the rename itself is only durable once the directory is
+	char *slash = strrchr(name, '/');
+	char *dir   = slash != NULL ? strndup(name, (size_t)(slash - name + 1)) : strdup(".");
+	if (dir == NULL) {
+		log_fatal("strdup() failed");
+	}
+	fd = open(dir, O_RDONLY | O_DIRECTORY);
+	if (fd >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+	free(dir);
+}
+
+// write a worker's checkpoint, state may be NULL between queue entries
+void
+checkpoint_save(checkpoint *position, char *state, queue *corpus)
+{
+	char temp_name[CHECKPOINT_NAME_SIZE];
+	char name[CHECKPOINT_NAME_SIZE];
+	checkpoint_name(temp_name, sizeof(temp_name), position->worker, true);
+	checkpoint_name(name, sizeof(name), position->worker, false);
+
+	FILE *file = fopen(temp_name, "wb");
+	if (file == NULL) {
+		log_fatal("Can't open checkpoint: '%s'.", temp_name);
+	}
+
+	u64 magic      = CHECKPOINT_MAGIC;
+	u64 state_size = state ? strlen(state) : 0;
+	u64 count      = corpus->count;
+	u64 data_size  = corpus->data_size;
+	write_or_die(file, &magic, sizeof(magic), temp_name);
+	write_or_die(file, position, sizeof(checkpoint), temp_name);
+	write_or_die(file, &state_size, sizeof(state_size), temp_name);
+	write_or_die(file, state, state_size, temp_name);
+	write_or_die(file, &count, sizeof(count), temp_name);
+	write_or_die(file, corpus->entries, sizeof(queue_entry) * count, temp_name);
+	write_or_die(file, &data_size, sizeof(data_size), temp_name);
+	write_or_die(file, corpus->data, data_size, temp_name);
+	if (fclose(file) != 0) {
+		log_fatal("Can't write checkpoint: '%s'.", temp_name);
+	}
+
+	checkpoint_publish(temp_name, name);
+}
+
+// read a worker's checkpoint, returning false if it has none
+bool
+checkpoint_load(u32 worker, checkpoint *position, char **state, queue **corpus)
+{
+	char name[CHECKPOINT_NAME_SIZE];
+	checkpoint_name(name, sizeof(name), worker, false);
+
+	FILE *file = fopen(name, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	u64 magic      = 0;
+	u64 state_size = 0;
+	u64 count      = 0;
+	u64 data_size  = 0;
+	if (!read_all(file, &magic, sizeof(magic)) || magic != CHECKPOINT_MAGIC ||
+	    !read_all(file, position, sizeof(checkpoint)) ||
+	    !read_all(file, &state_size, sizeof(state_size))) {
+		log_fatal("Checkpoint is corrupt: '%s'.", name);
+	}
+
+	*state = NULL;
+	if (state_size > 0) {
+		*state = calloc(1, state_size + 1);
+		if (*state == NULL || !read_all(file, *state, state_size)) {
+			log_fatal("Checkpoint is corrupt: '%s'.", name);
+		}
+	}
+
+	if (!read_all(file, &count, sizeof(count))) {
+		log_fatal("Checkpoint is corrupt: '%s'.", name);
+	}
+	queue_entry *entries = calloc(count ? count : 1, sizeof(queue_entry));
+	if (entries == NULL || !read_all(file, entries, sizeof(queue_entry) * count) ||
+	    !read_all(file, &data_size, sizeof(data_size))) {
+		log_fatal("Checkpoint is corrupt: '%s'.", name);
+	}
+	u8 *data = malloc(data_size ? data_size : 1);
+	if (data == NULL || !read_all(file, data, data_size)) {
+		log_fatal("Checkpoint is corrupt: '%s'.", name);
+	}
+	fclose(file);
+
+	// rebuild the queue entry by entry, keeping each entry's history
+	*corpus = queue_create();
+	for (u64 i = 0; i < count; i++) {
+		if (entries[i].offset + entries[i].size > data_size) {
+			log_fatal("Checkpoint is corrupt: '%s'.", name);
+		}
+		size_t       index = queue_add(*corpus, data + entries[i].offset, entries[i].size, entries[i].exec_us);
+		queue_entry *entry = &(*corpus)->entries[index];
+		entry->new_coverage = entries[i].new_coverage;
+		entry->fuzzed       = entries[i].fuzzed;
+	}
+	free(entries);
+	free(data);
+	return true;
+}
@@ -0,0 +1,61 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include <stdbool.h>
+
+#include "common/types.h"
+#include "fuzzer_stats.h"
+#include "queue.h"
+
+/*
+    A checkpoint is one file per worker holding where the worker is in its loop,
+    its serialized strategy state and its queue, plus one analysis file for the campaign.
+    Every file is written to a temporary name and renamed into place, and the analysis
+    is only renamed after the workers' files, so a checkpoint never knows of coverage
+    that is missing from the queues.
+*/
+
+#define CHECKPOINT_DIR "checkpoint/"
+#define CHECKPOINT_ANALYSIS CHECKPOINT_DIR "analysis"
+#define CHECKPOINT_ANALYSIS_TMP CHECKPOINT_DIR "analysis.tmp"
+#define CHECKPOINT_NAME_SIZE 64
+
+typedef struct checkpoint {
+	u64  iteration;                      // executions the worker's loop has run
+	u32  stage;                          // stage being run
+	u64  entry;                          // queue entry being fuzzed
+	u64  entry_execs;                    // executions spent on that entry this cycle
+	u64  cycle_execs;                    // executions in this cycle over the queue
+	u64  execs;                          // the worker's stats
+	u64  coverage;
+	u64  interesting;
+	u64  crashes;
+	u64  hangs;
+	u64  crashes_suppressed;
+	u64  hangs_suppressed;
+	u64  stage_execs[STAGES_MAX];
+	u64  stage_paths[STAGES_MAX];
+	u32  worker;                         // the worker that wrote the checkpoint
+	u32  workers;                        // how many workers the campaign has
+	char strategy[CHECKPOINT_NAME_SIZE]; // name of the stage's strategy, which the state belongs to
+} checkpoint;
+
+void checkpoint_save(checkpoint *position, char *state, queue *corpus);
+bool checkpoint_load(u32 worker, checkpoint *position, char **state, queue **corpus);
+void checkpoint_publish(char *temp_name, char *name);
+
+#endif
@@ -0,0 +1,257 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cmin.h"
+#include "common/logger.h"
+#include "fuzzer_stats.h"
+
+// only regular files are inputs
+static int
+cmin_filter(const struct dirent *entry)
+{
+	return entry->d_type == DT_REG || entry->d_type == DT_UNKNOWN;
+}
+
+// list a directory's inputs, sorted so every worker and every run agree on their indices
+cmin_corpus *
+cmin_scan(char *dir)
+{
+	struct dirent **entries = NULL;
+	int             count   = scandir(dir, &entries, cmin_filter, alphasort);
+	if (count < 0) {
+		log_fatal("Can't read the directory %s.", dir);
+	}
+
+	cmin_corpus *corpus = calloc(1, sizeof(cmin_corpus));
+	corpus->dir         = strdup(dir);
+	corpus->names       = calloc((size_t)count + 1, sizeof(char *));
+	for (int i = 0; i < count; i++) {
+		corpus->names[corpus->count++] = strdup(entries[i]->d_name);
+		free(entries[i]);
+	}
+	free(entries);
+	return corpus;
+}
+
+void
+cmin_free(cmin_corpus *corpus)
+{
+	for (size_t i = 0; i < corpus->count; i++) {
+		free(corpus->names[i]);
+	}
+	free(corpus->names);
+	free(corpus->dir);
+	free(corpus);
+}
+
+// read an input, returning NULL if it can't be read
+static u8 *
+cmin_read(cmin_corpus *corpus, size_t index, size_t *size)
+{
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s", corpus->dir, corpus->names[index]);
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	struct stat st;
+	u8         *input = NULL;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		*size = (size_t)st.st_size;
+		input = malloc(*size ? *size : 1);
+		if (input != NULL && read(fd, input, *size) != (ssize_t)*size) {
+			free(input);
+			input = NULL;
+		}
+	}
+	close(fd);
+	return input;
+}
+
+// run the first input that runs cleanly, to learn how large the jig's results are
+size_t
+cmin_results_size(jig_api *jig, cmin_corpus *corpus)
+{
+	for (size_t i = 0; i < corpus->count; i++) {
+		size_t size  = 0;
+		u8    *input = cmin_read(corpus, i, &size);
+		if (input == NULL) {
+			continue;
+		}
+		u8    *results      = NULL;
+		size_t results_size = 0;
+		char  *reason       = jig->run(input, size, &results, &results_size);
+		free(input);
+		if (reason == NULL && results_size > 0) {
+			return results_size;
+		}
+	}
+	log_fatal("No input in %s runs cleanly.", corpus->dir);
+}
+
+// replay every workers'th input, keeping the best input for each tuple they hit
+void
+cmin_replay(jig_api *jig, cmin_corpus *corpus, u32 worker, u32 workers, cmin_best *table, size_t tuples, cmin_stats *stats)
+{
+	for (size_t i = worker; i < corpus->count; i += workers) {
+		size_t size  = 0;
+		u8    *input = cmin_read(corpus, i, &size);
+		if (input == NULL) {
+			log_warn("Can't read %s/%s, skipping it.", corpus->dir, corpus->names[i]);
+			__atomic_store_n(&stats->skipped, stats->skipped + 1, __ATOMIC_RELAXED);
+			continue;
+		}
+
+		u8    *results      = NULL;
+		size_t results_size = 0;
+		u64    before       = now_ns();
+		char  *reason       = jig->run(input, size, &results, &results_size);
+		u64    exec_ns      = now_ns() - before;
+		free(input);
+		__atomic_store_n(&stats->exec_ns, stats->exec_ns + exec_ns, __ATOMIC_RELAXED);
+		__atomic_store_n(&stats->replayed, stats->replayed + 1, __ATOMIC_RELAXED);
+
+		// like afl-cmin, inputs that crash or hang are left out
+		if (reason != NULL) {
+			__atomic_store_n(&stats->skipped, stats->skipped + 1, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (CMIN_TUPLES(results_size) != tuples) {
+			log_fatal("%s/%s has %zu bytes of results, not %zu.", corpus->dir, corpus->names[i], results_size, tuples / 8);
+		}
+
+		// nothing scores 0, which marks a tuple no input hits
+		u64 score = MAX((u64)size, 1) * MAX(exec_ns / 1000, 1);
+		for (size_t byte = 0; byte < results_size; byte++) {
+			for (u8 bits = results[byte]; bits != 0; bits &= (u8)(bits - 1)) {
+				cmin_best *best = &table[byte * 8 + (size_t)__builtin_ctz(bits)];
+				best->hits++;
+				if (best->score == 0 || score < best->score) {
+					best->score = score;
+					best->input = (u32)i;
+				}
+			}
+		}
+	}
+}
+
+// fold one worker's table into another, ties go to the earlier input so the result does not depend on the workers
+void
+cmin_merge(cmin_best *into, cmin_best *from, size_t tuples)
+{
+	for (size_t t = 0; t < tuples; t++) {
+		if (from[t].score == 0) {
+			continue;
+		}
+		into[t].hits += from[t].hits;
+		if (into[t].score == 0 || from[t].score < into[t].score ||
+		    (from[t].score == into[t].score && from[t].input < into[t].input)) {
+			into[t].score = from[t].score;
+			into[t].input = from[t].input;
+		}
+	}
+}
+
+static cmin_best *sort_table = NULL;
+
+// rarest tuples first
+static int
+cmin_rarer(const void *a, const void *b)
+{
+	u32 ta = *(const u32 *)a;
+	u32 tb = *(const u32 *)b;
+	if (sort_table[ta].hits != sort_table[tb].hits) {
+		return sort_table[ta].hits < sort_table[tb].hits ? -1 : 1;
+	}
+	return ta < tb ? -1 : ta > tb;
+}
+
+// copy an input into the output directory
+static void
+cmin_write(char *output_dir, char *name, u8 *input, size_t size)
+{
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s", output_dir, name);
+	int fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+	if (fd < 0) {
+		log_fatal("Can't open %s.", path);
+	}
+	if (write(fd, input, size) != (ssize_t)size) {
+		log_fatal("Can't write %s.", path);
+	}
+	close(fd);
+}
+
+// greedily cover every tuple from the rarest up, writing the chosen inputs to output_dir and returning how many there are
+size_t
+cmin_select(jig_api *jig, cmin_corpus *corpus, cmin_best *table, size_t tuples, char *output_dir)
+{
+	u32   *order   = calloc(tuples, sizeof(u32));
+	u8    *covered = calloc(tuples / 8, 1);
+	u8    *chosen  = calloc(corpus->count ? corpus->count : 1, 1);
+	size_t hit     = 0;
+	for (size_t t = 0; t < tuples; t++) {
+		if (table[t].score != 0) {
+			order[hit++] = (u32)t;
+		}
+	}
+	sort_table = table;
+	qsort(order, hit, sizeof(u32), cmin_rarer);
+
+	size_t selected = 0;
+	for (size_t o = 0; o < hit; o++) {
+		u32 t = order[o];
+		if (covered[t / 8] & (1 << (t % 8))) {
+			continue;
+		}
+		covered[t / 8] |= (u8)(1 << (t % 8));
+		u32 index = table[t].input;
+		if (chosen[index]) {
+			continue;
+		}
+		chosen[index] = 1;
+		selected++;
+
+		// the chosen input's trace covers the rest of its tuples
+		size_t size  = 0;
+		u8    *input = cmin_read(corpus, index, &size);
+		if (input == NULL) {
+			log_fatal("Can't read %s/%s.", corpus->dir, corpus->names[index]);
+		}
+		u8    *results      = NULL;
+		size_t results_size = 0;
+		if (jig->run(input, size, &results, &results_size) == NULL && CMIN_TUPLES(results_size) == tuples) {
+			for (size_t byte = 0; byte < results_size; byte++) {
+				covered[byte] |= results[byte];
+			}
+		}
+		cmin_write(output_dir, corpus->names[index], input, size);
+		free(input);
+	}
+
+	sort_table = NULL;
+	free(order);
+	free(covered);
+	free(chosen);
+	return selected;
+}
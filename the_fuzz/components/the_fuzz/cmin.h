@@ -0,0 +1,59 @@
+#ifndef CMIN_H
+#define CMIN_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include <stdbool.h>
+
+#include "common/types.h"
+#include "jig.h"
+
+/*
+    cmin picks a subset of a directory of inputs that keeps every tuple the directory covers,
+    the way afl-cmin does. Workers replay a share of the inputs each and keep one table entry
+    per tuple (one bit of a byte of the jig's results) holding how many inputs hit it and the
+    best of them, scored by size times execution time, so no trace is kept. The tables are
+    merged, and tuples are visited from the rarest up: one not yet covered brings in its best
+    input, and that input's trace covers everything else it hits.
+*/
+
+#define CMIN_TUPLES(results_size) ((results_size) * 8)
+
+typedef struct cmin_best {
+	u64 score; // size times execution time of the best input, 0 if no input hits the tuple
+	u32 input; // index of the best input
+	u32 hits;  // number of inputs that hit the tuple
+} cmin_best;
+
+typedef struct cmin_corpus {
+	char  *dir;   // directory the inputs are in
+	char **names; // file names of the inputs, sorted
+	size_t count; // number of inputs
+} cmin_corpus;
+
+typedef struct cmin_stats {
+	u64 replayed; // inputs run
+	u64 skipped;  // inputs that crashed, hung or could not be read
+	u64 exec_ns;  // time spent running inputs
+} cmin_stats;
+
+cmin_corpus *cmin_scan(char *dir);
+void         cmin_free(cmin_corpus *corpus);
+size_t       cmin_results_size(jig_api *jig, cmin_corpus *corpus);
+void         cmin_replay(jig_api *jig, cmin_corpus *corpus, u32 worker, u32 workers, cmin_best *table, size_t tuples, cmin_stats *stats);
+void         cmin_merge(cmin_best *into, cmin_best *from, size_t tuples);
+size_t       cmin_select(jig_api *jig, cmin_corpus *corpus, cmin_best *table, size_t tuples, char *output_dir);
+
+#endif
@@ -0,0 +1,143 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "pack.h"
+
+/*
+    corpus_export writes the reports in a pack out as coverage/ and interesting/<reason>/
+    directories, with an .input and .results file per report named by the input's hash.
+*/
+
+#define EXPORT_NAME_SIZE 1024
+
+_Noreturn static void
+usage(const char *arg0)
+{
+	output("usage: %s [options]\n", arg0);
+	output("Optional:\n");
+	output("\t%-32s %-64s\n", "-d [pack directory]", "directory holding the pack (default " PACK_DIR ")");
+	output("\t%-32s %-64s\n", "-o [output directory]", "directory to write coverage/ and interesting/ to (default .)");
+	exit(1);
+}
+
+static void
+make_dir(char *name)
+{
+	if (mkdir(name, 0777) != 0 && errno != EEXIST) {
+		log_fatal("Can't create directory: '%s'.", name);
+	}
+}
+
+// write the record with hash to a file, returning false if the pack doesn't have it
+static bool
+export_record(pack *p, pack_hash hash, char *name)
+{
+	u64 offset = pack_find(p, hash);
+	if (offset == 0) {
+		return false;
+	}
+	pack_record record;
+	u8         *data = pack_read(p, offset, &record);
+	int         fd   = open(name, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+	if (fd < 0) {
+		log_fatal("Can't open file: '%s'.", name);
+	}
+	ssize_t write_val = write(fd, data, record.size);
+	if (write_val < 0 || (u64)write_val != record.size) {
+		log_fatal("Can't write to file: '%s'.", name);
+	}
+	close(fd);
+	free(data);
+	return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+	char *pack_dir   = PACK_DIR;
+	char *output_dir = ".";
+	int   opt;
+	init_logging();
+	while ((opt = getopt(argc, argv, "d:o:")) != -1) {
+		switch (opt) {
+		case 'd':
+			pack_dir = optarg;
+			break;
+		case 'o':
+			output_dir = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	pack *p = pack_open(pack_dir, false);
+
+	char dir[EXPORT_NAME_SIZE];
+	char name[EXPORT_NAME_SIZE + 64]; // the directory, the hash and an extension
+	make_dir(output_dir);
+	snprintf(dir, sizeof(dir), "%s/" COVERAGE_DIR, output_dir);
+	make_dir(dir);
+	snprintf(dir, sizeof(dir), "%s/" INTERESTING_DIR, output_dir);
+	make_dir(dir);
+
+	u64         cursor   = 0;
+	u64         exported = 0;
+	u64         missing  = 0;
+	pack_record record;
+	u8         *data;
+	while ((data = pack_next(p, &cursor, &record)) != NULL) {
+		if (record.type != PACK_REPORT || record.size != sizeof(pack_report)) {
+			free(data);
+			continue;
+		}
+		pack_report *report = (pack_report *)(void *)data;
+		report->reason[PACK_REASON_SIZE - 1] = '\0';
+		if (report->interesting) {
+			snprintf(dir, sizeof(dir), "%s/" INTERESTING_DIR "%s/", output_dir, report->reason);
+			make_dir(dir);
+		} else {
+			snprintf(dir, sizeof(dir), "%s/" COVERAGE_DIR, output_dir);
+		}
+
+		snprintf(name, sizeof(name), "%s%016" PRIx64 "%016" PRIx64 ".input", dir, report->input.hi, report->input.lo);
+		bool found = export_record(p, report->input, name);
+		if (found && report->results_size > 0) {
+			snprintf(name, sizeof(name), "%s%016" PRIx64 "%016" PRIx64 ".results", dir, report->input.hi, report->input.lo);
+			found = export_record(p, report->results, name);
+		}
+		if (found) {
+			exported++;
+		} else {
+			missing++;
+		}
+		free(data);
+	}
+	if (missing > 0) {
+		log_warn("%" PRIu64 " reports name inputs or results missing from the pack.", missing);
+	}
+	log_info("exported %" PRIu64 " reports from %s", exported, pack_dir);
+	pack_close(p);
+	return 0;
+}
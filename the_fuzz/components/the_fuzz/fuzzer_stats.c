@@ -0,0 +1,254 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "fuzzer_stats.h"
+
+#define STATS_INTERVAL_NS 5000000000ULL // how often fuzzer_stats and plot_data are updated
+#define STATS_NAP_NS 100000000          // how long the stats thread sleeps between checking if it should stop
+#define STATS_BUFFER_SIZE 4096
+#define NS_PER_SEC ((u64)1000000000)
+#define STATS_STRATEGY_SIZE (STAGES_MAX * 64)
+
+// a sum of every worker's stats at one point in time
+typedef struct stats_totals {
+	u64    execs;
+	u64    session_execs; // executions since this process started, without those resumed from a checkpoint
+	u64    coverage;
+	u64    crashes;
+	u64    hangs;
+	u64    crashes_suppressed;
+	u64    hangs_suppressed;
+	u64    queued;
+	u64    imported;
+	u64    iteration;
+	u64    pending;
+	u64    dropped;
+	u64    stage_execs[STAGES_MAX];
+	u64    stage_paths[STAGES_MAX];
+	double density;
+	double stability;
+} stats_totals;
+
+static worker_stats                *stats_all                           = NULL;
+static u32                          stats_workers                       = 0;
+static const char                 **stats_stages                        = NULL; // each stage's strategy name
+static u32                          stats_stage_count                   = 0;
+static char                         stats_strategy[STATS_STRATEGY_SIZE] = {0};  // the stages' names joined by commas
+static analysis_density_function   *stats_density                       = NULL;
+static analysis_stability_function *stats_stability                     = NULL;
+static pthread_t                    stats_thread;
+static bool                         stats_running = false;
+static bool                         stats_stop    = false;
+static u64                          start_ns      = 0; // monotonic, for rates
+static time_t                       start_time    = 0; // unix time, for people and monitors
+static u64                          last_ns       = 0;
+static u64                          last_execs    = 0;
+
+static void
+stats_sum(stats_totals *totals)
+{
+	memset(totals, 0, sizeof(stats_totals));
+	for (u32 w = 0; w < stats_workers; w++) {
+		worker_stats *s = &stats_all[w];
+		u64 execs       = __atomic_load_n(&s->execs, __ATOMIC_RELAXED);
+		totals->execs += execs;
+		totals->session_execs += execs - __atomic_load_n(&s->resumed, __ATOMIC_RELAXED);
+		totals->coverage += __atomic_load_n(&s->coverage, __ATOMIC_RELAXED);
+		totals->crashes += __atomic_load_n(&s->crashes, __ATOMIC_RELAXED);
+		totals->hangs += __atomic_load_n(&s->hangs, __ATOMIC_RELAXED);
+		totals->crashes_suppressed += __atomic_load_n(&s->crashes_suppressed, __ATOMIC_RELAXED);
+		totals->hangs_suppressed += __atomic_load_n(&s->hangs_suppressed, __ATOMIC_RELAXED);
+		totals->queued += __atomic_load_n(&s->queued, __ATOMIC_RELAXED);
+		totals->imported += __atomic_load_n(&s->imported, __ATOMIC_RELAXED);
+		totals->iteration += __atomic_load_n(&s->iteration, __ATOMIC_RELAXED);
+		totals->pending += __atomic_load_n(&s->writes.depth, __ATOMIC_RELAXED);
+		totals->dropped += __atomic_load_n(&s->writes.dropped, __ATOMIC_RELAXED);
+		for (u32 stage = 0; stage < stats_stage_count; stage++) {
+			totals->stage_execs[stage] += __atomic_load_n(&s->stage_execs[stage], __ATOMIC_RELAXED);
+			totals->stage_paths[stage] += __atomic_load_n(&s->stage_paths[stage], __ATOMIC_RELAXED);
+		}
+	}
+	totals->density   = stats_density != NULL ? stats_density() : -1.0;
+	totals->stability = stats_stability != NULL ? stats_stability() : -1.0;
+}
+
+// rewrite fuzzer_stats under a temporary name and rename it into place
+static void
+write_fuzzer_stats(stats_totals *totals, u64 now, double execs_per_sec, double recent_execs_per_sec)
+{
+	char buffer[STATS_BUFFER_SIZE];
+	int  length = snprintf(buffer, sizeof(buffer),
+	                       "start_time        : %lld\n"
+	                       "last_update       : %lld\n"
+	                       "run_time          : %" PRIu64 "\n"
+	                       "fuzzer_pid        : %d\n"
+	                       "workers           : %u\n"
+	                       "execs_done        : %" PRIu64 "\n"
+	                       "execs_per_sec     : %.2f\n"
+	                       "execs_per_sec_now : %.2f\n"
+	                       "paths_total       : %" PRIu64 "\n"
+	                       "paths_found       : %" PRIu64 "\n"
+	                       "paths_imported    : %" PRIu64 "\n"
+	                       "crashes           : %" PRIu64 "\n"
+	                       "hangs             : %" PRIu64 "\n"
+	                       "crashes_dupes     : %" PRIu64 "\n"
+	                       "hangs_dupes       : %" PRIu64 "\n"
+	                       "strategy          : %s\n"
+	                       "cur_iteration     : %" PRIu64 "\n"
+	                       "reports_pending   : %" PRIu64 "\n"
+	                       "reports_dropped   : %" PRIu64 "\n",
+	                       (long long)start_time, (long long)time(NULL), (now - start_ns) / NS_PER_SEC,
+	                       getpid(), stats_workers, totals->execs, execs_per_sec, recent_execs_per_sec,
+	                       totals->queued, totals->coverage, totals->imported, totals->crashes, totals->hangs,
+	                       totals->crashes_suppressed, totals->hangs_suppressed, stats_strategy,
+	                       totals->iteration, totals->pending, totals->dropped);
+	if (totals->density >= 0.0 && length > 0 && (size_t)length < sizeof(buffer)) {
+		length += snprintf(buffer + length, sizeof(buffer) - (size_t)length, "map_density       : %.2f%%\n", totals->density * 100.0);
+	}
+	if (totals->stability >= 0.0 && length > 0 && (size_t)length < sizeof(buffer)) {
+		length += snprintf(buffer + length, sizeof(buffer) - (size_t)length, "stability         : %.2f%%\n", totals->stability * 100.0);
+	}
+	// each stage's yield, in new paths per execution
+	for (u32 stage = 0; stats_stage_count > 1 && stage < stats_stage_count && length > 0 && (size_t)length < sizeof(buffer); stage++) {
+		u64 execs = totals->stage_execs[stage];
+		length += snprintf(buffer + length, sizeof(buffer) - (size_t)length,
+		                   "stage_%-11u : %s, %" PRIu64 " execs, %" PRIu64 " paths, %.6f paths/exec\n",
+		                   stage, stats_stages[stage], execs, totals->stage_paths[stage],
+		                   execs ? (double)totals->stage_paths[stage] / (double)execs : 0.0);
+	}
+	if (length < 0 || (size_t)length >= sizeof(buffer)) {
+		log_warn("fuzzer_stats does not fit in its buffer.");
+		return;
+	}
+
+	int fd = open(FUZZER_STATS_FILE ".tmp", O_CREAT | O_WRONLY | O_TRUNC, 0644);
+	if (fd < 0) {
+		log_warn("Can't open " FUZZER_STATS_FILE ".tmp");
+		return;
+	}
+	ssize_t write_val = write(fd, buffer, (size_t)length);
+	close(fd);
+	if (write_val != length || rename(FUZZER_STATS_FILE ".tmp", FUZZER_STATS_FILE) != 0) {
+		log_warn("Can't update " FUZZER_STATS_FILE);
+	}
+}
+
+// append a row to plot_data, starting the file with a header
+static void
+append_plot_data(stats_totals *totals, u64 now, double recent_execs_per_sec)
+{
+	char        buffer[STATS_BUFFER_SIZE];
+	int         length = 0;
+	struct stat st;
+	if (stat(PLOT_DATA_FILE, &st) != 0) {
+		length = snprintf(buffer, sizeof(buffer), "# unix_time, run_time, execs_done, execs_per_sec, paths_total, paths_found, crashes, hangs, map_density, cur_iteration\n");
+	}
+	length += snprintf(buffer + length, sizeof(buffer) - (size_t)length, "%lld, %" PRIu64 ", %" PRIu64 ", %.2f, %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %.2f%%, %" PRIu64 "\n",
+	                   (long long)time(NULL), (now - start_ns) / NS_PER_SEC, totals->execs, recent_execs_per_sec,
+	                   totals->queued, totals->coverage, totals->crashes, totals->hangs,
+	                   totals->density >= 0.0 ? totals->density * 100.0 : 0.0, totals->iteration);
+
+	// one append of the whole row, so readers never see half of one
+	int fd = open(PLOT_DATA_FILE, O_CREAT | O_WRONLY | O_APPEND, 0644);
+	if (fd < 0) {
+		log_warn("Can't open " PLOT_DATA_FILE);
+		return;
+	}
+	if (write(fd, buffer, (size_t)length) != length) {
+		log_warn("Can't append to " PLOT_DATA_FILE);
+	}
+	close(fd);
+}
+
+static void
+stats_update(void)
+{
+	stats_totals totals;
+	stats_sum(&totals);
+
+	u64    now           = now_ns();
+	double elapsed       = (double)(now - start_ns) / 1e9;
+	double since_last    = (double)(now - last_ns) / 1e9;
+	double execs_per_sec = elapsed > 0 ? (double)totals.session_execs / elapsed : 0.0;
+	double recent        = since_last > 0 ? (double)(totals.session_execs - last_execs) / since_last : 0.0;
+	last_ns              = now;
+	last_execs           = totals.session_execs;
+
+	write_fuzzer_stats(&totals, now, execs_per_sec, recent);
+	append_plot_data(&totals, now, recent);
+}
+
+static void *
+stats_loop(void *arg)
+{
+	(void)arg;
+	const struct timespec nap = {0, STATS_NAP_NS};
+	while (!__atomic_load_n(&stats_stop, __ATOMIC_ACQUIRE)) {
+		nanosleep(&nap, NULL);
+		if (now_ns() - last_ns >= STATS_INTERVAL_NS) {
+			stats_update();
+		}
+	}
+	return NULL;
+}
+
+// start updating fuzzer_stats and plot_data from every worker's stats, density and stability may be NULL
+void
+fuzzer_stats_start(worker_stats *all_stats, u32 workers, const char **stage_names, u32 stages,
+                   analysis_density_function *density, analysis_stability_function *stability)
+{
+	stats_all         = all_stats;
+	stats_workers     = workers;
+	stats_stages      = stage_names;
+	stats_stage_count = stages;
+	stats_density     = density;
+	stats_stability   = stability;
+	start_ns          = now_ns();
+	last_ns           = start_ns;
+	start_time        = time(NULL);
+	stats_stop        = false;
+
+	stats_strategy[0] = '\0';
+	for (u32 stage = 0; stage < stages; stage++) {
+		size_t used = strlen(stats_strategy);
+		snprintf(stats_strategy + used, sizeof(stats_strategy) - used, "%s%s", stage ? "," : "", stage_names[stage]);
+	}
+
+	if (pthread_create(&stats_thread, NULL, stats_loop, NULL) != 0) {
+		log_fatal("pthread_create() failed");
+	}
+	stats_running = true;
+}
+
+// stop the stats thread and write the final stats
+void
+fuzzer_stats_stop(void)
+{
+	if (!stats_running) {
+		return;
+	}
+	__atomic_store_n(&stats_stop, true, __ATOMIC_RELEASE);
+	pthread_join(stats_thread, NULL);
+	stats_running = false;
+	stats_update();
+}
@@ -0,0 +1,72 @@
+#ifndef FUZZER_STATS_H
+#define FUZZER_STATS_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include <time.h>
+
+#include "analysis.h"
+#include "common/types.h"
+#include "writer.h"
+
+/*
+    Every worker counts what it does in a worker_stats kept in a shared mapping.
+    A stats thread in the_fuzz's main process reads them on an interval, rewrites
+    fuzzer_stats with a rename so readers never see a partial file, and appends a row to plot_data.
+*/
+
+#define FUZZER_STATS_FILE "fuzzer_stats"
+#define PLOT_DATA_FILE "plot_data"
+#define STAGES_MAX 8 // strategies -O can chain
+
+// per worker counters, kept in a shared mapping so the parent can report on every worker
+typedef struct worker_stats {
+	u64 execs;              // number of executions
+	u64 resumed;            // executions carried over from a checkpoint
+	u64 coverage;           // number of inputs with new coverage
+	u64 interesting;        // number of crashes and timeouts
+	u64 crashes;            // number of crashes with new coverage in the crash bucket
+	u64 hangs;              // number of timeouts with new coverage in the hang bucket
+	u64 crashes_suppressed; // number of crashes the crash bucket had already seen
+	u64 hangs_suppressed;   // number of timeouts the hang bucket had already seen
+	u64 calibrated;         // number of inputs with new coverage that were re-run to find their variable bytes
+	u64 imported;           // number of inputs from other instances that added coverage
+	u64 stage;              // index of the stage the worker is running
+	u64 queued;             // number of entries in the worker's queue
+	u64 iteration;          // the worker's current iteration
+	u64 start_ns;           // when the worker started fuzzing
+	u64 end_ns;             // when the worker finished fuzzing, 0 while running
+	u64 checkpoint;         // last checkpoint request the worker has written, UINT64_MAX after its last one
+
+	u64 stage_execs[STAGES_MAX]; // executions of each stage's mutations
+	u64 stage_paths[STAGES_MAX]; // inputs each stage's mutations added to the queue
+
+	writer_stats writes; // the worker's coverage and interesting reports
+} worker_stats;
+
+// monotonic wall clock time, which counts time spent waiting on the target
+static inline u64
+now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+void fuzzer_stats_start(worker_stats *all_stats, u32 workers, const char **stage_names, u32 stages,
+                        analysis_density_function *density, analysis_stability_function *stability);
+void fuzzer_stats_stop(void);
+
+#endif
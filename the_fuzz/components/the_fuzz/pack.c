@@ -0,0 +1,658 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <wmmintrin.h>
+
+#include "common/logger.h"
+#include "pack.h"
+
+#define PACK_MAGIC 0x4b434150U                // "PACK", starts every record
+#define PACK_FILE_MAGIC 0x314b434150465447ULL // "GTFPACK1", starts the pack
+#define PACK_INDEX_MAGIC 0x3358444e4f465447ULL // "GTFONDX3", starts the index
+#define PACK_INDEX_SLOTS (1ULL << 22)         // slots in the first table, must be a power of two
+#define PACK_TABLES 64                        // most tables an index ever has, each twice the size of the one before
+#define PACK_GROW_LOAD 7                      // tenths of a table's slots published before it is rehashed into a bigger one
+#define PACK_SLOT_EMPTY 0                     // a slot's offset before it is claimed
+#define PACK_SLOT_BUSY 1                      // a slot's offset while its records are written
+#define PACK_ALIGN 8
+#define PACK_NAME_SIZE 1024
+
+typedef struct pack_slot {
+	u64       offset; // offset of the record in the pack, or PACK_SLOT_EMPTY or PACK_SLOT_BUSY
+	pack_hash hash;
+} pack_slot;
+
+// the index file, mapped shared by every worker
+typedef struct pack_index {
+	u64 magic;
+	u64 generation; // the table new slots are claimed in
+	u64 complete;   // the newest table every slot of the one before it has been copied to
+	u64 growing;    // set while a worker rehashes the table into a bigger one
+	u64 tail;       // end of the pack, including space reserved by writers
+	u64 published;  // end of the last record published, written after its records and slots
+} pack_index;
+
+// a table of slots, in a file of its own named after the index and its generation.
+// A table is never resized, the index moves on to a bigger one instead.
+typedef struct pack_table {
+	u64       capacity; // number of slots
+	u64       count;    // number of published slots
+	pack_slot slots[];
+} pack_table;
+
+struct pack {
+	int         fd;
+	int         index_fd;
+	bool        writable;
+	char       *dir;
+	pack_index *index;
+	pack_table *tables[PACK_TABLES]; // mapped when first needed, by generation
+};
+
+static size_t
+padded(size_t size)
+{
+	return (size + PACK_ALIGN - 1) & ~(size_t)(PACK_ALIGN - 1);
+}
+
+// two AES rounds per 16 bytes, enough to spread a one byte change over the whole state
+static inline __m128i
+hash_block(__m128i state, __m128i block)
+{
+	const __m128i key_1 = _mm_set_epi64x(0x243f6a8885a308d3LL, 0x13198a2e03707344LL);
+	const __m128i key_2 = _mm_set_epi64x(0x452821e638d01377LL, (long long)0xbe5466cf34e90c6cULL);
+	return _mm_aesenc_si128(_mm_aesenc_si128(_mm_xor_si128(state, block), key_1), key_2);
+}
+
+// 128-bit hash of a buffer, with the record type mixed in so an input and results with the same bytes differ
+pack_hash
+pack_hash_buffer(pack_type type, u8 *buffer, size_t size)
+{
+	__m128i state = _mm_set_epi64x((long long)size, (long long)type);
+	size_t  i     = 0;
+	for (; i + 16 <= size; i += 16) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+		state = hash_block(state, _mm_loadu_si128((const __m128i *)(buffer + i)));
+#pragma clang diagnostic pop
+	}
+	u8 last[16] = {0};
+	memcpy(last, buffer + i, size - i);
+	state = hash_block(state, _mm_loadu_si128((const __m128i *)last));
+	for (u32 round = 0; round < 4; round++) {
+		state = hash_block(state, _mm_set_epi64x((long long)size, (long long)round));
+	}
+
+	pack_hash hash;
+	_mm_storeu_si128((__m128i *)&hash, state);
+	return hash;
+}
+
+static inline bool
+hash_equal(pack_hash a, pack_hash b)
+{
+	return a.lo == b.lo && a.hi == b.hi;
+}
+
+static int
+open_or_die(char *dir, char *file, bool create)
+{
+	char name[PACK_NAME_SIZE];
+	snprintf(name, sizeof(name), "%s/%s", dir, file);
+	int fd = open(name, create ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+	if (fd < 0) {
+		log_fatal("Can't open pack file: '%s'.", name);
+	}
+	return fd;
+}
+
+static void
+pwrite_or_die(int fd, void *buffer, size_t size, u64 offset)
+{
+	u8 *bytes = buffer;
+	while (size > 0) {
+		ssize_t written = pwrite(fd, bytes, size, (off_t)offset);
+		if (written < 0 && errno == EINTR) {
+			continue;
+		}
+		if (written <= 0) {
+			log_fatal("Can't write to the pack.");
+		}
+		bytes += written;
+		size -= (size_t)written;
+		offset += (u64)written;
+	}
+}
+
+static bool
+pread_all(int fd, void *buffer, size_t size, u64 offset)
+{
+	return size == 0 || pread(fd, buffer, size, (off_t)offset) == (ssize_t)size;
+}
+
+static void
+table_name(pack *p, u64 generation, char *name)
+{
+	snprintf(name, PACK_NAME_SIZE, "%s/" PACK_INDEX ".%" PRIu64, p->dir, generation);
+}
+
+static size_t
+table_size(u64 capacity)
+{
+	return sizeof(pack_table) + capacity * sizeof(pack_slot);
+}
+
+// create the table of a generation, returning false if it can't be.
+// A table is sparse, so only the slots in use take up space.
+static bool
+table_create(pack *p, u64 generation, u64 capacity)
+{
+	char name[PACK_NAME_SIZE];
+	table_name(p, generation, name);
+	int fd = open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	pack_table header = {capacity, 0};
+	bool       sized  = ftruncate(fd, (off_t)table_size(capacity)) == 0 &&
+	             pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+	close(fd);
+	return sized;
+}
+
+// the table of a generation, NULL if it is gone because every slot was copied to the next one
+static pack_table *
+table_map(pack *p, u64 generation)
+{
+	if (generation >= PACK_TABLES) {
+		log_fatal("Pack index is corrupt: '%s/" PACK_INDEX "'.", p->dir);
+	}
+	pack_table *table = __atomic_load_n(&p->tables[generation], __ATOMIC_ACQUIRE);
+	if (table != NULL) {
+		return table;
+	}
+
+	char name[PACK_NAME_SIZE];
+	table_name(p, generation, name);
+	int fd = open(name, p->writable ? O_RDWR : O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	struct stat st;
+	void       *map = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(pack_table)) {
+		map = mmap(NULL, (size_t)st.st_size, PROT_READ | (p->writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	table = map;
+	if (map == MAP_FAILED || (size_t)st.st_size < table_size(table->capacity)) {
+		log_fatal("Pack index is corrupt: '%s'.", name);
+	}
+
+	// another thread may have mapped it first
+	pack_table *mapped = NULL;
+	if (!__atomic_compare_exchange_n(&p->tables[generation], &mapped, table, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		munmap(map, (size_t)st.st_size);
+		return mapped;
+	}
+	return table;
+}
+
+// the table new slots are claimed in, and its generation
+static pack_table *
+table_current(pack *p, u64 *generation)
+{
+	for (;;) {
+		u64         current = __atomic_load_n(&p->index->generation, __ATOMIC_SEQ_CST);
+		pack_table *table   = table_map(p, current);
+		if (table != NULL) {
+			*generation = current;
+			return table;
+		}
+		if (__atomic_load_n(&p->index->generation, __ATOMIC_SEQ_CST) == current) {
+			log_fatal("Pack index is corrupt: '%s/" PACK_INDEX "'.", p->dir);
+		}
+	}
+}
+
+// open the pack in dir, creating it if create is set, which also opens it for writing.
+// Workers must share a pack opened before they fork, so only one process ever creates it.
+pack *
+pack_open(char *dir, bool create)
+{
+	if (create && mkdir(dir, 0777) != 0 && errno != EEXIST) {
+		log_fatal("Can't create pack directory: '%s'.", dir);
+	}
+
+	pack *p = calloc(1, sizeof(pack));
+	if (p == NULL) {
+		log_fatal("calloc() failed");
+	}
+	p->dir = strdup(dir);
+	if (p->dir == NULL) {
+		log_fatal("strdup() failed");
+	}
+	p->writable = create;
+	p->fd       = open_or_die(dir, PACK_FILE, create);
+	p->index_fd = open_or_die(dir, PACK_INDEX, create);
+
+	struct stat st;
+	fstat(p->index_fd, &st);
+	if (st.st_size == 0 && create) {
+		// the first table is in place before the index names it
+		pack_index header = {PACK_INDEX_MAGIC, 0, 0, 0, sizeof(u64), sizeof(u64)};
+		u64        magic  = PACK_FILE_MAGIC;
+		if (!table_create(p, 0, PACK_INDEX_SLOTS)) {
+			log_fatal("Can't size the pack index.");
+		}
+		pwrite_or_die(p->index_fd, &header, sizeof(header), 0);
+		pwrite_or_die(p->fd, &magic, sizeof(magic), 0);
+		fstat(p->index_fd, &st);
+	}
+
+	p->index = mmap(NULL, sizeof(pack_index), PROT_READ | (create ? PROT_WRITE : 0), MAP_SHARED, p->index_fd, 0);
+	if ((size_t)st.st_size < sizeof(pack_index) || p->index == MAP_FAILED || p->index->magic != PACK_INDEX_MAGIC) {
+		log_fatal("Pack index is corrupt: '%s/" PACK_INDEX "'.", dir);
+	}
+	u64 generation;
+	table_current(p, &generation);
+	return p;
+}
+
+void
+pack_close(pack *p)
+{
+	for (u64 generation = 0; generation < PACK_TABLES; generation++) {
+		if (p->tables[generation] != NULL) {
+			munmap(p->tables[generation], table_size(p->tables[generation]->capacity));
+		}
+	}
+	munmap(p->index, sizeof(pack_index));
+	close(p->index_fd);
+	close(p->fd);
+	free(p->dir);
+	free(p);
+}
+
+// make the pack and its index durable, before a checkpoint that relies on them
+void
+pack_sync(pack *p)
+{
+	u64         generation;
+	pack_table *table = table_current(p, &generation);
+	if (fsync(p->fd) != 0 || msync(table, table_size(table->capacity), MS_SYNC) != 0 ||
+	    msync(p->index, sizeof(pack_index), MS_SYNC) != 0 || fsync(p->index_fd) != 0) {
+		log_warn("Can't sync the pack: %s", strerror(errno));
+	}
+}
+
+// the pack's file descriptor, for writers that submit their own writes
+int
+pack_fd(pack *p)
+{
+	return p->fd;
+}
+
+// find a record's offset in a table, 0 if it has none
+static u64
+table_find(pack_table *table, pack_hash hash)
+{
+	u64 mask = table->capacity - 1;
+	for (u64 probe = 0; probe < table->capacity; probe++) {
+		pack_slot *slot   = &table->slots[(hash.lo + probe) & mask];
+		u64        offset = __atomic_load_n(&slot->offset, __ATOMIC_ACQUIRE);
+		if (offset == PACK_SLOT_EMPTY) {
+			return 0;
+		}
+		if (offset != PACK_SLOT_BUSY && hash_equal(slot->hash, hash)) {
+			return offset;
+		}
+	}
+	return 0;
+}
+
+// find a record's offset in the pack, 0 if it has none
+u64
+pack_find(pack *p, pack_hash hash)
+{
+	u64         generation;
+	pack_table *table  = table_current(p, &generation);
+	u64         offset = table_find(table, hash);
+	// while a bigger table is filled in, a record may only be in the one before it
+	if (offset == 0 && generation > 0 && __atomic_load_n(&p->index->complete, __ATOMIC_SEQ_CST) != generation) {
+		pack_table *previous = table_map(p, generation - 1);
+		offset               = table_find(previous != NULL ? previous : table, hash);
+	}
+	return offset;
+}
+
+// claim a slot of a table for a new record, returning false if the record is already in it.
+// Slots still being written are passed over, so a record racing with itself may be stored twice, never lost.
+static bool
+table_claim(pack_table *table, pack_hash hash, u64 *claimed)
+{
+	u64 mask = table->capacity - 1;
+	for (u64 probe = 0; probe < table->capacity; probe++) {
+		u64        i      = (hash.lo + probe) & mask;
+		pack_slot *slot   = &table->slots[i];
+		u64        offset = __atomic_load_n(&slot->offset, __ATOMIC_ACQUIRE);
+		if (offset == PACK_SLOT_EMPTY) {
+			if (__atomic_compare_exchange_n(&slot->offset, &offset, PACK_SLOT_BUSY, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+				slot->hash = hash;
+				*claimed   = i;
+				return true;
+			}
+		}
+		if (offset != PACK_SLOT_EMPTY && offset != PACK_SLOT_BUSY && hash_equal(slot->hash, hash)) {
+			return false;
+		}
+	}
+	log_fatal("The pack index is full.");
+}
+
+// publish a record that is already written in a table, unless the table has it
+static void
+table_insert(pack_table *table, pack_hash hash, u64 offset)
+{
+	u64 slot;
+	if (table_claim(table, hash, &slot)) {
+		__atomic_store_n(&table->slots[slot].offset, offset, __ATOMIC_SEQ_CST);
+		__atomic_fetch_add(&table->count, 1, __ATOMIC_RELAXED);
+	}
+}
+
+// rehash the table of a generation into one twice its size, unless another worker already is.
+// Writers claim slots in the new table as soon as the index names it, and a writer publishing
+// a slot of the old table once the copy may have passed it publishes it in the new one too,
+// so the copy never waits for a writer and a writer only waits for the copy if it grows the table.
+static void
+pack_grow(pack *p, u64 generation, pack_table *table)
+{
+	static bool warned = false;
+	u64         idle   = 0;
+	if (generation + 1 >= PACK_TABLES || !__atomic_compare_exchange_n(&p->index->growing, &idle, 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+	if (__atomic_load_n(&p->index->generation, __ATOMIC_SEQ_CST) != generation) {
+		__atomic_store_n(&p->index->growing, 0, __ATOMIC_RELEASE);
+		return;
+	}
+
+	u64 capacity = table->capacity * 2;
+	if (!table_create(p, generation + 1, capacity)) {
+		if (!warned) {
+			log_warn("Can't grow the pack index past %" PRIu64 " slots: %s", table->capacity, strerror(errno));
+			warned = true;
+		}
+		__atomic_store_n(&p->index->growing, 0, __ATOMIC_RELEASE);
+		return;
+	}
+	pack_table *bigger = table_map(p, generation + 1);
+	if (bigger == NULL) {
+		log_fatal("Can't map the pack index.");
+	}
+	__atomic_store_n(&p->index->generation, generation + 1, __ATOMIC_SEQ_CST);
+
+	for (u64 i = 0; i < table->capacity; i++) {
+		u64 offset = __atomic_load_n(&table->slots[i].offset, __ATOMIC_SEQ_CST);
+		if (offset != PACK_SLOT_EMPTY && offset != PACK_SLOT_BUSY) {
+			table_insert(bigger, table->slots[i].hash, offset);
+		}
+	}
+	__atomic_store_n(&p->index->complete, generation + 1, __ATOMIC_SEQ_CST);
+
+	// workers that mapped the old table keep it until they close the pack
+	char name[PACK_NAME_SIZE];
+	table_name(p, generation, name);
+	unlink(name);
+	__atomic_store_n(&p->index->growing, 0, __ATOMIC_RELEASE);
+	log_info("grew the pack index to %" PRIu64 " slots", capacity);
+}
+
+// claim a slot for a new record in the current table, growing it first if it is loaded enough,
+// returning false if the record is already in the pack
+static bool
+pack_claim(pack *p, pack_hash hash, u64 *generation, u64 *claimed)
+{
+	pack_table *table = table_current(p, generation);
+	if (__atomic_load_n(&table->count, __ATOMIC_RELAXED) >= table->capacity / 10 * PACK_GROW_LOAD) {
+		pack_grow(p, *generation, table);
+		table = table_current(p, generation);
+	}
+	if (*generation > 0 && __atomic_load_n(&p->index->complete, __ATOMIC_SEQ_CST) != *generation) {
+		pack_table *previous = table_map(p, *generation - 1);
+		if (previous != NULL && table_find(previous, hash) != 0) {
+			return false;
+		}
+	}
+	return table_claim(table, hash, claimed);
+}
+
+// add a record to a staged report if the pack doesn't have it yet
+static void
+stage_record(pack *p, pack_staged *staged, pack_type type, pack_hash hash, void *data, size_t size)
+{
+	u64 generation;
+	u64 slot;
+	if (!pack_claim(p, hash, &generation, &slot)) {
+		return;
+	}
+	size_t      record_size = sizeof(pack_record) + padded(size);
+	pack_record record      = {PACK_MAGIC, type, size, hash};
+	staged->buffer          = realloc(staged->buffer, staged->size + record_size);
+	if (staged->buffer == NULL) {
+		log_fatal("realloc() failed");
+	}
+	memset(staged->buffer + staged->size, 0, record_size);
+	memcpy(staged->buffer + staged->size, &record, sizeof(record));
+	memcpy(staged->buffer + staged->size + sizeof(record), data, size);
+
+	staged->generations[staged->count] = generation;
+	staged->slots[staged->count]       = slot;
+	staged->offsets[staged->count]     = staged->size;
+	staged->count++;
+	staged->size += record_size;
+}
+
+// stage the records a report needs and reserve room for them in the pack,
+// returning false if the pack already has the report
+bool
+pack_stage_report(pack *p, pack_staged *staged, u8 *input, size_t size, u8 *results, size_t results_size, char *reason)
+{
+	memset(staged, 0, sizeof(pack_staged));
+
+	pack_report report;
+	memset(&report, 0, sizeof(report));
+	report.input = pack_hash_buffer(PACK_INPUT, input, size);
+	stage_record(p, staged, PACK_INPUT, report.input, input, size);
+	if (results_size > 0) {
+		report.results      = pack_hash_buffer(PACK_RESULTS, results, results_size);
+		report.results_size = (u32)results_size;
+		stage_record(p, staged, PACK_RESULTS, report.results, results, results_size);
+	}
+	if (reason != NULL) {
+		report.interesting = 1;
+		strncpy(report.reason, reason, PACK_REASON_SIZE - 1);
+	}
+	stage_record(p, staged, PACK_REPORT, pack_hash_buffer(PACK_REPORT, (u8 *)&report, sizeof(report)), &report, sizeof(report));
+
+	if (staged->count == 0) {
+		return false;
+	}
+	staged->offset = __atomic_fetch_add(&p->index->tail, staged->size, __ATOMIC_RELAXED);
+	for (u32 i = 0; i < staged->count; i++) {
+		staged->offsets[i] += staged->offset;
+	}
+	return true;
+}
+
+// write a staged report to the pack with a plain syscall
+void
+pack_write(pack *p, pack_staged *staged)
+{
+	pwrite_or_die(p->fd, staged->buffer, staged->size, staged->offset);
+}
+
+// make a staged report's records visible once they are written, and free it
+void
+pack_publish(pack *p, pack_staged *staged)
+{
+	for (u32 i = 0; i < staged->count; i++) {
+		pack_table *table = table_map(p, staged->generations[i]);
+		pack_slot  *slot  = &table->slots[staged->slots[i]];
+		__atomic_store_n(&slot->offset, staged->offsets[i], __ATOMIC_SEQ_CST);
+		__atomic_fetch_add(&table->count, 1, __ATOMIC_RELAXED);
+		// the table may have been copied to a bigger one before the slot was published in it
+		u64 generation;
+		if (__atomic_load_n(&p->index->generation, __ATOMIC_SEQ_CST) != staged->generations[i]) {
+			table_insert(table_current(p, &generation), slot->hash, staged->offsets[i]);
+		}
+	}
+	// readers of the file alone read up to here, so it only moves on once the records are written
+	u64 end       = staged->offset + staged->size;
+	u64 published = __atomic_load_n(&p->index->published, __ATOMIC_ACQUIRE);
+	while (published < end && !__atomic_compare_exchange_n(&p->index->published, &published, end, true, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+	}
+	free(staged->buffer);
+	staged->buffer = NULL;
+}
+
+// read the record at offset, returning its data, which the caller frees
+u8 *
+pack_read(pack *p, u64 offset, pack_record *record)
+{
+	if (!pread_all(p->fd, record, sizeof(pack_record), offset) || record->magic != PACK_MAGIC) {
+		log_fatal("Pack record at %" PRIu64 " is corrupt.", offset);
+	}
+	u8 *data = malloc(record->size + 1);
+	if (data == NULL || !pread_all(p->fd, data, record->size, offset + sizeof(pack_record))) {
+		log_fatal("Pack record at %" PRIu64 " is corrupt.", offset);
+	}
+	return data;
+}
+
+// read the next record from cursor, which starts at 0, returning its data or NULL at the end of the pack.
+// Space reserved by a writer that died before publishing is skipped, since no slot points at it.
+u8 *
+pack_next(pack *p, u64 *cursor, pack_record *record)
+{
+	return pack_scan(p, cursor, pack_tail(p), 0, record);
+}
+
+// the end of the pack, including space writers have reserved and not published yet
+u64
+pack_tail(pack *p)
+{
+	return __atomic_load_n(&p->index->tail, __ATOMIC_ACQUIRE);
+}
+
+// read the next record of a type, or of any type if type is 0, that starts before end.
+// Records of other types are passed over without reading their data.
+u8 *
+pack_scan(pack *p, u64 *cursor, u64 end, pack_type type, pack_record *record)
+{
+	u64 at = MAX(*cursor, sizeof(u64));
+	for (; at + sizeof(pack_record) <= end; at += PACK_ALIGN) {
+		if (!pread_all(p->fd, record, sizeof(pack_record), at)) {
+			break;
+		}
+		if (record->magic == PACK_MAGIC && pack_find(p, record->hash) == at) {
+			*cursor = at + sizeof(pack_record) + padded(record->size);
+			if (type != 0 && record->type != type) {
+				at = *cursor - PACK_ALIGN;
+				continue;
+			}
+			return pack_read(p, at, record);
+		}
+	}
+	*cursor = at;
+	return NULL;
+}
+
+// the end of the last record published, read from the index file rather than its mapping,
+// so an instance on another host sees it once the file does
+u64
+pack_published(pack *p)
+{
+	u64 published = 0;
+	if (!pread_all(p->index_fd, &published, sizeof(published), offsetof(pack_index, published))) {
+		return 0;
+	}
+	return published;
+}
+
+// read the record at offset if it is all there before end, its data matching the hash in its header,
+// returning its data, which the caller frees, or NULL if it is still being written
+static u8 *
+read_complete(pack *p, u64 at, u64 end, pack_record *record)
+{
+	if (!pread_all(p->fd, record, sizeof(pack_record), at) || record->magic != PACK_MAGIC || record->type < PACK_INPUT ||
+	    record->type > PACK_REPORT || record->size > end - at - sizeof(pack_record)) {
+		return NULL;
+	}
+	u8 *data = malloc(record->size + 1);
+	if (data == NULL) {
+		log_fatal("malloc() failed");
+	}
+	if (!pread_all(p->fd, data, record->size, at + sizeof(pack_record)) ||
+	    !hash_equal(pack_hash_buffer((pack_type)record->type, data, record->size), record->hash)) {
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+// read the record at cursor through the file alone, for an instance reading the pack of another one,
+// whose index mapping may be stale. Returns the record's data, which the caller frees, and moves cursor
+// past it, or NULL at end or at a record not all written yet, leaving cursor there. With skip set,
+// it moves on to the next complete record before end instead, past space a writer that died left empty.
+u8 *
+pack_take(pack *p, u64 *cursor, u64 end, bool skip, pack_record *record)
+{
+	for (u64 at = MAX(*cursor, sizeof(u64)); at + sizeof(pack_record) <= end; at += PACK_ALIGN) {
+		u8 *data = read_complete(p, at, end, record);
+		if (data != NULL) {
+			*cursor = at + sizeof(pack_record) + padded(record->size);
+			return data;
+		}
+		if (!skip) {
+			break;
+		}
+	}
+	return NULL;
+}
+
+// whether dir holds a pack that is fully created, for readers that may race with the process creating it
+bool
+pack_exists(char *dir)
+{
+	char name[PACK_NAME_SIZE];
+	snprintf(name, sizeof(name), "%s/%s", dir, PACK_INDEX);
+	int fd = open(name, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	u64  magic  = 0;
+	bool exists = pread_all(fd, &magic, sizeof(magic), 0) && magic == PACK_INDEX_MAGIC;
+	close(fd);
+	return exists;
+}
@@ -0,0 +1,107 @@
+#ifndef PACK_H
+#define PACK_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/types.h"
+
+/*
+    The pack is the campaign's corpus store: one append-only file of records and one
+    index file mapping a record's 128-bit hash to where it is in the pack.
+    Inputs and results are stored once however many reports name them, and a report
+    record names its input and results by hash. The index is an open addressing table
+    mapped shared, so every worker appends to the same pack: a writer claims an index slot,
+    reserves space at the end of the pack, writes its records and then publishes the slot.
+    The slots are in a table of their own, and when one is loaded enough a writer rehashes it into
+    one twice its size, bumping the index's generation so every worker and reader maps the new one.
+    A record is only ever reached through a published slot, so one torn by a crash is never read.
+    Another instance reading the pack goes through the files alone: it reads up to the end of the
+    last record published, which the index holds, and checks each record against its hash.
+    corpus_export writes a pack back out as coverage/ and interesting/ directories.
+*/
+
+#define PACK_DIR "corpus/"
+#define PACK_FILE "pack"
+#define PACK_INDEX "index"
+#define PACK_REASON_SIZE 64 // longest reason kept for an interesting report
+
+// the layout corpus_export writes a pack out to
+#define COVERAGE_DIR "coverage/"
+#define INTERESTING_DIR "interesting/"
+
+typedef enum pack_type {
+	PACK_INPUT = 1, // an input
+	PACK_RESULTS,   // the results of an input
+	PACK_REPORT,    // a pack_report
+} pack_type;
+
+typedef struct pack_hash {
+	u64 lo;
+	u64 hi;
+} pack_hash;
+
+// the header of every record in the pack, followed by its data padded to 8 bytes
+typedef struct pack_record {
+	u32       magic;
+	u32       type; // a pack_type
+	u64       size; // bytes of data
+	pack_hash hash; // hash of the type and data, which is the record's key in the index
+} pack_record;
+
+// a coverage or interesting report, the data of a PACK_REPORT record
+typedef struct pack_report {
+	pack_hash input;
+	pack_hash results;                  // zero if the report has no results
+	u32       interesting;              // 0 for coverage
+	u32       results_size;             // 0 if the report has no results
+	char      reason[PACK_REASON_SIZE]; // why an interesting report is interesting
+} pack_report;
+
+#define PACK_STAGED_RECORDS 3 // input, results and report
+
+// the new records of a report, staged to be written to the pack in one piece
+typedef struct pack_staged {
+	u8    *buffer;                           // the records back to back
+	size_t size;                             // bytes in buffer
+	u64    offset;                           // where buffer goes in the pack
+	u32    count;                            // number of records
+	u64    generations[PACK_STAGED_RECORDS]; // the index table each record's slot is in
+	u64    slots[PACK_STAGED_RECORDS];       // the index slot claimed for each record
+	u64    offsets[PACK_STAGED_RECORDS];     // where each record goes in the pack
+} pack_staged;
+
+typedef struct pack pack;
+
+pack     *pack_open(char *dir, bool create);
+void      pack_close(pack *p);
+void      pack_sync(pack *p);
+int       pack_fd(pack *p);
+pack_hash pack_hash_buffer(pack_type type, u8 *buffer, size_t size);
+bool      pack_stage_report(pack *p, pack_staged *staged, u8 *input, size_t size, u8 *results, size_t results_size, char *reason);
+void      pack_write(pack *p, pack_staged *staged);
+void      pack_publish(pack *p, pack_staged *staged);
+u64       pack_find(pack *p, pack_hash hash);
+u8       *pack_read(pack *p, u64 offset, pack_record *record);
+u8       *pack_next(pack *p, u64 *cursor, pack_record *record);
+u64       pack_tail(pack *p);
+u8       *pack_scan(pack *p, u64 *cursor, u64 end, pack_type type, pack_record *record);
+u64       pack_published(pack *p);
+u8       *pack_take(pack *p, u64 *cursor, u64 end, bool skip, pack_record *record);
+bool      pack_exists(char *dir);
+
+#endif
@@ -0,0 +1,78 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/logger.h"
+#include "queue.h"
+
+#define QUEUE_INITIAL_ENTRIES 64
+#define QUEUE_INITIAL_DATA 65536
+
+// create an empty queue
+queue *
+queue_create()
+{
+	queue *q = calloc(1, sizeof(queue));
+	if (q == NULL) {
+		log_fatal("calloc() failed");
+	}
+	return q;
+}
+
+// free a queue and every input in it
+void
+queue_free(queue *q)
+{
+	free(q->entries);
+	free(q->data);
+	free(q);
+}
+
+// append a copy of an input to the queue, returning the index of its entry
+size_t
+queue_add(queue *q, u8 *input, size_t size, u32 exec_us)
+{
+	if (q->count == q->capacity) {
+		q->capacity = q->capacity ? q->capacity * 2 : QUEUE_INITIAL_ENTRIES;
+		q->entries  = realloc(q->entries, q->capacity * sizeof(queue_entry));
+		if (q->entries == NULL) {
+			log_fatal("realloc() failed");
+		}
+	}
+
+	if (q->data_size + size > q->data_capacity) {
+		size_t capacity = q->data_capacity ? q->data_capacity : QUEUE_INITIAL_DATA;
+		while (q->data_size + size > capacity) {
+			capacity *= 2;
+		}
+		q->data = realloc(q->data, capacity);
+		if (q->data == NULL) {
+			log_fatal("realloc() failed");
+		}
+		q->data_capacity = capacity;
+	}
+
+	queue_entry *entry = &q->entries[q->count];
+	entry->offset       = q->data_size;
+	entry->size         = (u32)size;
+	entry->exec_us      = exec_us;
+	entry->new_coverage = 0;
+	entry->fuzzed       = 0;
+
+	memcpy(q->data + q->data_size, input, size);
+	q->data_size += size;
+
+	return q->count++;
+}
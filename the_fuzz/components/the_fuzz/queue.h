@@ -0,0 +1,53 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include "common/types.h"
+
+/*
+    The queue is the in-memory corpus that the_fuzz schedules strategies over.
+    Inputs live back to back in one data arena, and entries refer to them by offset,
+    so the entries stay small and scheduling never touches the disk.
+*/
+typedef struct queue_entry {
+	u64 offset;       // offset of the input in the queue's data arena
+	u32 size;         // size of the input
+	u32 exec_us;      // how long the input took to run, in microseconds
+	u32 new_coverage; // number of inputs with new coverage found by fuzzing this entry
+	u32 fuzzed;       // number of times a strategy has been run over this entry
+} queue_entry;
+
+typedef struct queue {
+	queue_entry *entries;       // one entry per input
+	size_t       count;         // number of entries
+	size_t       capacity;      // number of entries allocated
+	u8          *data;          // the inputs
+	size_t       data_size;     // bytes of data in use
+	size_t       data_capacity; // bytes of data allocated
+} queue;
+
+queue *queue_create(void);
+void   queue_free(queue *q);
+size_t queue_add(queue *q, u8 *input, size_t size, u32 exec_us);
+
+// get the input of an entry, only valid until the next queue_add
+static inline u8 *
+queue_input(queue *q, size_t index)
+{
+	return q->data + q->entries[index].offset;
+}
+
+#endif
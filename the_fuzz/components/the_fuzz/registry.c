@@ -0,0 +1,107 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common/logger.h"
+#include "registry.h"
+
+/*
+    static_modules.h is generated by CMake, and lists every module linked into the binary:
+    STATIC_STRATEGIES names each strategy's name_populate, and STATIC_JIGS and STATIC_ANALYSES
+    name the getters that the jig and analysis sources define in place of get_jig_api and get_analysis_api.
+*/
+#include "static_modules.h"
+
+typedef struct strategy_entry {
+	const char                   *name;
+	get_fuzzing_strategy_function populate;
+} strategy_entry;
+
+typedef struct jig_entry {
+	const char     *name;
+	jig_api_getter *get_api;
+} jig_entry;
+
+typedef struct analysis_entry {
+	const char          *name;
+	analysis_api_getter *get_api;
+} analysis_entry;
+
+#define DECLARE_STRATEGY(name) void name##_populate(fuzzing_strategy *strategy);
+#define DECLARE_JIG(name) extern jig_api_getter name##_get_jig_api;
+#define DECLARE_ANALYSIS(name) extern analysis_api_getter name##_get_analysis_api;
+STATIC_STRATEGIES(DECLARE_STRATEGY)
+STATIC_JIGS(DECLARE_JIG)
+STATIC_ANALYSES(DECLARE_ANALYSIS)
+
+#define STRATEGY_ENTRY(name) {#name, name##_populate},
+#define JIG_ENTRY(name) {#name, &name##_get_jig_api},
+#define ANALYSIS_ENTRY(name) {#name, &name##_get_analysis_api},
+static const strategy_entry strategies[] = {STATIC_STRATEGIES(STRATEGY_ENTRY)};
+static const jig_entry      jigs[]       = {STATIC_JIGS(JIG_ENTRY)};
+static const analysis_entry analyses[]   = {STATIC_ANALYSES(ANALYSIS_ENTRY)};
+
+#define REGISTRY_NAME_SIZE 256
+
+// strip the directory and the extension off of a module name, so "ooze/afl_havoc.so" is "afl_havoc"
+static void
+base_name(char *name, char *base)
+{
+	char *slash = strrchr(name, '/');
+	snprintf(base, REGISTRY_NAME_SIZE, "%s", slash ? slash + 1 : name);
+	char *dot = strchr(base, '.');
+	if (dot != NULL) {
+		*dot = '\0';
+	}
+}
+
+get_fuzzing_strategy_function
+registry_strategy(char *name)
+{
+	char base[REGISTRY_NAME_SIZE];
+	base_name(name, base);
+	for (size_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++) {
+		if (strcmp(strategies[i].name, base) == 0) {
+			return strategies[i].populate;
+		}
+	}
+	log_fatal("Couldn't find strategy: %s", name);
+}
+
+jig_api_getter
+registry_jig(char *name)
+{
+	char base[REGISTRY_NAME_SIZE];
+	base_name(name, base);
+	for (size_t i = 0; i < sizeof(jigs) / sizeof(jigs[0]); i++) {
+		if (strcmp(jigs[i].name, base) == 0) {
+			return *jigs[i].get_api;
+		}
+	}
+	log_fatal("Couldn't find jig: %s", name);
+}
+
+analysis_api_getter
+registry_analysis(char *name)
+{
+	char base[REGISTRY_NAME_SIZE];
+	base_name(name, base);
+	for (size_t i = 0; i < sizeof(analyses) / sizeof(analyses[0]); i++) {
+		if (strcmp(analyses[i].name, base) == 0) {
+			return *analyses[i].get_api;
+		}
+	}
+	log_fatal("Couldn't find analysis: %s", name);
+}
@@ -0,0 +1,33 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include "analysis.h"
+#include "jig.h"
+#include "ooze.h"
+
+/*
+    The registry is how the_fuzz_static, the all-in-one build, finds its modules.
+    Every strategy, jig and analysis is linked into the binary, and the names given to
+    -O, -J and -S are looked up in tables built at compile time instead of being dlopened.
+    A name may still be a path or have an extension, only its base name is used.
+*/
+
+get_fuzzing_strategy_function registry_strategy(char *name);
+jig_api_getter                registry_jig(char *name);
+analysis_api_getter           registry_analysis(char *name);
+
+#endif
@@ -0,0 +1,241 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "common/logger.h"
+#include "sync.h"
+
+// instance names become directory names, so they can't leave the sync directory
+bool
+sync_name_valid(char *name)
+{
+	return name[0] != '\0' && name[0] != '.' && strchr(name, '/') == NULL && strlen(name) < SYNC_NAME_SIZE;
+}
+
+// where an instance keeps its pack in the sync directory
+void
+sync_pack_dir(char *dir, char *name, char *pack_dir, size_t size)
+{
+	if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+		log_fatal("Can't create sync directory: '%s'.", dir);
+	}
+	snprintf(pack_dir, size, "%s/%s", dir, name);
+}
+
+static void
+mark_name(sync_state *s, char *peer, bool temp, char *name, size_t size)
+{
+	snprintf(name, size, "%s/%s/" SYNC_MARKS_DIR "%s%s", s->dir, s->name, peer, temp ? ".tmp" : "");
+}
+
+// read the high-water mark saved for a peer, 0 if there is none
+static u64
+load_mark(sync_state *s, char *peer)
+{
+	char name[SYNC_FILE_SIZE];
+	mark_name(s, peer, false, name, sizeof(name));
+	FILE *file = fopen(name, "r");
+	if (file == NULL) {
+		return 0;
+	}
+	u64 mark = 0;
+	if (fscanf(file, "%" SCNu64, &mark) != 1) {
+		mark = 0;
+	}
+	fclose(file);
+	return mark;
+}
+
+// start reading the peers that have a pack and aren't read yet
+static void
+add_peers(sync_state *s)
+{
+	DIR *dir = opendir(s->dir);
+	if (dir == NULL) {
+		log_warn("Can't open sync directory: '%s'.", s->dir);
+		return;
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (!sync_name_valid(entry->d_name) || strcmp(entry->d_name, s->name) == 0) {
+			continue;
+		}
+		bool known = false;
+		for (u32 p = 0; p < s->count && !known; p++) {
+			known = strcmp(s->peers[p].name, entry->d_name) == 0;
+		}
+		char pack_dir[SYNC_FILE_SIZE];
+		snprintf(pack_dir, sizeof(pack_dir), "%s/%s", s->dir, entry->d_name);
+		if (known || !pack_exists(pack_dir)) {
+			continue;
+		}
+
+		s->peers = realloc(s->peers, sizeof(sync_peer) * (s->count + 1));
+		if (s->peers == NULL) {
+			log_fatal("realloc() failed");
+		}
+		sync_peer *peer = &s->peers[s->count++];
+		memset(peer, 0, sizeof(sync_peer));
+		memcpy(peer->name, entry->d_name, strlen(entry->d_name) + 1);
+		peer->store  = pack_open(pack_dir, false);
+		peer->cursor = load_mark(s, peer->name);
+		log_info("syncing from %s, read up to %" PRIu64, peer->name, peer->cursor);
+	}
+	closedir(dir);
+}
+
+// import from the peers in the sync directory, own is the pack the instance writes there
+sync_state *
+sync_create(char *dir, char *name, pack *own)
+{
+	sync_state *s = calloc(1, sizeof(sync_state));
+	if (s == NULL) {
+		log_fatal("calloc() failed");
+	}
+	strncpy(s->dir, dir, SYNC_PATH_SIZE - 1);
+	strncpy(s->name, name, SYNC_NAME_SIZE - 1);
+	s->own = own;
+
+	char marks[SYNC_FILE_SIZE];
+	snprintf(marks, sizeof(marks), "%s/%s/" SYNC_MARKS_DIR, dir, name);
+	if (mkdir(marks, 0777) != 0 && errno != EEXIST) {
+		log_fatal("Can't create sync directory: '%s'.", marks);
+	}
+	return s;
+}
+
+// start a round, which reads each peer up to the end of the records it has published
+void
+sync_round(sync_state *s)
+{
+	add_peers(s);
+	for (u32 p = 0; p < s->count; p++) {
+		sync_peer *peer = &s->peers[p];
+		// count the rounds in a row that stopped short of their end at the same record
+		bool short_of_end = MAX(peer->cursor, sizeof(u64)) + sizeof(pack_record) <= peer->end;
+		peer->stalls      = short_of_end && peer->cursor == peer->stalled ? peer->stalls + 1 : 0;
+		peer->stalled     = peer->cursor;
+		peer->end         = MAX(peer->end, pack_published(peer->store));
+	}
+	s->current = 0;
+	s->rounds++;
+}
+
+// the next record of a peer this round, which the caller frees, or NULL at a record that isn't all written yet.
+// Once the rounds have stopped there SYNC_STALL_ROUNDS times, its writer has died, and the record is passed over.
+static u8 *
+take_record(sync_peer *peer, pack_record *record)
+{
+	u64 from = peer->cursor;
+	u8 *data = pack_take(peer->store, &peer->cursor, peer->end, false, record);
+	if (data == NULL && peer->stalls >= SYNC_STALL_ROUNDS) {
+		data = pack_take(peer->store, &peer->cursor, peer->end, true, record);
+		if (data != NULL) {
+			log_warn("passed over an unfinished record of %s at %" PRIu64, peer->name, from);
+			peer->stalls = 0;
+		}
+	}
+	return data;
+}
+
+// the next input with coverage from a peer this round, which the caller frees, or NULL when the round is done
+u8 *
+sync_next(sync_state *s, size_t max_size, size_t *size)
+{
+	for (; s->current < s->count; s->current++) {
+		sync_peer  *peer = &s->peers[s->current];
+		pack_record record;
+		u8         *data;
+		while ((data = take_record(peer, &record)) != NULL) {
+			// a report's input is written just before it, unless the peer had it already
+			if (record.type == PACK_INPUT) {
+				free(peer->input);
+				peer->input      = data;
+				peer->input_size = record.size;
+				peer->input_hash = record.hash;
+				continue;
+			}
+			pack_report report;
+			bool        coverage = record.type == PACK_REPORT && record.size == sizeof(pack_report);
+			if (coverage) {
+				memcpy(&report, data, sizeof(report));
+				coverage = report.interesting == 0;
+			}
+			free(data);
+			if (!coverage || pack_find(s->own, report.input) != 0) {
+				continue;
+			}
+			u8    *input      = NULL;
+			size_t input_size = 0;
+			if (peer->input != NULL && peer->input_hash.lo == report.input.lo && peer->input_hash.hi == report.input.hi) {
+				input       = peer->input;
+				input_size  = peer->input_size;
+				peer->input = NULL;
+			} else {
+				u64 offset = pack_find(peer->store, report.input);
+				if (offset == 0) {
+					continue;
+				}
+				input      = pack_read(peer->store, offset, &record);
+				input_size = record.size;
+			}
+			if (input_size == 0 || input_size > max_size) {
+				free(input);
+				continue;
+			}
+			s->read++;
+			*size = input_size;
+			return input;
+		}
+	}
+	return NULL;
+}
+
+// save how far each peer has been read
+void
+sync_save(sync_state *s)
+{
+	for (u32 p = 0; p < s->count; p++) {
+		char temp_name[SYNC_FILE_SIZE];
+		char name[SYNC_FILE_SIZE];
+		mark_name(s, s->peers[p].name, true, temp_name, sizeof(temp_name));
+		mark_name(s, s->peers[p].name, false, name, sizeof(name));
+		FILE *file = fopen(temp_name, "w");
+		if (file == NULL) {
+			log_warn("Can't save the sync mark for %s.", s->peers[p].name);
+			continue;
+		}
+		fprintf(file, "%" PRIu64 "\n", s->peers[p].cursor);
+		if (fclose(file) != 0 || rename(temp_name, name) != 0) {
+			log_warn("Can't save the sync mark for %s.", s->peers[p].name);
+		}
+	}
+}
+
+void
+sync_free(sync_state *s)
+{
+	for (u32 p = 0; p < s->count; p++) {
+		pack_close(s->peers[p].store);
+		free(s->peers[p].input);
+	}
+	free(s->peers);
+	free(s);
+}
@@ -0,0 +1,77 @@
+#ifndef SYNC_H
+#define SYNC_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/types.h"
+#include "pack.h"
+
+/*
+    Instances sharing a sync directory each keep their pack in a directory named after
+    the instance, and import their peers' coverage from there. A peer's pack is append-only,
+    so the offset an instance has read it up to is its high-water mark: each round reads only
+    the records appended since, and the cost of a round doesn't grow with the peer's corpus.
+    The peer's pack is read with pread rather than through its mappings, which a shared file
+    system needn't keep coherent, and a round reads up to the end the peer last published.
+    The mark only moves past records that are all there, so a round stops at one a writer has
+    reserved but not finished and the next round picks it up. Space still unfinished after
+    SYNC_STALL_ROUNDS rounds was left by a writer that died, and is passed over.
+    Inputs the instance's own pack already holds are skipped, and the rest are run and kept
+    only if they add coverage.
+    The high-water marks are saved to .synced/ in the instance's directory with its checkpoints.
+*/
+
+#define SYNC_MARKS_DIR ".synced/"
+#define SYNC_NAME_SIZE 256
+#define SYNC_PATH_SIZE 1024
+#define SYNC_FILE_SIZE (SYNC_PATH_SIZE + 2 * SYNC_NAME_SIZE + 16) // a file in an instance's directory
+#define DEFAULT_SYNC_INTERVAL 30                                  // seconds between rounds
+#define SYNC_STALL_ROUNDS 10                                      // rounds a peer's unfinished record is waited for
+
+typedef struct sync_peer {
+	char      name[SYNC_NAME_SIZE];
+	pack     *store;
+	u64       cursor;     // how far the peer's pack has been read
+	u64       end;        // where this round stops reading it
+	u64       stalled;    // where the last round stopped
+	u32       stalls;     // rounds in a row that stopped there short of their end
+	u8       *input;      // the last input read, which the report after it names
+	size_t    input_size;
+	pack_hash input_hash;
+} sync_peer;
+
+typedef struct sync_state {
+	char       dir[SYNC_PATH_SIZE];  // the sync directory
+	char       name[SYNC_NAME_SIZE]; // this instance's directory in it
+	pack      *own;                  // this instance's pack
+	sync_peer *peers;
+	u32        count;
+	u32        current; // peer being read this round
+	u64        rounds;
+	u64        read;    // peer inputs read
+} sync_state;
+
+bool        sync_name_valid(char *name);
+void        sync_pack_dir(char *dir, char *name, char *pack_dir, size_t size);
+sync_state *sync_create(char *dir, char *name, pack *own);
+void        sync_round(sync_state *s);
+u8         *sync_next(sync_state *s, size_t max_size, size_t *size);
+void        sync_save(sync_state *s);
+void        sync_free(sync_state *s);
+
+#endif
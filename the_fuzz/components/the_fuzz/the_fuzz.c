@@ -11,33 +11,88 @@
 // Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
 
 #include <bits/stdint-uintn.h>
-#include <bits/types/clock_t.h>
+#ifndef GTFO_STATIC
 #include <dlfcn.h>
+#endif
+#include <errno.h>
 #include <fcntl.h>
+#include <ftw.h>
 #include <getopt.h>
-#include <nmmintrin.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "affinity.h"
 #include "analysis.h"
+#include "checkpoint.h"
+#include "cmin.h"
 #include "common/logger.h"
 #include "common/types.h"
+#include "fuzzer_stats.h"
 #include "jig.h"
 #include "ooze.h"
+#include "pack.h"
+#include "queue.h"
+#include "sync.h"
+#include "tmin.h"
+#include "writer.h"
+#ifdef GTFO_STATIC
+#include "registry.h"
+#endif
 
-static fuzzing_strategy strategy;
+static fuzzing_strategy strategy;                // the stage being run
+static fuzzing_strategy stages[STAGES_MAX];      // the strategies from -O, run one after the other
+static const char      *stage_names[STAGES_MAX]; // and their names
+static u32              stage_count = 0;
+static u32              stage       = 0;         // index of the stage being run
 static jig_api          jig;
 static analysis_api     analysis;
 
-static void *strategy_lib = NULL;
-static void *jig_lib      = NULL;
-static void *analysis_lib = NULL;
+#ifndef GTFO_STATIC
+static void *strategy_libs[STAGES_MAX] = {0};
+static void *jig_lib                   = NULL;
+static void *analysis_lib              = NULL;
+#endif
 
+static worker_stats    *all_stats      = NULL;        // stats for every worker
+static worker_stats    *stats          = NULL;        // stats for this process
+static pthread_mutex_t *analysis_lock  = NULL;        // serializes analysis.add between workers
+static writer          *reports        = NULL;        // writes coverage and interesting reports off of the exec loop
+static pack            *store          = NULL;        // the corpus store the reports are written to
+static writer_backend   report_backend = WRITER_AUTO; // how the reports are written
+
+static u64  *checkpoint_request     = NULL;  // last checkpoint the parent asked its workers for, shared
+static u64   checkpoint_interval_ns = 0;     // time between checkpoints, 0 if they are off
+static u64   checkpoint_seen        = 0;     // last checkpoint request this worker handled
+static u64   checkpoint_last_ns     = 0;     // when this worker last checkpointed
+static pid_t checkpoint_pid         = 0;     // forked copy of this worker writing its checkpoint
+static bool  resume                 = false; // continue the campaign from its checkpoint
+static bool  bind_cores             = true;  // bind each worker and its target to free cores
+
+static char       *sync_dir     = NULL; // directory shared with other instances, NULL if this one doesn't sync
+static char       *sync_name    = NULL; // this instance's directory in it
+static sync_state *syncer       = NULL; // worker 0's import from the other instances
+static u64         sync_last_ns = 0;    // when worker 0 last imported
+
+#define REPORT_INTERVAL_NS 5000000000ULL // how often the parent reports on its workers
+#define DEFAULT_ENTRY_BUDGET 1024          // executions a random strategy spends on a queue entry per cycle
+#define DEFAULT_CHECKPOINT_INTERVAL 600    // seconds between checkpoints
+#define DEFAULT_CALIBRATION_RUNS 8         // like AFL's CAL_CYCLES
+#define CALIBRATION_BATCH 16               // calibration re-runs handed to a jig's run_batch at once
+#define EFFECTOR_SUBDIR "effector"         // where the pack directory keeps effector maps, unless EFFECTOR_DIR is set
+
+static u64 calibration_runs = DEFAULT_CALIBRATION_RUNS; // runs of an input with new coverage to find its variable bytes
+#define OPT_TMIN 256                       // long options without a short option
+#define OPT_CMIN 257
+
+#ifndef GTFO_STATIC
 #define MAX_PATH 1024
 
 #ifdef __linux__
@@ -49,28 +104,9 @@ static void *analysis_lib = NULL;
 #else
 #define PLATFORM_EXTENSTION ""
 #endif
+#endif
 
-#define INTERESTING_DIR "interesting/"
-#define COVERAGE_DIR "coverage/"
-
-static inline u32
-crc_buffer(u8 *buffer, size_t size)
-{
-	u32 crc = 1;
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wcast-align"
-	u64 *buffer_64 = (u64 *)buffer;
-#pragma clang diagnostic pop
-	for (size_t i = 0; i < size / 8; i++) {
-		crc = (u32)_mm_crc32_u64(crc, buffer_64[i]);
-	}
-
-	for (size_t i = (size / 8) * 8; i < size; i++) {
-		crc = _mm_crc32_u8(crc, buffer[i]);
-	}
-	return crc;
-}
-
+#ifndef GTFO_STATIC
 static void *
 load_module(char *module_name)
 {
@@ -123,12 +159,16 @@ load_module(char *module_name)
 	free(full_module_name);
 	return handle;
 }
+#endif
 
 // initialize analysis module
 static int
 initialize_analysis(char *analysis_library_name, char *analysis_load_file)
 {
 
+#ifdef GTFO_STATIC
+	registry_analysis(analysis_library_name)(&analysis);
+#else
 	analysis_lib                 = load_module(analysis_library_name);
 	analysis_api_getter *get_api = dlsym(analysis_lib, "get_analysis_api");
 	char                *error   = dlerror();
@@ -136,21 +176,44 @@ initialize_analysis(char *analysis_library_name, char *analysis_load_file)
 		log_fatal(error);
 	}
 	(*get_api)(&analysis);
+#endif
 	analysis.initialize(analysis_load_file);
 	return 0;
 }
 
-// initialize ooze strategy
+// initialize ooze strategies, a comma separated list of them are run as stages
 static int
-initialize_ooze(char *ooze_library_name)
+initialize_ooze(char *ooze_library_names)
 {
-	strategy_lib                                            = load_module(ooze_library_name);
-	get_fuzzing_strategy_function *get_fuzzing_strategy_ptr = dlsym(strategy_lib, "get_fuzzing_strategy");
-	char                          *error                    = dlerror();
-	if (error) {
-		log_fatal(error);
+	char *names = strdup(ooze_library_names);
+	char *rest  = names;
+	char *ooze_library_name;
+	while ((ooze_library_name = strsep(&rest, ",")) != NULL) {
+		if (*ooze_library_name == '\0') {
+			continue;
+		}
+		if (stage_count == STAGES_MAX) {
+			log_fatal("-O takes at most " STRINGIFY(STAGES_MAX) " strategies.");
+		}
+		fuzzing_strategy *next = &stages[stage_count];
+#ifdef GTFO_STATIC
+		registry_strategy(ooze_library_name)(next);
+#else
+		strategy_libs[stage_count]                              = load_module(ooze_library_name);
+		get_fuzzing_strategy_function *get_fuzzing_strategy_ptr = dlsym(strategy_libs[stage_count], "get_fuzzing_strategy");
+		char                          *error                    = dlerror();
+		if (error) {
+			log_fatal(error);
+		}
+		(*get_fuzzing_strategy_ptr)(next);
+#endif
+		stage_names[stage_count++] = next->name;
+	}
+	free(names);
+	if (stage_count == 0) {
+		log_fatal("-O names no strategy.");
 	}
-	(*get_fuzzing_strategy_ptr)(&strategy);
+	strategy = stages[0];
 
 	return 0;
 }
@@ -159,6 +222,9 @@ initialize_ooze(char *ooze_library_name)
 static int
 initialize_jig(char *jig_library_name)
 {
+#ifdef GTFO_STATIC
+	registry_jig(jig_library_name)(&jig);
+#else
 	jig_lib                 = load_module(jig_library_name);
 	jig_api_getter *get_api = dlsym(jig_lib, "get_jig_api");
 	char           *error   = dlerror();
@@ -166,17 +232,52 @@ initialize_jig(char *jig_library_name)
 		log_fatal(error);
 	}
 	(*get_api)(&jig);
+#endif
 	jig.initialize();
 	return 0;
 }
 
+// bind a worker and its target to free cores, if binding is on, and start its jig.
+// The worker binds before the jig maps its trace, so the map is local to the worker.
+static void
+start_jig(char *jig_library_name, bool pair, u32 worker)
+{
+	affinity bound = {.fuzzer = AFFINITY_NONE, .target = AFFINITY_NONE, .lock_fd = -1};
+	if (bind_cores && affinity_bind(pair, &bound)) {
+		char core[16];
+		snprintf(core, sizeof(core), "%d", bound.target);
+		setenv("JIG_CPU", core, 1);
+		log_info("worker %u bound to core %d, its target to core %d", worker, bound.fuzzer, bound.target);
+	}
+	if (initialize_jig(jig_library_name)) {
+		log_fatal("jig failed to initialize");
+	}
+	affinity_release(&bound);
+}
+
+static int
+remove_entry(const char *path, const struct stat *st __attribute__((unused)), int flag __attribute__((unused)), struct FTW *ftw __attribute__((unused)))
+{
+	return remove(path);
+}
+
+// remove a directory and everything in it, if it exists
+static void
+remove_tree(char *dir)
+{
+	struct stat st;
+	if (stat(dir, &st) == 0 && nftw(dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS) != 0) {
+		log_warn("Can't remove '%s': %s", dir, strerror(errno));
+	}
+}
+
 _Noreturn static void
 usage(const char *arg0)
 {
 	output("usage: %s [options]\n", arg0);
 	output("Required:\n");
 	output("\t%-32s %-64s\n", "-S [analysis modules]", "path to a analysis module");
-	output("\t%-32s %-64s\n", "-O [ooze modules]", "path to an ooze module");
+	output("\t%-32s %-64s\n", "-O [ooze modules]", "path to an ooze module, or a comma separated list of them run as stages one after the other");
 	output("\t%-32s %-64s\n", "-J [jig modules]", "path to a jig module");
 	output("\t%-32s %-64s\n", "-i [input file]", "input file");
 	output("\t%-32s %-64s\n", "-n [iteration count]", "number of times to fuzz");
@@ -187,6 +288,19 @@ usage(const char *arg0)
 
 	output("Optional:\n");
 	output("\t%-32s %-64s\n", "-C [analysis load file]", "file used to load analysis buffer");
+	output("\t%-32s %-64s\n", "-j [workers]", "number of worker processes sharing the analysis (default 1)");
+	output("\t%-32s %-64s\n", "-k [seconds]", "seconds between checkpoints to " CHECKPOINT_DIR ", 0 turns them off (default " STRINGIFY(DEFAULT_CHECKPOINT_INTERVAL) ")");
+	output("\t%-32s %-64s\n", "-r, --resume", "continue the campaign from its last checkpoint");
+	output("\t%-32s %-64s\n", "-w [io_uring|threads]", "how coverage and interesting reports are written (default io_uring when the kernel allows it)");
+	output("\t%-32s %-64s\n", "-K [calibration runs]", "runs of each input with new coverage, bytes that differ are masked from the analysis, 1 turns it off (default " STRINGIFY(DEFAULT_CALIBRATION_RUNS) ")");
+	output("\t%-32s %-64s\n", "-b [auto|off]", "bind each worker and its target to cores no other process is bound to (default auto)");
+	output("\t%-32s %-64s\n", "-y [sync directory]", "share coverage with the other instances in the directory, the pack goes in a directory named by -Y");
+	output("\t%-32s %-64s\n", "-Y [instance name]", "this instance's name in the sync directory, unique among the instances");
+	output("\t%-32s %-64s\n", "-e [execs per queue entry]", "executions a random strategy spends on each queue entry per cycle (default " STRINGIFY(DEFAULT_ENTRY_BUDGET) ")");
+
+	output("Minimizing (needs -J and -i):\n");
+	output("\t%-32s %-64s\n", "--tmin [output file]", "shrink the input while it keeps its trace or its crash, and write it out (needs -x, -n limits the executions)");
+	output("\t%-32s %-64s\n", "--cmin [output directory]", "copy the fewest inputs from the -i directory that keep its coverage, replayed by -j workers");
 
 	output("Options to the modules are passed via enviroment variables\n");
 	exit(1);
@@ -217,182 +331,1046 @@ load_input_file(char *input_file_name, u8 **base_input, size_t *base_size, size_
 	*base_size  = (size_t)file_size;
 }
 
-// report coverage results for non-interesting inputs
-static void
-report_coverage(u8 *input, size_t size, u8 *results, size_t results_size, uint32_t crc)
+// check results against the analysis, which may be shared with other workers
+static inline bool
+analysis_add(u8 *results, size_t results_size)
 {
-	char *coverage_name = NULL;
-	asprintf(&coverage_name, COVERAGE_DIR "%x.input", crc);
+	if (analysis_lock == NULL) {
+		return analysis.add(results, results_size);
+	}
+	pthread_mutex_lock(analysis_lock);
+	bool seen = analysis.add(results, results_size);
+	pthread_mutex_unlock(analysis_lock);
+	return seen;
+}
 
-	// open coverage file
-	int coverage_fd = open(coverage_name, O_CREAT | O_WRONLY, 0777);
-	if (coverage_fd < 0) {
-		log_fatal("Can't open coverage file: '%s'.", coverage_name);
+// check a crash or hang's results against its bucket, analyses without buckets have seen nothing
+static inline bool
+analysis_add_bucket(analysis_bucket bucket, u8 *results, size_t results_size)
+{
+	if (analysis.version < VERSION_THREE || results_size == 0) {
+		return false;
+	}
+	if (analysis_lock == NULL) {
+		return analysis.add_bucket(bucket, results, results_size);
 	}
+	pthread_mutex_lock(analysis_lock);
+	bool seen = analysis.add_bucket(bucket, results, results_size);
+	pthread_mutex_unlock(analysis_lock);
+	return seen;
+}
 
-	// write file
-	ssize_t write_val = write(coverage_fd, input, size);
-	if (write_val >= 0 && (size_t)write_val != size) {
-		log_fatal("Can't write to coverage file: '%s'.", coverage_name);
+/*
+    The exec loop is a two slot pipeline. An input is mutated into the free slot while the other
+    slot's input runs, and once that run is finished and the new one started, the finished input
+    is reported. So mutation and the analysis overlap the target, and inputs are still reported
+    in the order they were mutated. Jigs that can't split a run finish it when it is started, and
+    it is reported right away, before the jig reuses its results.
+
+    A jig with a pool of targets gets a slot per target instead. Each input is submitted as soon
+    as it is mutated, and then the oldest input is finished and reported, so the pool is kept busy
+    and inputs are still reported in order. Inputs that finish before their turn keep a copy of
+    their results, since the jig reuses its results on the next submit.
+*/
+#define PIPELINE_SLOTS 2
+
+typedef struct pipeline_slot {
+	u8            *input;        // the mutated input, a copy of the clean input between uses
+	size_t         size;         // size of the input
+	mutation_delta delta;        // how to undo the mutation
+	u64            iteration;    // the strategy state's iteration when the input was mutated
+	u64            start_ns;     // when the run started
+	u32            exec_us;      // how long the run took
+	char          *reason;       // why the run was interesting, NULL if it wasn't
+	u8            *results;      // the run's results, owned by the jig
+	size_t         results_size; // size of the results
+	bool           running;      // started and not finished
+	bool           finished;     // finished and not reported
+	sized_buffer   copy;         // the results, copied out of a pool jig
+} pipeline_slot;
+
+static pipeline_slot *pipeline       = NULL;           // the slots, pipeline_depth of them
+static size_t         pipeline_depth = PIPELINE_SLOTS; // more with a pool jig
+static bool           pipeline_pool  = false;          // does the jig run the slots' inputs side by side
+
+// start running a slot's input
+static void
+pipeline_start(pipeline_slot *slot)
+{
+	slot->start_ns = now_ns();
+	if (pipeline_pool) {
+		if (!jig.submit(slot->input, slot->size, (u64)(slot - pipeline))) {
+			log_fatal("The jig's pool is full.");
+		}
+		slot->running = true;
+	} else if (jig.version >= VERSION_TWO && jig.start != NULL) {
+		jig.start(slot->input, slot->size);
+		slot->running = true;
+	} else {
+		slot->reason   = jig.run(slot->input, slot->size, &slot->results, &slot->results_size);
+		slot->exec_us  = (u32)MIN((now_ns() - slot->start_ns) / 1000, UINT32_MAX);
+		slot->finished = true;
 	}
-	free(coverage_name);
-	close(coverage_fd);
+	__atomic_store_n(&stats->execs, stats->execs + 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&stats->stage_execs[stage], stats->stage_execs[stage] + 1, __ATOMIC_RELAXED);
+}
 
-	char *results_name = NULL;
-	asprintf(&results_name, COVERAGE_DIR "%x.results", crc);
+// record a pool's finished run in its slot
+static void
+pipeline_complete(pipeline_slot *slot, char *reason, u8 *results, size_t results_size)
+{
+	if (slot->copy.content_size < results_size) {
+		free(slot->copy.content);
+		slot->copy.content      = malloc(results_size);
+		slot->copy.content_size = results_size;
+		if (slot->copy.content == NULL) {
+			log_fatal("malloc() failed");
+		}
+	}
+	memcpy(slot->copy.content, results, results_size);
+	slot->reason       = reason;
+	slot->results      = slot->copy.content;
+	slot->results_size = results_size;
+	slot->exec_us      = (u32)MIN((now_ns() - slot->start_ns) / 1000, UINT32_MAX);
+	slot->running      = false;
+	slot->finished     = true;
+}
 
-	// open results file
-	int results_fd = open(results_name, O_CREAT | O_WRONLY, 0777);
-	if (results_fd < 0) {
-		log_fatal("Can't open results file: '%s'.", results_name);
+// wait for a slot's run, the time it took includes the work done while it ran
+static void
+pipeline_finish(pipeline_slot *slot)
+{
+	// a pool finishes its runs in any order
+	while (pipeline_pool && slot->running) {
+		u64    tag          = 0;
+		u8    *results      = NULL;
+		size_t results_size = 0;
+		char  *reason       = NULL;
+		if (!jig.poll_completed(&tag, &results, &results_size, &reason)) {
+			log_fatal("The jig lost a submitted input.");
+		}
+		pipeline_complete(&pipeline[tag], reason, results, results_size);
 	}
-	// write results file
-	write_val = write(results_fd, results, results_size);
-	if (write_val >= 0 && (size_t)write_val != results_size) {
-		log_fatal("Can't write to results file.");
+	if (!slot->running) {
+		return;
 	}
-	close(results_fd);
-	free(results_name);
+	slot->reason   = jig.finish(&slot->results, &slot->results_size);
+	slot->exec_us  = (u32)MIN((now_ns() - slot->start_ns) / 1000, UINT32_MAX);
+	slot->running  = false;
+	slot->finished = true;
 }
 
-// report results that we deem interesting
+// finish whatever is running, so the jig can be used directly
 static void
-report_interesting(u8 *input, size_t size, char *reason, u8 *results, size_t results_size, uint32_t crc)
+pipeline_settle(void)
 {
+	for (size_t s = 0; s < pipeline_depth; s++) {
+		if (pipeline[s].running) {
+			pipeline_finish(&pipeline[s]);
+		}
+	}
+}
 
-	char       *interesting_dir = NULL;
-	char       *filename        = NULL;
-	struct stat st;
+// re-run an input with new coverage and mask the bytes of its results that change from run to run,
+// so a nondeterministic target doesn't keep finding the same coverage
+static void
+calibrate(u8 *input, size_t size, u8 *results, size_t results_size)
+{
+	if (calibration_runs <= 1 || analysis.version < VERSION_FOUR) {
+		return;
+	}
+	static u8    *first         = NULL;
+	static u8    *variable      = NULL;
+	static size_t variable_size = 0;
+	if (variable_size != results_size) {
+		free(first);
+		free(variable);
+		first         = malloc(results_size);
+		variable      = malloc(results_size);
+		variable_size = results_size;
+	}
+	memcpy(first, results, results_size);
+	memset(variable, 0, results_size);
+	pipeline_settle();
+
+	// a jig that can batch runs the re-runs in as few children as it can
+	bool varies = false;
+	for (u64 run = 1; run < calibration_runs;) {
+		u8    *inputs[CALIBRATION_BATCH];
+		size_t input_sizes[CALIBRATION_BATCH];
+		u8    *again[CALIBRATION_BATCH];
+		size_t again_sizes[CALIBRATION_BATCH];
+		char  *reasons[CALIBRATION_BATCH];
+		size_t count = 1;
+		if (jig.version >= VERSION_FOUR && jig.run_batch != NULL) {
+			count = MIN(calibration_runs - run, CALIBRATION_BATCH);
+			for (size_t b = 0; b < count; b++) {
+				inputs[b]      = input;
+				input_sizes[b] = size;
+			}
+			jig.run_batch(inputs, input_sizes, count, again, again_sizes, reasons);
+		} else {
+			reasons[0] = jig.run(input, size, &again[0], &again_sizes[0]);
+		}
+		__atomic_store_n(&stats->execs, stats->execs + count, __ATOMIC_RELAXED);
+		run += count;
 
-	asprintf(&interesting_dir, INTERESTING_DIR "%s/", reason);
+		for (size_t b = 0; b < count; b++) {
+			if (reasons[b] != NULL || again_sizes[b] != results_size || memcmp(again[b], first, results_size) == 0) {
+				continue;
+			}
+			for (size_t i = 0; i < results_size; i++) {
+				if (again[b][i] != first[i]) {
+					variable[i] = 1;
+					varies      = true;
+				}
+			}
+		}
+	}
+	__atomic_store_n(&stats->calibrated, stats->calibrated + 1, __ATOMIC_RELAXED);
+	if (!varies) {
+		return;
+	}
 
-	// check if directory to analysis results in already exists
-	if (stat(interesting_dir, &st) != 0) {
-		mkdir(interesting_dir, 0777);
+	if (analysis_lock != NULL) {
+		pthread_mutex_lock(analysis_lock);
+	}
+	analysis.mask(variable, results_size);
+	if (analysis_lock != NULL) {
+		pthread_mutex_unlock(analysis_lock);
 	}
+}
 
-	// name of file to hold input
-	asprintf(&filename, "%s%x.input", interesting_dir, crc);
+// report an execution's results, returning true if the input added coverage
+static bool
+report(u8 *input, size_t size, char *reason, u8 *results, size_t results_size)
+{
+	bool is_new = false;
+
+	// report interesting inputs, unless their trace adds nothing to the crashes or hangs already seen
+	if (reason != NULL) {
+		bool hang = strcmp(reason, "timeout") == 0;
+		if (analysis_add_bucket(hang ? ANALYSIS_HANG : ANALYSIS_CRASH, results, results_size)) {
+			u64 *suppressed = hang ? &stats->hangs_suppressed : &stats->crashes_suppressed;
+			__atomic_store_n(suppressed, *suppressed + 1, __ATOMIC_RELAXED);
+		} else {
+			// log_debug("reporting interesting.");
+			writer_interesting(reports, input, size, reason, results, results_size);
+			__atomic_store_n(&stats->interesting, stats->interesting + 1, __ATOMIC_RELAXED);
+			u64 *unique = hang ? &stats->hangs : &stats->crashes;
+			__atomic_store_n(unique, *unique + 1, __ATOMIC_RELAXED);
+		}
+	}
 
-	// open file
-	int interesting_fd = open(filename, O_CREAT | O_WRONLY, 0777);
-	if (interesting_fd < 0) {
-		log_fatal("Can't open file to save interesting input: '%s'.", filename);
+	if (results_size > 0) {
+		// if not interesting, report coverage at least.
+		if (!analysis_add(results, results_size)) {
+			// log_debug("reporting coverage .");
+			writer_coverage(reports, input, size, results, results_size);
+			__atomic_store_n(&stats->coverage, stats->coverage + 1, __ATOMIC_RELAXED);
+			is_new = reason == NULL;
+		}
 	}
-	// write file
-	ssize_t write_val = write(interesting_fd, input, size);
-	if (write_val >= 0 && (size_t)write_val != size) {
-		log_fatal("Could not write to interesting file: '%s'.", filename);
+	return is_new;
+}
+
+// run an execution and report results, returning true if the input added coverage
+static bool
+run_and_report(u8 *input, size_t size, u32 *exec_us)
+{
+	u8    *results      = NULL;
+	size_t results_size = 0;
+
+	//  fuzz the binary, getting trace results, trace results size, and exit reason
+	u64   before = now_ns();
+	char *reason = jig.run(input, size, &results, &results_size);
+	*exec_us     = (u32)MIN((now_ns() - before) / 1000, UINT32_MAX);
+	__atomic_store_n(&stats->execs, stats->execs + 1, __ATOMIC_RELAXED);
+
+	bool is_new = report(input, size, reason, results, results_size);
+	if (is_new) {
+		calibrate(input, size, results, results_size);
 	}
+	return is_new;
+}
 
-	free(filename);
-	close(interesting_fd);
+// report a finished slot, queueing its input if it added coverage, and restore the clean input
+static void
+pipeline_report(pipeline_slot *slot, strategy_state *state, queue *corpus, size_t entry, u8 *clean, size_t clean_size)
+{
+	slot->finished = false;
+	bool is_new    = report(slot->input, slot->size, slot->reason, slot->results, slot->results_size);
+
+	// tell the strategy how its mutation did before calibrating re-runs the input over the results
+	if (strategy.version >= VERSION_THREE && strategy.report_feedback != NULL) {
+		strategy_feedback feedback = {
+		    .iteration    = slot->iteration,
+		    .is_new       = is_new,
+		    .interesting  = slot->reason != NULL,
+		    .exec_us      = slot->exec_us,
+		    .input        = slot->input,
+		    .size         = slot->size,
+		    .results      = slot->results,
+		    .results_size = slot->results_size,
+		};
+		strategy.report_feedback(state, &feedback);
+	}
 
-	// if there are trace results to be had
-	if (results_size > 0) {
+	if (is_new) {
+		calibrate(slot->input, slot->size, slot->results, slot->results_size);
+		queue_add(corpus, slot->input, slot->size, slot->exec_us);
+		corpus->entries[entry].new_coverage++;
+		__atomic_store_n(&stats->queued, corpus->count, __ATOMIC_RELAXED);
+		__atomic_store_n(&stats->stage_paths[stage], stats->stage_paths[stage] + 1, __ATOMIC_RELAXED);
+	}
+	slot->size = mutation_delta_revert(slot->input, clean, clean_size, &slot->delta);
+}
 
-		char *results_name = NULL;
+// run an entry's input unmodified and tell the strategy how it did,
+// so it has something to compare its mutations' results with
+static void
+feedback_clean(strategy_state *state, u8 *clean, size_t clean_size)
+{
+	if (strategy.version < VERSION_THREE || strategy.report_feedback == NULL) {
+		return;
+	}
+	u8    *results          = NULL;
+	size_t results_size     = 0;
+	u8    *comparisons      = NULL;
+	size_t comparisons_size = 0;
+	u64    before           = now_ns();
+	char  *reason;
+
+	// the clean input's comparisons tell strategies which values the target compares the input with
+	if (jig.version >= VERSION_THREE && jig.run_cmplog != NULL) {
+		reason = jig.run_cmplog(clean, clean_size, &results, &results_size, &comparisons, &comparisons_size);
+	} else {
+		reason = jig.run(clean, clean_size, &results, &results_size);
+	}
+	__atomic_store_n(&stats->execs, stats->execs + 1, __ATOMIC_RELAXED);
+
+	strategy_feedback feedback = {
+	    .iteration        = state->iteration,
+	    .clean            = true,
+	    .interesting      = reason != NULL,
+	    .exec_us          = (u32)MIN((now_ns() - before) / 1000, UINT32_MAX),
+	    .input            = clean,
+	    .size             = clean_size,
+	    .results          = results,
+	    .results_size     = results_size,
+	    .comparisons      = comparisons,
+	    .comparisons_size = comparisons_size,
+	};
+	strategy.report_feedback(state, &feedback);
+}
 
-		asprintf(&results_name, "%s%x.results", interesting_dir, crc);
-		// open file
-		int results_fd = open(results_name, O_CREAT | O_WRONLY, 0777);
-		if (results_fd < 0) {
-			log_fatal("Can't open file to save trace results to: '%s'.", results_name);
+// finish and report what is left in the pipeline, oldest first from the slot of iteration next
+static void
+pipeline_drain(strategy_state *state, queue *corpus, size_t entry, u8 *clean, size_t clean_size, u64 next)
+{
+	pipeline_settle();
+	for (size_t s = 0; s < pipeline_depth; s++) {
+		pipeline_slot *slot = &pipeline[(next + s) % pipeline_depth];
+		if (slot->finished) {
+			pipeline_report(slot, state, corpus, entry, clean, clean_size);
 		}
-		// write file
-		write_val = write(results_fd, results, results_size);
-		if (write_val >= 0 && (size_t)write_val != results_size) {
-			log_fatal("Can't write to results file '%s'.", results_name);
+	}
+}
+
+// import the inputs with new coverage the other instances found since the last round, between queue entries
+static void
+sync_tick(queue *corpus, size_t max_size)
+{
+	if (syncer == NULL || now_ns() - sync_last_ns < DEFAULT_SYNC_INTERVAL * 1000000000ULL) {
+		return;
+	}
+	sync_round(syncer);
+
+	u8    *input;
+	size_t size;
+	u32    exec_us;
+	while ((input = sync_next(syncer, max_size, &size)) != NULL) {
+		if (run_and_report(input, size, &exec_us)) {
+			queue_add(corpus, input, size, exec_us);
+			__atomic_store_n(&stats->imported, stats->imported + 1, __ATOMIC_RELAXED);
 		}
+		free(input);
+	}
+	__atomic_store_n(&stats->queued, corpus->count, __ATOMIC_RELAXED);
+	sync_last_ns = now_ns();
+}
 
-		close(results_fd);
-		free(results_name);
+// move a worker on to a stage, whose strategy starts over from the queue's first entry
+static void
+stage_start(u32 next, checkpoint *position)
+{
+	stage           = next;
+	strategy        = stages[next];
+	position->stage = next;
+	memset(position->strategy, 0, CHECKPOINT_NAME_SIZE);
+	strncpy(position->strategy, strategy.name, CHECKPOINT_NAME_SIZE - 1);
+	__atomic_store_n(&stats->stage, next, __ATOMIC_RELAXED);
+	if (stage_count > 1) {
+		log_info("worker %u: stage %u, %s", position->worker, next, strategy.name);
 	}
-	free(interesting_dir);
 }
 
-// run an execution and report results
+// create a strategy state for fuzzing a queue entry
+static strategy_state *
+entry_state(u8 *seed, size_t max_size, bool split, u32 worker)
+{
+	strategy_state *state = strategy.create_state(seed, max_size, 0, 0, 0);
+
+	// deterministic strategies split the seed's mutations between workers round robin
+	for (u64 skip = 0; split && skip < worker; skip++) {
+		strategy.update_state(state);
+	}
+	return state;
+}
+
+// save the analysis under a temporary name, it is published once the queues that go with it are
 static void
-run_and_report(u8 *input, size_t size)
+checkpoint_analysis(void)
 {
-	static u8    *results      = NULL;
-	static size_t results_size = 0;
-	char         *reason       = NULL;
-	uint32_t      crc          = crc_buffer(input, size);
+	unlink(CHECKPOINT_ANALYSIS_TMP);
+	if (analysis_lock != NULL) {
+		pthread_mutex_lock(analysis_lock);
+	}
+	analysis.save(CHECKPOINT_ANALYSIS_TMP);
+	if (analysis_lock != NULL) {
+		pthread_mutex_unlock(analysis_lock);
+	}
+}
 
-	// log_debug("input crc: %llx", crc);
-	//  fuzz the binary, getting trace results, trace results size, and exit reason
-	reason = jig.run(input, size, &results, &results_size);
+// write this worker's checkpoint, from a forked copy of the worker so the exec loop only pays for the fork
+static void
+checkpoint_worker(queue *corpus, strategy_state *state, checkpoint *position, u64 request, bool last)
+{
+	position->execs              = stats->execs;
+	position->coverage           = stats->coverage;
+	position->interesting        = stats->interesting;
+	position->crashes            = stats->crashes;
+	position->hangs              = stats->hangs;
+	position->crashes_suppressed = stats->crashes_suppressed;
+	position->hangs_suppressed   = stats->hangs_suppressed;
+	memcpy(position->stage_execs, stats->stage_execs, sizeof(position->stage_execs));
+	memcpy(position->stage_paths, stats->stage_paths, sizeof(position->stage_paths));
+
+	pid_t pid = last ? 0 : fork();
+	if (pid < 0) {
+		log_warn("fork() failed, skipping a checkpoint.");
+		return;
+	}
+	if (pid > 0) {
+		checkpoint_pid = pid;
+		return;
+	}
 
-	// log_debug("results_size = %llu", results_size);
+	char *s_state = state != NULL ? strategy.serialize(state) : NULL;
+	checkpoint_save(position, s_state, corpus);
+	free(s_state);
+	// the peers are read up to where the checkpointed queue has imported them
+	if (syncer != NULL) {
+		sync_save(syncer);
+	}
 
-	// report interesting inputs
-	if (reason != NULL && crc) {
-		// log_debug("reporting interesting.");
-		report_interesting(input, size, reason, results, results_size, crc);
+	// a lone worker publishes the analysis itself, the parent of many workers waits for all of them
+	if (checkpoint_request == NULL) {
+		checkpoint_publish(CHECKPOINT_ANALYSIS_TMP, CHECKPOINT_ANALYSIS);
 	}
+	__atomic_store_n(&stats->checkpoint, request, __ATOMIC_RELEASE);
+	if (!last) {
+		_exit(0);
+	}
+}
 
-	if (results_size > 0 && crc) {
-		// if not interesting, report coverage at least.
-		if (!analysis.add(results, results_size)) {
-			// log_debug("reporting coverage .");
-			report_coverage(input, size, results, results_size, crc);
+// whether this worker owes a checkpoint, and the request it answers
+static bool
+checkpoint_due(u64 *request)
+{
+	if (checkpoint_request != NULL) {
+		*request = __atomic_load_n(checkpoint_request, __ATOMIC_ACQUIRE);
+		return *request != checkpoint_seen;
+	}
+	if (checkpoint_interval_ns == 0 || now_ns() - checkpoint_last_ns < checkpoint_interval_ns) {
+		return false;
+	}
+	*request = checkpoint_seen + 1;
+	return true;
+}
+
+// whether this worker can take the checkpoint it owes now, and the request it answers
+static bool
+checkpoint_ready(u64 *request)
+{
+	if (!checkpoint_due(request)) {
+		return false;
+	}
+
+	// let the previous checkpoint finish writing before starting another
+	if (checkpoint_pid > 0) {
+		if (waitpid(checkpoint_pid, NULL, WNOHANG) == 0) {
+			return false;
 		}
+		checkpoint_pid = 0;
 	}
+	return true;
 }
 
-// fuzz a program.
+// checkpoint this worker for a request checkpoint_ready allowed, at a position just before its next execution
 static void
-fuzz(char *input_file_name, size_t max_size, u8 *seed, u64 iteration_count)
+checkpoint_take(queue *corpus, strategy_state *state, checkpoint *position, u64 request)
 {
-	clock_t         before          = clock();
+	// the analysis already counts every report queued so far as seen, so they have to be in the pack,
+	// or a resume would never find them again. With many workers the parent saved the analysis earlier,
+	// and only publishes it once every worker has flushed and checkpointed.
+	writer_flush(reports);
+	pack_sync(store);
+	if (checkpoint_request == NULL) {
+		checkpoint_analysis();
+	}
+	checkpoint_worker(corpus, state, position, request, false);
+	checkpoint_seen    = request;
+	checkpoint_last_ns = now_ns();
+}
+
+// fuzz a program as one of workers, cycling the strategy over every input in the queue.
+static void
+fuzz(char *input_file_name, size_t max_size, u8 *seed, u64 iteration_count, u64 entry_budget, u32 worker, u32 workers)
+{
+	u8  shared_seed[32] = {0};
+	u8  worker_seed[32] = {0};
+	u32 exec_us         = 0;
+
+	if (seed != NULL) {
+		memcpy(shared_seed, seed, sizeof(shared_seed));
+		memcpy(worker_seed, seed, sizeof(worker_seed));
+	}
+	// random strategies get a different seed per worker, worker 0 keeps the given one
+	for (size_t i = 0; i < sizeof(worker); i++) {
+		worker_seed[i] ^= (u8)(worker >> (8 * i));
+	}
+
 	u8             *mutation_buffer = NULL;
 	u8             *clean_buffer    = calloc(1, max_size + 8);
-	strategy_state *state           = strategy.create_state(seed, max_size, 0, 0, 0);
+	queue          *corpus          = NULL;
+	strategy_state *state           = NULL;
+	char           *resume_state    = NULL;
+	checkpoint      position        = {.worker = worker, .workers = workers};
 	size_t          size            = 0;
 	size_t          clean_size      = 0;
 
 	// get input file
 	load_input_file(input_file_name, &mutation_buffer, &size, max_size);
 
-	// save original input and original input size
-	clean_size = size;
-	memcpy(clean_buffer, mutation_buffer, size);
+	// a jig with a pool runs as many inputs at once as it has targets
+	if (jig.version >= VERSION_FIVE && jig.pool_size != NULL && jig.pool_size() > 1) {
+		pipeline_pool  = true;
+		pipeline_depth = jig.pool_size();
+	}
+	pipeline = calloc(pipeline_depth, sizeof(pipeline_slot));
+	if (pipeline == NULL) {
+		log_fatal("calloc() failed");
+	}
+	for (size_t s = 0; s < pipeline_depth; s++) {
+		pipeline[s].input = calloc(1, max_size + 8);
+	}
 
-	// perform a fuzz run on the original input.
-	run_and_report(mutation_buffer, size);
+	reports            = writer_create(report_backend, &stats->writes, store);
+	if (sync_dir != NULL && worker == 0) {
+		syncer = sync_create(sync_dir, sync_name, store);
+	}
+	stats->start_ns    = now_ns();
+	checkpoint_last_ns = stats->start_ns;
+
+	if (resume) {
+		// pick the queue, the strategy state and the loop back up from the checkpoint
+		if (!checkpoint_load(worker, &position, &resume_state, &corpus)) {
+			log_fatal("There is no checkpoint to resume worker %u from.", worker);
+		}
+		if (position.workers != workers) {
+			log_fatal("The checkpoint was written by %u worker(s), not %u.", position.workers, workers);
+		}
+		if (position.stage >= stage_count || strcmp(position.strategy, stages[position.stage].name) != 0) {
+			log_fatal("The checkpoint was written by %s, which is not stage %u of -O.", position.strategy, position.stage);
+		}
+		stage_start(position.stage, &position);
+		stats->execs              = position.execs;
+		stats->resumed            = position.execs;
+		stats->coverage           = position.coverage;
+		stats->interesting        = position.interesting;
+		stats->crashes            = position.crashes;
+		stats->hangs              = position.hangs;
+		stats->crashes_suppressed = position.crashes_suppressed;
+		stats->hangs_suppressed   = position.hangs_suppressed;
+		memcpy(stats->stage_execs, position.stage_execs, sizeof(stats->stage_execs));
+		memcpy(stats->stage_paths, position.stage_paths, sizeof(stats->stage_paths));
+		log_info("worker %u resuming at iteration %llu with %zu queued", worker, position.iteration, corpus->count);
+	} else {
+		corpus = queue_create();
+		stage_start(0, &position);
+
+		// perform a fuzz run on the original input, which starts the queue.
+		if (worker == 0) {
+			run_and_report(mutation_buffer, size, &exec_us);
+		}
+		queue_add(corpus, mutation_buffer, size, exec_us);
+	}
+	__atomic_store_n(&stats->queued, corpus->count, __ATOMIC_RELAXED);
+
+	// random strategies keep one state across the queue so they never repeat themselves
+	if (!strategy.is_deterministic) {
+		if (resume_state != NULL) {
+			state = strategy.deserialize(resume_state, strlen(resume_state));
+		} else {
+			state = entry_state(worker_seed, max_size, false, worker);
+		}
+	}
 
 	// log_debug("max size: %llu", max_size);
 	// log_debug("iteration_count: %llu", iteration_count);
 	//  commence the fuzzin y'all
-	u64 i = 0;
+	u64    i           = position.iteration;
+	u64    cycle_execs = position.cycle_execs;
+	size_t entry       = position.entry;
+	u64    n           = position.entry_execs;
+
+	while (i < iteration_count) {
+		sync_tick(corpus, max_size);
+		if (entry == corpus->count) {
+			// a deterministic strategy has nothing new to try on an entry it has finished,
+			// and a cycle without a single execution means the strategy is exhausted.
+			// Either way the stage is done, and the next one starts over from the first entry.
+			if (strategy.is_deterministic || cycle_execs == 0) {
+				if (stage + 1 == stage_count) {
+					break;
+				}
+				if (state != NULL) {
+					strategy.free_state(state);
+					state = NULL;
+				}
+				stage_start(stage + 1, &position);
+				if (!strategy.is_deterministic) {
+					state = entry_state(worker_seed, max_size, false, worker);
+				}
+			}
+			entry       = 0;
+			cycle_execs = 0;
+		}
+
+		// only the seed is shared between workers, so only its deterministic mutations are split.
+		bool split  = strategy.is_deterministic && entry == 0;
+		u64  stride = split ? workers : 1;
+		u64  budget = strategy.is_deterministic ? UINT64_MAX : entry_budget;
+		if (strategy.is_deterministic) {
+			if (resume_state != NULL) {
+				state = strategy.deserialize(resume_state, strlen(resume_state));
+			} else {
+				state = entry_state(shared_seed, max_size, split, worker);
+			}
+		}
+		free(resume_state);
+		resume_state = NULL;
+
+		// save the entry's input as the clean input, which every slot starts from
+		clean_size = corpus->entries[entry].size;
+		memcpy(clean_buffer, queue_input(corpus, entry), clean_size);
+		for (size_t s = 0; s < pipeline_depth; s++) {
+			memcpy(pipeline[s].input, clean_buffer, clean_size);
+			pipeline[s].size     = clean_size;
+			pipeline[s].delta.op = DELTA_FULL;
+		}
+		feedback_clean(state, clean_buffer, clean_size);
+
+		bool exhausted = false;
+		for (; n < budget && i < iteration_count; n++, i++) {
+			position.iteration   = i;
+			position.entry       = entry;
+			position.entry_execs = n;
+			position.cycle_execs = cycle_execs;
+			// a checkpoint resumes after every input before this one, so they have to be reported.
+			// The pipeline is only drained once the checkpoint is really taken.
+			u64 request;
+			if (checkpoint_ready(&request)) {
+				pipeline_drain(state, corpus, entry, clean_buffer, clean_size, i);
+				checkpoint_take(corpus, state, &position, request);
+			}
+			__atomic_store_n(&stats->iteration, i, __ATOMIC_RELAXED);
 
-	for (; i < iteration_count; i++) {
+			pipeline_slot *slot  = &pipeline[i % pipeline_depth];
+			pipeline_slot *other = &pipeline[(i + 1) % pipeline_depth];
 
-		// mutate the input with ooze
-		size = strategy.mutate(mutation_buffer, size, state);
-		// log_debug("iteration: %llu, size: %llu.", i, size);
-		//  if the mutating is done
-		if (size == 0) {
+			// mutate the input with ooze, recording how to undo the mutation when the strategy can
+			slot->iteration = state->iteration;
+			if (strategy.version >= VERSION_TWO && strategy.mutate_delta != NULL) {
+				slot->size = strategy.mutate_delta(slot->input, slot->size, state, &slot->delta);
+			} else {
+				slot->size = strategy.mutate(slot->input, slot->size, state);
+			}
+			// log_debug("iteration: %llu, size: %llu.", i, size);
+			//  if the mutating is done
+			if (slot->size == 0) {
+				exhausted = true;
+				break;
+			}
+			// update state, skipping the mutations that belong to other workers.
+			for (u64 step = 0; step < stride; step++) {
+				strategy.update_state(state);
+			}
+			cycle_execs++;
+
+			// the jig runs one input at a time, so the previous input finishes before this one starts,
+			// then it is reported while this one runs. inputs with new coverage join the queue and get fuzzed in turn.
+			// A pool runs this input beside the ones before it, and other is the oldest of them.
+			if (other->running && !pipeline_pool) {
+				pipeline_finish(other);
+			}
+			pipeline_start(slot);
+			if (other->running) {
+				pipeline_finish(other);
+			}
+			if (other->finished) {
+				pipeline_report(other, state, corpus, entry, clean_buffer, clean_size);
+			}
+			// a pool's input may already be done, but waits its turn
+			if (slot->finished && !pipeline_pool) {
+				pipeline_report(slot, state, corpus, entry, clean_buffer, clean_size);
+			}
+		}
+		pipeline_drain(state, corpus, entry, clean_buffer, clean_size, i);
+		// out of iterations partway through the entry, which is where a resume picks up
+		if (!exhausted && n < budget) {
 			break;
 		}
-		// update state.
-		strategy.update_state(state);
+		n = 0;
+		corpus->entries[entry].fuzzed++;
 
-		run_and_report(mutation_buffer, size);
-
-		// reset mutation buffer and size.
-		memcpy(mutation_buffer, clean_buffer, clean_size);
-		size = clean_size;
+		if (strategy.is_deterministic) {
+			strategy.free_state(state);
+			state = NULL;
+		}
+		entry++;
 	}
 
-	// profiling, get run time.
-	clock_t difference = clock() - before;
-	log_debug("%llu runs completed in %d ms", i + 1, (difference * 1000) / CLOCKS_PER_SEC);
+	// profiling, get wall clock run time.
+	__atomic_store_n(&stats->iteration, i, __ATOMIC_RELAXED);
+	__atomic_store_n(&stats->end_ns, now_ns(), __ATOMIC_RELEASE);
+	log_debug("%llu runs completed in %llu ms", stats->execs - stats->resumed, (stats->end_ns - stats->start_ns) / 1000000);
+	log_debug("queue holds %zu entries", corpus->count);
+
+	// finish writing reports before the worker is done
+	writer_destroy(reports);
+	reports = NULL;
+
+	// the last checkpoint lets a finished campaign be continued with a larger iteration count
+	if (checkpoint_interval_ns != 0) {
+		if (checkpoint_pid > 0) {
+			waitpid(checkpoint_pid, NULL, 0);
+			checkpoint_pid = 0;
+		}
+		pack_sync(store);
+		if (checkpoint_request == NULL) {
+			checkpoint_analysis();
+		}
+		position.iteration   = i;
+		position.entry       = entry;
+		position.entry_execs = n;
+		position.cycle_execs = cycle_execs;
+		checkpoint_worker(corpus, state, &position, UINT64_MAX, true);
+	} else if (syncer != NULL) {
+		sync_save(syncer);
+	}
+	if (syncer != NULL) {
+		sync_free(syncer);
+		syncer = NULL;
+	}
 
-	strategy.free_state(state);
+	if (state != NULL) {
+		strategy.free_state(state);
+	}
+	free(resume_state);
+	queue_free(corpus);
 	free(clean_buffer);
 	free(mutation_buffer);
+	for (size_t s = 0; s < pipeline_depth; s++) {
+		free(pipeline[s].input);
+		free(pipeline[s].copy.content);
+	}
+	free(pipeline);
+	pipeline = NULL;
+}
+
+// map zeroed memory that stays shared with forked workers
+static void *
+shared_alloc(size_t size)
+{
+	void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) {
+		log_fatal("mmap() failed");
+	}
+	return mem;
+}
+
+// report executions per second, in aggregate and for each worker
+static void
+report_workers(u32 workers, u64 start_ns, bool per_worker)
+{
+	u64 now     = now_ns();
+	u64 total   = 0;
+	u64 pending = 0;
+	u64 dropped = 0;
+	for (u32 w = 0; w < workers; w++) {
+		pending += __atomic_load_n(&all_stats[w].writes.depth, __ATOMIC_RELAXED);
+		dropped += __atomic_load_n(&all_stats[w].writes.dropped, __ATOMIC_RELAXED);
+		u64 execs    = __atomic_load_n(&all_stats[w].execs, __ATOMIC_RELAXED) - all_stats[w].resumed;
+		u64 begin_ns = __atomic_load_n(&all_stats[w].start_ns, __ATOMIC_RELAXED);
+		u64 end_ns   = __atomic_load_n(&all_stats[w].end_ns, __ATOMIC_ACQUIRE);
+		total += execs;
+		if (per_worker && begin_ns) {
+			u64 elapsed = (end_ns ? end_ns : now) - begin_ns;
+			log_info("worker %u: %llu execs, %.1f execs/sec, %llu coverage, %llu interesting, %llu queued",
+			         w, execs, elapsed ? (double)execs * 1e9 / (double)elapsed : 0.0,
+			         all_stats[w].coverage, all_stats[w].interesting, all_stats[w].queued);
+			log_info("worker %u: %llu unique crashes, %llu duplicate crashes, %llu unique hangs, %llu duplicate hangs, %llu calibrated",
+			         w, all_stats[w].crashes, all_stats[w].crashes_suppressed, all_stats[w].hangs, all_stats[w].hangs_suppressed,
+			         all_stats[w].calibrated);
+			log_info("worker %u: %llu reports written, %llu already in the pack, %llu pending, %llu dropped, %llu waited on a full queue",
+			         w, all_stats[w].writes.written, all_stats[w].writes.duplicate, all_stats[w].writes.depth,
+			         all_stats[w].writes.dropped, all_stats[w].writes.backpressure);
+			for (u32 s = 0; s < stage_count && stage_count > 1; s++) {
+				u64 stage_execs = all_stats[w].stage_execs[s];
+				log_info("worker %u: stage %u, %s: %llu execs, %llu new paths, %.6f paths/exec",
+				         w, s, stage_names[s], stage_execs, all_stats[w].stage_paths[s],
+				         stage_execs ? (double)all_stats[w].stage_paths[s] / (double)stage_execs : 0.0);
+			}
+		}
+	}
+	u64 elapsed = now - start_ns;
+	log_info("%u worker(s): %llu execs, %.1f execs/sec, %llu reports pending, %llu dropped",
+	         workers, total, elapsed ? (double)total * 1e9 / (double)elapsed : 0.0, pending, dropped);
+}
+
+// check whether every worker has written its checkpoint for a request
+static bool
+checkpoints_written(u32 workers, u64 request)
+{
+	for (u32 w = 0; w < workers; w++) {
+		if (__atomic_load_n(&all_stats[w].checkpoint, __ATOMIC_ACQUIRE) < request) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// shrink an input with the jig and write it to a file
+static void
+minimize_input(char *jig_library_name, char *input_file_name, char *output_file_name, size_t max_size, u64 exec_limit)
+{
+	u8    *input = NULL;
+	size_t size  = 0;
+	load_input_file(input_file_name, &input, &size, max_size);
+	if (initialize_jig(jig_library_name)) {
+		log_fatal("jig failed to initialize");
+	}
+
+	tmin_stats result;
+	size_t     original = size;
+
+	size = tmin_minimize(&jig, input, size, exec_limit, &result);
+	jig.destroy();
+
+	int fd = open(output_file_name, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+	if (fd < 0) {
+		log_fatal("Can't open %s.", output_file_name);
+	}
+	if (write(fd, input, size) != (ssize_t)size) {
+		log_fatal("Can't write %s.", output_file_name);
+	}
+	close(fd);
+	free(input);
+
+	log_info("tmin: %zu bytes to %zu (%u deleted, %u normalized) in %u passes, %llu execs, %.2f seconds, %.1f execs/sec",
+	         original, size, result.removed, result.replaced, result.passes, result.execs, (double)result.elapsed / 1e9,
+	         result.elapsed ? (double)result.execs * 1e9 / (double)result.elapsed : 0.0);
+}
+
+// replay a directory of inputs on workers and copy the fewest that keep its coverage to another
+static void
+minimize_corpus(char *jig_library_name, char *input_dir, char *output_dir, u32 workers)
+{
+	u64          start  = now_ns();
+	cmin_corpus *corpus = cmin_scan(input_dir);
+	log_info("cmin: replaying %zu inputs from %s on %u worker(s)", corpus->count, input_dir, workers);
+
+	// the tables are sized from the jig's results, so one input is run before the workers fork
+	if (initialize_jig(jig_library_name)) {
+		log_fatal("jig failed to initialize");
+	}
+	size_t tuples = CMIN_TUPLES(cmin_results_size(&jig, corpus));
+	jig.destroy();
+
+	cmin_best  *tables    = shared_alloc(sizeof(cmin_best) * tuples * workers);
+	cmin_stats *cmin_runs = shared_alloc(sizeof(cmin_stats) * workers);
+	pid_t      *pids      = calloc(workers, sizeof(pid_t));
+	fflush(NULL);
+	for (u32 w = 0; w < workers; w++) {
+		pid_t pid = fork();
+		pids[w]   = pid;
+		if (pid < 0) {
+			log_fatal("fork() failed");
+		}
+		if (pid == 0) {
+			char instance[16];
+			snprintf(instance, sizeof(instance), "%u", w);
+			setenv("JIG_INSTANCE", instance, 1);
+			if (initialize_jig(jig_library_name)) {
+				log_fatal("jig failed to initialize");
+			}
+			cmin_replay(&jig, corpus, w, workers, &tables[tuples * w], tuples, &cmin_runs[w]);
+			jig.destroy();
+			fflush(NULL);
+			_exit(0);
+		}
+	}
+	// the jig's forkserver is a child too, so only the workers are waited on
+	for (u32 w = 0; w < workers; w++) {
+		int status;
+		if (waitpid(pids[w], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			log_fatal("cmin worker %u exited abnormally.", w);
+		}
+	}
+	free(pids);
+
+	u64 replayed = 0;
+	u64 skipped  = 0;
+	u64 exec_ns  = 0;
+	for (u32 w = 0; w < workers; w++) {
+		if (w > 0) {
+			cmin_merge(tables, &tables[tuples * w], tuples);
+		}
+		replayed += cmin_runs[w].replayed;
+		skipped += cmin_runs[w].skipped;
+		exec_ns += cmin_runs[w].exec_ns;
+	}
+	size_t covered = 0;
+	for (size_t t = 0; t < tuples; t++) {
+		covered += tables[t].score != 0;
+	}
+
+	struct stat st;
+	if (stat(output_dir, &st) != 0 && mkdir(output_dir, 0777) != 0) {
+		log_fatal("Can't create %s.", output_dir);
+	}
+	if (initialize_jig(jig_library_name)) {
+		log_fatal("jig failed to initialize");
+	}
+	size_t selected = cmin_select(&jig, corpus, tables, tuples, output_dir);
+	jig.destroy();
+
+	u64 elapsed = now_ns() - start;
+	log_info("cmin: kept %zu of %zu inputs covering %zu tuples, %llu crashed, hung or could not be read",
+	         selected, corpus->count, covered, skipped);
+	log_info("cmin: %llu replays in %.2f seconds, %.1f replays/sec, %.2f seconds in the target",
+	         replayed, (double)elapsed / 1e9, elapsed ? (double)replayed * 1e9 / (double)elapsed : 0.0, (double)exec_ns / 1e9);
+
+	munmap(cmin_runs, sizeof(cmin_stats) * workers);
+	munmap(tables, sizeof(cmin_best) * tuples * workers);
+	cmin_free(corpus);
+}
+
+// fork workers that each run their own jig against the shared analysis, and wait for them to finish
+static void
+run_workers(char *jig_library_name, char *input_file_name, size_t max_size, u8 *seed, u64 iteration_count, u64 entry_budget, u32 workers)
+{
+	all_stats          = shared_alloc(sizeof(worker_stats) * workers);
+	analysis_lock      = shared_alloc(sizeof(pthread_mutex_t));
+	checkpoint_request = shared_alloc(sizeof(u64));
+
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	pthread_mutex_init(analysis_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	// targets get a core of their own only when every worker can have one
+	bool pair = bind_cores && affinity_free_cores() >= 2 * workers;
+
+	u64 start_ns = now_ns();
+	fflush(NULL);
+	for (u32 w = 0; w < workers; w++) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			log_fatal("fork() failed");
+		}
+		if (pid == 0) {
+			// the jig keys its fuzzfile off of the instance
+			char instance[16];
+			snprintf(instance, sizeof(instance), "%u", w);
+			setenv("JIG_INSTANCE", instance, 1);
+
+			stats = &all_stats[w];
+			start_jig(jig_library_name, pair, w);
+			fuzz(input_file_name, max_size, seed, iteration_count, entry_budget, w, workers);
+			jig.destroy();
+			fflush(NULL);
+			_exit(0);
+		}
+	}
+
+	fuzzer_stats_start(all_stats, workers, stage_names, stage_count, analysis.version >= VERSION_TWO ? analysis.density : NULL,
+	                   analysis.version >= VERSION_FOUR ? analysis.stability : NULL);
+
+	u64                   last_report     = start_ns;
+	u64                   last_checkpoint = start_ns;
+	bool                  publishing      = false;
+	u32                   running         = workers;
+	const struct timespec nap             = {0, 100000000};
+	while (running) {
+		// the analysis is saved before the workers checkpoint their queues and published after,
+		// so a checkpoint never holds coverage that none of its queues hold.
+		if (publishing && checkpoints_written(workers, *checkpoint_request)) {
+			checkpoint_publish(CHECKPOINT_ANALYSIS_TMP, CHECKPOINT_ANALYSIS);
+			publishing = false;
+		}
+		if (checkpoint_interval_ns != 0 && !publishing && now_ns() - last_checkpoint >= checkpoint_interval_ns) {
+			checkpoint_analysis();
+			__atomic_store_n(checkpoint_request, *checkpoint_request + 1, __ATOMIC_RELEASE);
+			publishing      = true;
+			last_checkpoint = now_ns();
+		}
+
+		int   status;
+		pid_t pid = waitpid(-1, &status, WNOHANG);
+		if (pid < 0) {
+			break;
+		}
+		if (pid > 0) {
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				log_warn("worker %d exited abnormally.", pid);
+			}
+			running--;
+			continue;
+		}
+		nanosleep(&nap, NULL);
+		if (now_ns() - last_report >= REPORT_INTERVAL_NS) {
+			report_workers(workers, start_ns, false);
+			last_report = now_ns();
+		}
+	}
+	fuzzer_stats_stop();
+	report_workers(workers, start_ns, true);
+
+	// every worker has written its last checkpoint, so the analysis can go with them
+	if (checkpoint_interval_ns != 0) {
+		checkpoint_analysis();
+		checkpoint_publish(CHECKPOINT_ANALYSIS_TMP, CHECKPOINT_ANALYSIS);
+	}
+	munmap(checkpoint_request, sizeof(u64));
+	checkpoint_request = NULL;
+
+	pthread_mutex_destroy(analysis_lock);
+	munmap(analysis_lock, sizeof(pthread_mutex_t));
+	analysis_lock = NULL;
 }
 
 int
@@ -408,8 +1386,20 @@ main(int argc, char *argv[])
 	u64    iteration_count       = 0;
 	size_t max_input_size        = 0;
 	u8    *ooze_seed             = NULL;
+	u32    workers               = 1;
+	u64    entry_budget          = DEFAULT_ENTRY_BUDGET;
+	u64    checkpoint_interval   = DEFAULT_CHECKPOINT_INTERVAL;
+	char  *tmin_file_name        = NULL;
+	char  *cmin_dir_name         = NULL;
+
+	static struct option long_options[] = {
+	    {"resume", no_argument, NULL, 'r'},
+	    {"tmin", required_argument, NULL, OPT_TMIN},
+	    {"cmin", required_argument, NULL, OPT_CMIN},
+	    {NULL, 0, NULL, 0},
+	};
 	init_logging();
-	while ((opt = getopt(argc, argv, "S:O:i:n:s:C:c:x:J:")) != -1) {
+	while ((opt = getopt_long(argc, argv, "S:O:i:n:s:C:c:x:J:j:e:w:k:K:b:y:Y:r", long_options, NULL)) != -1) {
 		switch (opt) {
 		case 'S':
 			if (optarg == NULL) {
@@ -435,6 +1425,18 @@ main(int argc, char *argv[])
 			}
 			input_file_name = strdup(optarg);
 			break;
+		case 'y':
+			if (optarg == NULL) {
+				usage(argv[0]);
+			}
+			sync_dir = strdup(optarg);
+			break;
+		case 'Y':
+			if (optarg == NULL) {
+				usage(argv[0]);
+			}
+			sync_name = strdup(optarg);
+			break;
 		case 'n':
 			if (optarg == NULL) {
 				usage(argv[0]);
@@ -472,18 +1474,130 @@ main(int argc, char *argv[])
 			}
 			analysis_save_file = strdup(optarg);
 			break;
+		case 'j':
+			if (optarg == NULL) {
+				usage(argv[0]);
+			}
+			workers = (u32)strtoul(optarg, NULL, 10);
+			break;
+		case 'e':
+			if (optarg == NULL) {
+				usage(argv[0]);
+			}
+			entry_budget = strtoull(optarg, NULL, 10);
+			break;
+		case 'k':
+			if (optarg == NULL) {
+				usage(argv[0]);
+			}
+			checkpoint_interval = strtoull(optarg, NULL, 10);
+			break;
+		case 'K':
+			if (optarg == NULL) {
+				usage(argv[0]);
+			}
+			calibration_runs = strtoull(optarg, NULL, 10);
+			break;
+		case 'r':
+			resume = true;
+			break;
+		case OPT_TMIN:
+			if (optarg == NULL) {
+				usage(argv[0]);
+			}
+			tmin_file_name = strdup(optarg);
+			break;
+		case OPT_CMIN:
+			if (optarg == NULL) {
+				usage(argv[0]);
+			}
+			cmin_dir_name = strdup(optarg);
+			break;
+		case 'b':
+			if (optarg == NULL) {
+				usage(argv[0]);
+			} else if (strcmp("auto", optarg) == 0) {
+				bind_cores = true;
+			} else if (strcmp("off", optarg) == 0) {
+				bind_cores = false;
+			} else {
+				usage(argv[0]);
+			}
+			break;
+		case 'w':
+			if (optarg == NULL) {
+				usage(argv[0]);
+			} else if (strcmp("io_uring", optarg) == 0) {
+				report_backend = WRITER_IO_URING;
+			} else if (strcmp("threads", optarg) == 0) {
+				report_backend = WRITER_THREADS;
+			} else {
+				usage(argv[0]);
+			}
+			break;
 		}
 	}
+	// the jig only offers the target an input channel that holds the largest input
+	if (max_input_size != 0) {
+		char max_input[32];
+		snprintf(max_input, sizeof(max_input), "%zu", max_input_size);
+		setenv("JIG_MAX_INPUT", max_input, 1);
+	}
+
+	// minimizing only needs a jig to run the inputs
+	if (tmin_file_name != NULL || cmin_dir_name != NULL) {
+		if (jig_library_name == NULL || input_file_name == NULL || workers == 0 ||
+		    (tmin_file_name != NULL && (cmin_dir_name != NULL || max_input_size == 0))) {
+			usage(argv[0]);
+		}
+		if (tmin_file_name != NULL) {
+			minimize_input(jig_library_name, input_file_name, tmin_file_name, max_input_size, iteration_count);
+		} else {
+			minimize_corpus(jig_library_name, input_file_name, cmin_dir_name, workers);
+		}
+		free(tmin_file_name);
+		free(cmin_dir_name);
+		free(input_file_name);
+		free(jig_library_name);
+		free(ooze_library_name);
+		free(analysis_library_name);
+		free(analysis_load_file);
+		free(analysis_save_file);
+		free(ooze_seed);
+#ifndef GTFO_STATIC
+		dlclose(jig_lib);
+#endif
+		return 0;
+	}
+
 	// Check the arguments
 	if (analysis_library_name == NULL ||
 	    ooze_library_name == NULL ||
 	    jig_library_name == NULL ||
 	    input_file_name == NULL ||
 	    iteration_count == 0 ||
-	    max_input_size == 0) {
+	    max_input_size == 0 ||
+	    workers == 0 ||
+	    entry_budget == 0 ||
+	    (sync_dir == NULL) != (sync_name == NULL)) {
 
 		usage(argv[0]);
 	}
+	if (sync_name != NULL && !sync_name_valid(sync_name)) {
+		log_fatal("The instance name can't be empty, start with '.' or contain '/'.");
+	}
+
+	checkpoint_interval_ns = checkpoint_interval * 1000000000ULL;
+
+	struct stat st;
+	if (resume) {
+		// the checkpointed analysis replaces any analysis load file
+		if (stat(CHECKPOINT_ANALYSIS, &st) != 0) {
+			log_fatal("There is no checkpoint to resume from in " CHECKPOINT_DIR);
+		}
+		free(analysis_load_file);
+		analysis_load_file = strdup(CHECKPOINT_ANALYSIS);
+	}
 
 	if (initialize_analysis(analysis_library_name, analysis_load_file)) {
 		log_fatal("analysis failed to initialize");
@@ -493,20 +1607,42 @@ main(int argc, char *argv[])
 		log_fatal("ooze failed to initialize");
 	}
 
-	if (initialize_jig(jig_library_name)) {
-		log_fatal("jig failed to initialize");
+	// opened before any worker forks, so every worker appends to the same pack.
+	// Instances that sync keep their pack where the other instances can read it.
+	char pack_dir[SYNC_FILE_SIZE] = PACK_DIR;
+	if (sync_dir != NULL) {
+		sync_pack_dir(sync_dir, sync_name, pack_dir, sizeof(pack_dir));
 	}
-
-	struct stat st;
-	if (stat(INTERESTING_DIR, &st) != 0) {
-		mkdir(INTERESTING_DIR, 0777);
+	store = pack_open(pack_dir, true);
+
+	// effector maps are named by their input alone, so they are kept with the pack, and a new
+	// campaign doesn't combine its maps with the ones an earlier campaign wrote for another target
+	if (getenv("EFFECTOR_DIR") == NULL) {
+		char effector_dir[SYNC_FILE_SIZE + sizeof(EFFECTOR_SUBDIR) + 1];
+		snprintf(effector_dir, sizeof(effector_dir), "%s/" EFFECTOR_SUBDIR, pack_dir);
+		if (!resume) {
+			remove_tree(effector_dir);
+		}
+		setenv("EFFECTOR_DIR", effector_dir, 1);
 	}
 
-	if (stat(COVERAGE_DIR, &st) != 0) {
-		mkdir(COVERAGE_DIR, 0777);
+	if (checkpoint_interval_ns != 0 && stat(CHECKPOINT_DIR, &st) != 0) {
+		mkdir(CHECKPOINT_DIR, 0777);
 	}
 
-	fuzz(input_file_name, max_input_size, ooze_seed, iteration_count);
+	if (workers > 1) {
+		run_workers(jig_library_name, input_file_name, max_input_size, ooze_seed, iteration_count, entry_budget, workers);
+	} else {
+		start_jig(jig_library_name, bind_cores && affinity_free_cores() >= 2, 0);
+		all_stats = calloc(1, sizeof(worker_stats));
+		stats     = all_stats;
+		fuzzer_stats_start(all_stats, 1, stage_names, stage_count, analysis.version >= VERSION_TWO ? analysis.density : NULL,
+		                   analysis.version >= VERSION_FOUR ? analysis.stability : NULL);
+		fuzz(input_file_name, max_input_size, ooze_seed, iteration_count, entry_budget, 0, 1);
+		fuzzer_stats_stop();
+		report_workers(1, all_stats->start_ns, true);
+		jig.destroy();
+	}
 
 	if (analysis_save_file) {
 		analysis.save(analysis_save_file);
@@ -519,10 +1655,23 @@ main(int argc, char *argv[])
 	free(jig_library_name);
 	free(ooze_library_name);
 	free(analysis_library_name);
-	jig.destroy();
 	analysis.destroy();
+	pack_close(store);
+	free(sync_dir);
+	free(sync_name);
 
-	dlclose(strategy_lib);
-	dlclose(jig_lib);
+	if (workers > 1) {
+		munmap(all_stats, sizeof(worker_stats) * workers);
+	} else {
+		free(all_stats);
+#ifndef GTFO_STATIC
+		dlclose(jig_lib);
+#endif
+	}
+#ifndef GTFO_STATIC
+	for (u32 s = 0; s < stage_count; s++) {
+		dlclose(strategy_libs[s]);
+	}
 	dlclose(analysis_lib);
+#endif
 }
@@ -0,0 +1,169 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/logger.h"
+#include "fuzzer_stats.h"
+#include "mutate.h"
+#include "pack.h"
+#include "tmin.h"
+
+// what the original input did, which every change has to keep doing
+typedef struct tmin_target {
+	jig_api  *jig;
+	char     *reason;     // NULL unless the input crashed or hung
+	pack_hash results;    // hash of the results of an input that ran cleanly
+	u64       exec_limit; // 0 for no limit
+	u8       *candidate;  // scratch copy of the input that changes are tried on
+} tmin_target;
+
+static size_t
+next_power_of_two(size_t value)
+{
+	size_t power = 1;
+	while (power < value) {
+		power <<= 1;
+	}
+	return power;
+}
+
+// true if the jig can run the input again without going over the limit
+static bool
+tmin_budget(tmin_target *target, tmin_stats *stats)
+{
+	return target->exec_limit == 0 || stats->execs < target->exec_limit;
+}
+
+// run an input, returning true if it behaves like the original
+static bool
+tmin_same(tmin_target *target, u8 *input, size_t size, tmin_stats *stats)
+{
+	u8    *results      = NULL;
+	size_t results_size = 0;
+	char  *reason       = target->jig->run(input, size, &results, &results_size);
+	stats->execs++;
+
+	if (target->reason != NULL) {
+		return reason != NULL && strcmp(reason, target->reason) == 0;
+	}
+	if (reason != NULL) {
+		return false;
+	}
+	pack_hash hash = pack_hash_buffer(PACK_RESULTS, results, results_size);
+	return hash.lo == target->results.lo && hash.hi == target->results.hi;
+}
+
+// replace whole blocks with TMIN_NORMAL_CHAR, returning the number of bytes replaced
+static u32
+tmin_normalize_blocks(tmin_target *target, u8 *input, size_t size, size_t block, tmin_stats *stats)
+{
+	u8 *normal = malloc(block);
+	if (normal == NULL) {
+		log_fatal("malloc() failed");
+	}
+	memset(normal, TMIN_NORMAL_CHAR, block);
+
+	u32 replaced = 0;
+	for (size_t pos = 0; pos < size && tmin_budget(target, stats); pos += block) {
+		size_t n = MIN(block, size - pos);
+		if (memcmp(input + pos, normal, n) == 0) {
+			continue;
+		}
+		memcpy(target->candidate, input, size);
+		n_byte_replace(target->candidate, size, pos, normal, n);
+		if (tmin_same(target, target->candidate, size, stats)) {
+			for (size_t i = 0; i < n; i++) {
+				replaced += input[pos + i] != TMIN_NORMAL_CHAR;
+			}
+			memcpy(input, target->candidate, size);
+		}
+	}
+	free(normal);
+	return replaced;
+}
+
+// delete blocks, halving the block size down to a byte, returning the new size
+static size_t
+tmin_delete_blocks(tmin_target *target, u8 *input, size_t size, tmin_stats *stats)
+{
+	for (size_t block = next_power_of_two(size / TMIN_DEL_STEPS); block > 0 && size > 1; block /= 2) {
+		// a deleted block's bytes move into its place, so the same position is tried again
+		size_t pos = 0;
+		while (pos < size && size > 1 && tmin_budget(target, stats)) {
+			size_t n = MIN(block, size - pos);
+			if (n == size) {
+				break;
+			}
+			memcpy(target->candidate, input, size);
+			n_byte_delete(target->candidate, size, pos, n);
+			if (tmin_same(target, target->candidate, size - n, stats)) {
+				size -= n;
+				stats->removed += (u32)n;
+				memcpy(input, target->candidate, size);
+			} else {
+				pos += block;
+			}
+		}
+	}
+	return size;
+}
+
+// shrink an input in place, returning its new size
+size_t
+tmin_minimize(jig_api *jig, u8 *input, size_t size, u64 exec_limit, tmin_stats *stats)
+{
+	memset(stats, 0, sizeof(tmin_stats));
+	u64 start = now_ns();
+
+	tmin_target target = {jig, NULL, {0, 0}, exec_limit, malloc(size ? size : 1)};
+	if (target.candidate == NULL) {
+		log_fatal("malloc() failed");
+	}
+
+	// the original run decides what the minimized input has to keep doing
+	u8    *results      = NULL;
+	size_t results_size = 0;
+	char  *reason       = jig->run(input, size, &results, &results_size);
+	stats->execs++;
+	if (reason != NULL) {
+		target.reason = strdup(reason);
+		log_info("tmin: the input produces '%s', keeping that", reason);
+	} else {
+		target.results = pack_hash_buffer(PACK_RESULTS, results, results_size);
+		log_info("tmin: the input runs cleanly, keeping its %zu byte trace", results_size);
+	}
+
+	bool changed = size > 0;
+	while (changed && tmin_budget(&target, stats)) {
+		size_t before   = size;
+		u32    replaced = stats->replaced;
+		stats->passes++;
+
+		stats->replaced += tmin_normalize_blocks(&target, input, size, next_power_of_two(size / TMIN_SET_STEPS), stats);
+		size = tmin_delete_blocks(&target, input, size, stats);
+		stats->replaced += tmin_normalize_blocks(&target, input, size, 1, stats);
+
+		changed = size != before || stats->replaced != replaced;
+		log_info("tmin: pass %u left %zu bytes after %llu execs", stats->passes, size, stats->execs);
+	}
+	if (!tmin_budget(&target, stats)) {
+		log_warn("tmin: stopped at the execution limit of %llu", exec_limit);
+	}
+
+	stats->elapsed = now_ns() - start;
+	free(target.reason);
+	free(target.candidate);
+	return size;
+}
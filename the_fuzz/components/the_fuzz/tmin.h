@@ -0,0 +1,43 @@
+#ifndef TMIN_H
+#define TMIN_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include "common/types.h"
+#include "jig.h"
+
+/*
+    tmin shrinks one input the way afl-tmin does. It normalizes blocks to '0', deletes
+    blocks whose size is halved from a sixteenth of the input down to one byte, then
+    normalizes single bytes, and repeats the passes until none of them changes the input.
+    A change is kept only when the jig reports the same results, or, for an input that
+    crashed or hung, the same reason.
+*/
+
+#define TMIN_SET_STEPS 128  // blocks normalized in the first pass
+#define TMIN_DEL_STEPS 16   // blocks deleted in the first deletion pass
+#define TMIN_NORMAL_CHAR '0'
+
+typedef struct tmin_stats {
+	u64 execs;    // executions the minimization used
+	u64 elapsed;  // nanoseconds the minimization took
+	u32 passes;   // passes over the input
+	u32 removed;  // bytes deleted
+	u32 replaced; // bytes normalized
+} tmin_stats;
+
+size_t tmin_minimize(jig_api *jig, u8 *input, size_t size, u64 exec_limit, tmin_stats *stats);
+
+#endif
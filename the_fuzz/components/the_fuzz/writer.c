@@ -0,0 +1,486 @@
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "writer.h"
+
+#define WRITER_QUEUE_DEPTH 256  // reports the queue holds, must be a power of two
+#define WRITER_THREADS 2         // threads in the fallback pool
+#define WRITER_BACKOFF_NS 50000  // how long a full queue makes an interesting report sleep
+#define URING_RECORDS 32         // reports in flight on the io_uring at once
+#define URING_ENTRIES 64         // submission queue entries, enough for every report in flight
+#define URING_PACK_FILE 0        // the pack's index in the io_uring's registered files
+
+// a report waiting to be written, its input and results are stored right after it
+typedef struct write_record {
+	u8    *input;
+	size_t size;
+	u8    *results;
+	size_t results_size;
+	bool   interesting;
+	char   reason[PACK_REASON_SIZE];
+
+	pack_staged staged; // the records the report adds to the pack, filled in by the writer thread
+} write_record;
+
+// a cell of the bounded queue, see Vyukov's bounded MPMC queue
+typedef struct write_cell {
+	u64           sequence;
+	write_record *record;
+} write_cell;
+
+// the parts of an io_uring the writer uses, mapped from the kernel
+typedef struct uring {
+	int                  fd;
+	u8                  *rings;
+	size_t               rings_size;
+	struct io_uring_sqe *sqes;
+	size_t               sqes_size;
+	u32                 *sq_tail;
+	u32                 *sq_mask;
+	u32                 *sq_array;
+	u32                 *cq_head;
+	u32                 *cq_tail;
+	u32                 *cq_mask;
+	struct io_uring_cqe *cqes;
+	u32                  tail;      // local submission tail, published on enter
+	u32                  to_submit; // entries queued since the last enter
+} uring;
+
+struct writer {
+	writer_backend backend;
+	writer_stats  *stats;
+	pack          *store;
+	write_cell     cells[WRITER_QUEUE_DEPTH];
+	u64            enqueue_pos;
+	u64            dequeue_pos;
+	sem_t          ready; // one count per queued report, and one per thread when stopping
+	pthread_t      threads[WRITER_THREADS];
+	u32            thread_count;
+
+	// io_uring backend
+	uring ring;
+	u32   in_flight_count;
+};
+
+// add a report to the queue, returning false if it is full
+static bool
+pending_push(writer *w, write_record *record)
+{
+	u64         pos = __atomic_load_n(&w->enqueue_pos, __ATOMIC_RELAXED);
+	write_cell *cell;
+	for (;;) {
+		cell          = &w->cells[pos & (WRITER_QUEUE_DEPTH - 1)];
+		u64 sequence  = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+		s64 available = (s64)sequence - (s64)pos;
+		if (available == 0) {
+			if (__atomic_compare_exchange_n(&w->enqueue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (available < 0) {
+			return false;
+		} else {
+			pos = __atomic_load_n(&w->enqueue_pos, __ATOMIC_RELAXED);
+		}
+	}
+	cell->record = record;
+	__atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+// take a report from the queue, returning NULL if it is empty
+static write_record *
+pending_pop(writer *w)
+{
+	u64         pos = __atomic_load_n(&w->dequeue_pos, __ATOMIC_RELAXED);
+	write_cell *cell;
+	for (;;) {
+		cell          = &w->cells[pos & (WRITER_QUEUE_DEPTH - 1)];
+		u64 sequence  = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+		s64 available = (s64)sequence - (s64)(pos + 1);
+		if (available == 0) {
+			if (__atomic_compare_exchange_n(&w->dequeue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (available < 0) {
+			return NULL;
+		} else {
+			pos = __atomic_load_n(&w->dequeue_pos, __ATOMIC_RELAXED);
+		}
+	}
+	write_record *record = cell->record;
+	__atomic_store_n(&cell->sequence, pos + WRITER_QUEUE_DEPTH, __ATOMIC_RELEASE);
+	return record;
+}
+
+// wait for a report, or for the writer to stop
+static void
+wait_ready(writer *w)
+{
+	while (sem_wait(&w->ready) != 0) {
+		if (errno != EINTR) {
+			log_fatal("sem_wait() failed");
+		}
+	}
+}
+
+// copy a report so the exec loop can reuse its buffers
+static write_record *
+record_create(u8 *input, size_t size, u8 *results, size_t results_size)
+{
+	write_record *record = malloc(sizeof(write_record) + size + results_size);
+	if (record == NULL) {
+		log_fatal("malloc() failed");
+	}
+	record->input        = (u8 *)(record + 1);
+	record->size         = size;
+	record->results      = record->input + size;
+	record->results_size = results_size;
+	record->interesting  = false;
+	record->reason[0]    = '\0';
+	memcpy(record->input, input, size);
+	memcpy(record->results, results, results_size);
+	return record;
+}
+
+static void
+record_done(writer *w, write_record *record)
+{
+	free(record);
+	__atomic_fetch_add(&w->stats->written, 1, __ATOMIC_RELAXED);
+	// released after the report is published, for writer_flush
+	__atomic_fetch_sub(&w->stats->depth, 1, __ATOMIC_RELEASE);
+}
+
+// stage a report's new records in the pack, finishing the report now if the pack already has it
+static bool
+record_stage(writer *w, write_record *record)
+{
+	if (pack_stage_report(w->store, &record->staged, record->input, record->size, record->results, record->results_size, record->interesting ? record->reason : NULL)) {
+		return true;
+	}
+	__atomic_fetch_add(&w->stats->duplicate, 1, __ATOMIC_RELAXED);
+	record_done(w, record);
+	return false;
+}
+
+// a thread of the fallback pool, writing reports until the writer stops
+static void *
+pool_thread(void *arg)
+{
+	writer *w = arg;
+	for (;;) {
+		wait_ready(w);
+		write_record *record = pending_pop(w);
+		if (record == NULL) {
+			break;
+		}
+		if (record_stage(w, record)) {
+			pack_write(w->store, &record->staged);
+			pack_publish(w->store, &record->staged);
+			record_done(w, record);
+		}
+	}
+	return NULL;
+}
+
+static void
+uring_free(uring *ring)
+{
+	if (ring->sqes != NULL) {
+		munmap(ring->sqes, ring->sqes_size);
+	}
+	if (ring->rings != NULL) {
+		munmap(ring->rings, ring->rings_size);
+	}
+	close(ring->fd);
+	memset(ring, 0, sizeof(uring));
+}
+
+// set up an io_uring with the pack as a registered file, returning false if the kernel won't allow it
+static bool
+uring_setup(uring *ring, int pack_fd)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	memset(ring, 0, sizeof(uring));
+
+	ring->fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+	if (ring->fd < 0) {
+		return false;
+	}
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+		uring_free(ring);
+		return false;
+	}
+
+	size_t sq_size   = params.sq_off.array + params.sq_entries * sizeof(u32);
+	size_t cq_size   = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->rings_size = MAX(sq_size, cq_size);
+	ring->rings      = mmap(NULL, ring->rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->rings == MAP_FAILED) {
+		ring->rings = NULL;
+		uring_free(ring);
+		return false;
+	}
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes      = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		uring_free(ring);
+		return false;
+	}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+	ring->sq_tail  = (u32 *)(ring->rings + params.sq_off.tail);
+	ring->sq_mask  = (u32 *)(ring->rings + params.sq_off.ring_mask);
+	ring->sq_array = (u32 *)(ring->rings + params.sq_off.array);
+	ring->cq_head  = (u32 *)(ring->rings + params.cq_off.head);
+	ring->cq_tail  = (u32 *)(ring->rings + params.cq_off.tail);
+	ring->cq_mask  = (u32 *)(ring->rings + params.cq_off.ring_mask);
+	ring->cqes     = (struct io_uring_cqe *)(ring->rings + params.cq_off.cqes);
+#pragma clang diagnostic pop
+	ring->tail = *ring->sq_tail;
+
+	// every write goes to the pack, so it is registered once instead of looked up per write
+	if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES, &pack_fd, 1) < 0) {
+		uring_free(ring);
+		return false;
+	}
+	return true;
+}
+
+// get a cleared submission queue entry, published on the next enter
+static struct io_uring_sqe *
+uring_sqe(uring *ring, write_record *record)
+{
+	u32                  index = ring->tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe   = &ring->sqes[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->user_data        = (u64)(uintptr_t)record;
+	ring->sq_array[index] = index;
+	ring->tail++;
+	ring->to_submit++;
+	return sqe;
+}
+
+// submit queued entries and wait for min_complete completions
+static void
+uring_enter(uring *ring, u32 min_complete)
+{
+	__atomic_store_n(ring->sq_tail, ring->tail, __ATOMIC_RELEASE);
+	u32 flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+	for (;;) {
+		long submitted = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, min_complete, flags, NULL, 0);
+		if (submitted >= 0) {
+			ring->to_submit -= (u32)submitted;
+			return;
+		}
+		if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			log_fatal("io_uring_enter() failed");
+		}
+	}
+}
+
+// queue the write of a report's new records to the pack
+static void
+uring_prepare(writer *w, write_record *record)
+{
+	if (!record_stage(w, record)) {
+		return;
+	}
+	w->in_flight_count++;
+
+	struct io_uring_sqe *sqe = uring_sqe(&w->ring, record);
+	sqe->opcode              = IORING_OP_WRITE;
+	sqe->fd                  = URING_PACK_FILE;
+	sqe->flags               = IOSQE_FIXED_FILE;
+	sqe->addr                = (u64)(uintptr_t)record->staged.buffer;
+	sqe->len                 = (u32)record->staged.size;
+	sqe->off                 = record->staged.offset;
+}
+
+// handle every completion the kernel has posted
+static void
+uring_reap(writer *w)
+{
+	uring *ring = &w->ring;
+	u32    head = *ring->cq_head;
+	u32    tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+	for (; head != tail; head++) {
+		struct io_uring_cqe *cqe    = &ring->cqes[head & *ring->cq_mask];
+		write_record        *record = (write_record *)(uintptr_t)cqe->user_data;
+
+		if (cqe->res < 0 || (size_t)cqe->res != record->staged.size) {
+			// a short write to a regular file means the disk is full, so let pack_write finish or fail it
+			if (cqe->res < 0) {
+				errno = -cqe->res;
+			}
+			pack_write(w->store, &record->staged);
+		}
+		pack_publish(w->store, &record->staged);
+		w->in_flight_count--;
+		record_done(w, record);
+	}
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+// the io_uring thread, keeping up to URING_RECORDS reports in flight until the writer stops
+static void *
+uring_thread(void *arg)
+{
+	writer *w        = arg;
+	bool    stopping = false;
+
+	while (!stopping || w->in_flight_count > 0) {
+		// take reports while there is room, only blocking when nothing is in flight
+		while (!stopping && w->in_flight_count < URING_RECORDS) {
+			if (w->in_flight_count == 0) {
+				wait_ready(w);
+			} else if (sem_trywait(&w->ready) != 0) {
+				break;
+			}
+			write_record *record = pending_pop(w);
+			if (record == NULL) {
+				stopping = true;
+				break;
+			}
+			uring_prepare(w, record);
+		}
+		if (w->in_flight_count > 0) {
+			uring_enter(&w->ring, 1);
+			uring_reap(w);
+		}
+	}
+	return NULL;
+}
+
+// start a writer, storing its counters in stats
+writer *
+writer_create(writer_backend backend, writer_stats *stats, pack *store)
+{
+	writer *w = calloc(1, sizeof(writer));
+	if (w == NULL) {
+		log_fatal("calloc() failed");
+	}
+	w->stats = stats;
+	w->store = store;
+	for (u64 i = 0; i < WRITER_QUEUE_DEPTH; i++) {
+		w->cells[i].sequence = i;
+	}
+	if (sem_init(&w->ready, 0, 0) != 0) {
+		log_fatal("sem_init() failed");
+	}
+
+	if (backend != WRITER_THREADS) {
+		if (uring_setup(&w->ring, pack_fd(store))) {
+			backend = WRITER_IO_URING;
+		} else {
+			if (backend == WRITER_IO_URING) {
+				log_warn("io_uring is not available, writing with threads instead.");
+			}
+			backend = WRITER_THREADS;
+		}
+	}
+	w->backend      = backend;
+	w->thread_count = backend == WRITER_IO_URING ? 1 : WRITER_THREADS;
+
+	for (u32 i = 0; i < w->thread_count; i++) {
+		if (pthread_create(&w->threads[i], NULL, backend == WRITER_IO_URING ? uring_thread : pool_thread, w) != 0) {
+			log_fatal("pthread_create() failed");
+		}
+	}
+	log_debug("writing reports with %s", backend == WRITER_IO_URING ? "io_uring" : "threads");
+	return w;
+}
+
+// write out every queued report and stop the writer
+void
+writer_destroy(writer *w)
+{
+	for (u32 i = 0; i < w->thread_count; i++) {
+		sem_post(&w->ready);
+	}
+	for (u32 i = 0; i < w->thread_count; i++) {
+		pthread_join(w->threads[i], NULL);
+	}
+	if (w->backend == WRITER_IO_URING) {
+		uring_free(&w->ring);
+	}
+	sem_destroy(&w->ready);
+	free(w);
+}
+
+// wait until every report queued so far is published in the pack, so a checkpoint never gets ahead of it
+void
+writer_flush(writer *w)
+{
+	const struct timespec backoff = {0, WRITER_BACKOFF_NS};
+	while (__atomic_load_n(&w->stats->depth, __ATOMIC_ACQUIRE) > 0) {
+		nanosleep(&backoff, NULL);
+	}
+}
+
+// hand a report to the writer threads, waiting for room if it must not be dropped
+static void
+writer_submit(writer *w, write_record *record, bool wait)
+{
+	// count the report before the writer can finish it
+	__atomic_fetch_add(&w->stats->depth, 1, __ATOMIC_RELAXED);
+	if (!pending_push(w, record)) {
+		if (!wait) {
+			__atomic_fetch_sub(&w->stats->depth, 1, __ATOMIC_RELAXED);
+			__atomic_fetch_add(&w->stats->dropped, 1, __ATOMIC_RELAXED);
+			free(record);
+			return;
+		}
+		__atomic_fetch_add(&w->stats->backpressure, 1, __ATOMIC_RELAXED);
+		const struct timespec backoff = {0, WRITER_BACKOFF_NS};
+		while (!pending_push(w, record)) {
+			nanosleep(&backoff, NULL);
+		}
+	}
+	sem_post(&w->ready);
+}
+
+// report coverage results for non-interesting inputs
+void
+writer_coverage(writer *w, u8 *input, size_t size, u8 *results, size_t results_size)
+{
+	writer_submit(w, record_create(input, size, results, results_size), false);
+}
+
+// report results that we deem interesting
+void
+writer_interesting(writer *w, u8 *input, size_t size, char *reason, u8 *results, size_t results_size)
+{
+	write_record *record = record_create(input, size, results, results_size);
+	record->interesting  = true;
+	strncpy(record->reason, reason, PACK_REASON_SIZE - 1);
+	record->reason[PACK_REASON_SIZE - 1] = '\0';
+	writer_submit(w, record, true);
+}
@@ -0,0 +1,53 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+// DISTRIBUTION STATEMENT A. Approved for public release. Distribution is unlimited.
+//
+// This material is based upon work supported by the Department of the Air Force under Air Force Contract No. FA8702-15-D-0001. Any opinions, findings, conclusions or recommendations expressed in this material are those of the author(s) and do not necessarily reflect the views of the Department of the Air Force.
+//
+// © 2019 Massachusetts Institute of Technology.
+//
+// Subject to FAR52.227-11 Patent Rights - Ownership by the contractor (May 2014)
+//
+// The software/firmware is provided to you on an As-Is basis
+//
+// Delivered to the U.S. Government with Unlimited Rights, as defined in DFARS Part 252.227-7013 or 7014 (Feb 2014). Notwithstanding any copyright notice, U.S. Government rights in this work are defined by DFARS 252.227-7013 or DFARS 252.227-7014 as detailed above. Use of this work other than as specifically authorized by the U.S. Government may violate any copyrights that exist in this work.
+
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/types.h"
+#include "pack.h"
+
+/*
+    The writer saves coverage and interesting inputs to the pack off of the exec loop.
+    Reports are copied into a bounded lock-free queue and written by a background
+    thread, through io_uring when the kernel allows it and a pool of threads otherwise.
+    Coverage reports are dropped when the queue is full, interesting reports wait for room.
+*/
+
+typedef enum writer_backend {
+	WRITER_AUTO,     // io_uring if available, threads otherwise
+	WRITER_IO_URING, // one thread submitting to an io_uring
+	WRITER_THREADS,  // a pool of threads doing plain writes
+} writer_backend;
+
+typedef struct writer_stats {
+	u64 depth;        // reports waiting to be written
+	u64 written;      // reports written, including duplicates
+	u64 duplicate;    // reports the pack already had
+	u64 dropped;      // coverage reports dropped because the queue was full
+	u64 backpressure; // interesting reports that had to wait for room in the queue
+} writer_stats;
+
+typedef struct writer writer;
+
+writer *writer_create(writer_backend backend, writer_stats *stats, pack *store);
+void    writer_destroy(writer *w);
+void    writer_flush(writer *w);
+void    writer_coverage(writer *w, u8 *input, size_t size, u8 *results, size_t results_size);
+void    writer_interesting(writer *w, u8 *input, size_t size, char *reason, u8 *results, size_t results_size);
+
+#endif